@@ -9,6 +9,7 @@
  */
 
 #include "Analyzer.h"
+#include <cmath>
 #include <iostream>
 
  /**
@@ -19,27 +20,133 @@
   * konkretnej wartosci liczbowej (np. import, eksport, produkcja) z obiektu
   * klasy Measurement.
   *
+  * Zachowana dla zgodnosci - w petlach przetwarzajacych wiele pomiarow
+  * nalezy uzywac Measurement::get<Type>(), ktore nie wymaga wywolania
+  * posredniego.
+  *
   * @param type Typ danych, dla ktorego chcemy uzyskac dostep (np. IMPORT, PROD).
   * @return std::function<double(const Measurement&)> Funkcja zwracajaca wartosc pola jako double.
   * W przypadku nieznanego typu zwraca 0.0.
   */
 std::function<double(const Measurement&)> Analyzer::getSelector(DataType type) {
     switch (type) {
-    case DataType::AUTO: return [](const Measurement& m) { return m.autoconsumption; };
-    case DataType::EXPORT: return [](const Measurement& m) { return m.exportEnergy; };
-    case DataType::IMPORT: return [](const Measurement& m) { return m.importEnergy; };
-    case DataType::CONS: return [](const Measurement& m) { return m.consumption; };
-    case DataType::PROD: return [](const Measurement& m) { return m.production; };
-    default: return [](const Measurement& m) { return 0.0; };
+    case DataType::AUTO: return [](const Measurement& m) { return m.get<DataType::AUTO>(); };
+    case DataType::EXPORT: return [](const Measurement& m) { return m.get<DataType::EXPORT>(); };
+    case DataType::IMPORT: return [](const Measurement& m) { return m.get<DataType::IMPORT>(); };
+    case DataType::CONS: return [](const Measurement& m) { return m.get<DataType::CONS>(); };
+    case DataType::PROD: return [](const Measurement& m) { return m.get<DataType::PROD>(); };
+    default: return [](const Measurement&) { return 0.0; };
+    }
+}
+
+/**
+ * @brief Zwraca agregaty przedzialu, korzystajac z pamieci podrecznej LRU.
+ *
+ * Zapamietany wpis jest zwracany, jesli drzewo potwierdza, ze zaden wezel
+ * przedzialu nie zmienil sie od jego obliczenia; w przeciwnym razie jest
+ * usuwany i liczony od nowa (EnergyTree::aggregate). Uzyty wpis trafia
+ * na poczatek listy LRU, a nadmiarowe wpisy sa usuwane z jej konca.
+ *
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @return NodeStats Agregaty przedzialu.
+ */
+NodeStats Analyzer::rangeStats(time_t start, time_t end) {
+    if (cacheCapacity == 0) return tree.aggregate(start, end, pool);
+
+    auto key = std::make_pair(start, end);
+    auto found = cacheIndex.find(key);
+    if (found != cacheIndex.end()) {
+        auto entry = found->second;
+        if (tree.unchangedSince(start, end, entry->epoch)) {
+            lru.splice(lru.begin(), lru, entry);
+            hits++;
+            return entry->stats;
+        }
+        lru.erase(entry);
+        cacheIndex.erase(found);
+    }
+
+    misses++;
+    std::uint64_t epoch = tree.epoch();
+    NodeStats stats = tree.aggregate(start, end, pool);
+    lru.push_front(CacheEntry{ start, end, stats, epoch });
+    cacheIndex[key] = lru.begin();
+    setCacheCapacity(cacheCapacity); // Usuniecie nadmiarowych wpisow
+    return stats;
+}
+
+/**
+ * @brief Ustawia pojemnosc pamieci podrecznej, usuwajac najdawniej uzyte wpisy ponad limit.
+ *
+ * @param capacity Maksymalna liczba wpisow (0 = wylaczona).
+ */
+void Analyzer::setCacheCapacity(std::size_t capacity) {
+    cacheCapacity = capacity;
+    while (lru.size() > cacheCapacity) {
+        cacheIndex.erase(std::make_pair(lru.back().start, lru.back().end));
+        lru.pop_back();
+    }
+}
+
+/**
+ * @brief Usuwa wszystkie wpisy pamieci podrecznej (liczniki trafien pozostaja).
+ */
+void Analyzer::clearCache() {
+    lru.clear();
+    cacheIndex.clear();
+}
+
+/**
+ * @brief Zamienia agregaty przedzialu na zestawienie wszystkich metryk.
+ *
+ * Wskazniki autokonsumpcji i samowystarczalnosci sa liczone jako ilorazy
+ * sum energii (a nie srednia ilorazow z pojedynczych pomiarow), dzieki
+ * czemu okresy bez produkcji nie zaburzaja wyniku.
+ *
+ * @param stats Agregaty przedzialu.
+ * @return Analyzer::Summary Zestawienie metryk.
+ */
+Analyzer::Summary Analyzer::summarize(const NodeStats& stats) {
+    Summary out;
+    out.count = stats.count;
+    if (stats.count == 0) return out;
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const FieldStats& f = stats.fields[i];
+        out.fields[i] = { f.sum, f.sum / stats.count, f.min, f.max };
     }
+    double autoSum = stats.field(DataType::AUTO).sum;
+    double prodSum = stats.field(DataType::PROD).sum;
+    double consSum = stats.field(DataType::CONS).sum;
+    out.selfConsumption = prodSum != 0 ? autoSum / prodSum : 0;
+    out.selfSufficiency = consSum != 0 ? autoSum / consSum : 0;
+    return out;
+}
+
+/**
+ * @brief Oblicza zestawienie wszystkich metryk dla przedzialu w jednym przejsciu.
+ *
+ * Agregaty drzewa zawieraja statystyki wszystkich pieciu pol naraz, wiec
+ * jedno zapytanie EnergyTree::aggregate zastepuje piec osobnych wywolan
+ * getSum/getAvg.
+ *
+ * @param s Data poczatkowa (wlacznie).
+ * @param e Data koncowa (wlacznie).
+ * @return Analyzer::Summary Zestawienie metryk.
+ */
+Analyzer::Summary Analyzer::getSummary(std::tm s, std::tm e) {
+    return summarize(rangeStats(Measurement::toEpoch(s), Measurement::toEpoch(e)));
 }
 
 /**
  * @brief Oblicza sume wartosci wybranego typu w zadanym zakresie dat.
  *
- * Metoda konwertuje struktury std::tm na czas liniowy (time_t), a nastepnie
- * iteruje po elementach drzewa. Sumowane sa wartosci tylko z tych wezlow,
- * ktorych data miesci sie w przedziale [s, e].
+ * Metoda konwertuje struktury std::tm na sekundy od epoki (Measurement::toEpoch), a nastepnie
+ * pobiera z drzewa agregaty przedzialu [s, e]. Wezly w calosci pokryte przez
+ * przedzial nie sa przegladane - wykorzystywane sa ich zapamietane sumy.
+ * Powtorzone zapytanie o niezmieniony przedzial jest obslugiwane z pamieci
+ * podrecznej (rangeStats).
  *
  * @param s Data poczatkowa (wlacznie).
  * @param e Data koncowa (wlacznie).
@@ -47,21 +154,15 @@ std::function<double(const Measurement&)> Analyzer::getSelector(DataType type) {
  * @return double Sumaryczna wartosc energii w watach (W).
  */
 double Analyzer::getSum(std::tm s, std::tm e, DataType type) {
-    double sum = 0;
-    auto sel = getSelector(type);
-    time_t start = mktime(&s), end = mktime(&e);
-    for (auto it = tree.begin(); it != tree.end(); ++it) {
-        time_t cur = it->tmToTime();
-        if (cur >= start && cur <= end) sum += sel(*it);
-    }
-    return sum;
+    time_t start = Measurement::toEpoch(s), end = Measurement::toEpoch(e);
+    return rangeStats(start, end).field(type).sum;
 }
 
 /**
  * @brief Oblicza srednia arytmetyczna wartosci w zadanym zakresie dat.
  *
- * Dziala analogicznie do metody getSum, ale dodatkowo zlicza ilosc
- * rekordow spelniajacych kryterium czasowe.
+ * Dziala analogicznie do metody getSum - suma i liczba rekordow pochodza
+ * z agregatow drzewa dla przedzialu [s, e].
  *
  * @param s Data poczatkowa.
  * @param e Data koncowa.
@@ -69,37 +170,122 @@ double Analyzer::getSum(std::tm s, std::tm e, DataType type) {
  * @return double Srednia wartosc. Jesli brak danych w przedziale, zwraca 0.
  */
 double Analyzer::getAvg(std::tm s, std::tm e, DataType type) {
-    double sum = 0; int count = 0;
-    auto sel = getSelector(type);
-    time_t start = mktime(&s), end = mktime(&e);
-    for (auto it = tree.begin(); it != tree.end(); ++it) {
-        time_t cur = it->tmToTime();
-        if (cur >= start && cur <= end) { sum += sel(*it); count++; }
-    }
-    return count > 0 ? sum / count : 0;
+    time_t start = Measurement::toEpoch(s), end = Measurement::toEpoch(e);
+    NodeStats stats = rangeStats(start, end);
+    return stats.count > 0 ? stats.field(type).sum / stats.count : 0;
 }
 
 /**
- * @brief Wyszukuje i wypisuje rekordy o zadanej wartosci z uwzglednieniem tolerancji.
+ * @brief Odczytuje kwantyl ze szkicu przedzialu.
  *
- * Przeszukuje drzewo w zadanym przedziale czasu. Jesli wartosc wskazanego typu
- * miesci sie w przedziale [val - tol, val + tol], rekord jest wypisywany
- * na standardowe wyjscie (std::cout).
+ * @param s Data poczatkowa (wlacznie).
+ * @param e Data koncowa (wlacznie).
+ * @param type Typ danych.
+ * @param q Rzad kwantyla.
+ * @return double Przyblizona wartosc kwantyla.
+ */
+double Analyzer::getPercentile(std::tm s, std::tm e, DataType type, double q) const {
+    return tree.sketch(type, Measurement::toEpoch(s), Measurement::toEpoch(e)).quantile(q);
+}
+
+/**
+ * @brief Odczytuje kilka kwantyli z jednego szkicu przedzialu.
+ *
+ * @param s Data poczatkowa (wlacznie).
+ * @param e Data koncowa (wlacznie).
+ * @param type Typ danych.
+ * @param qs Rzedy kwantyli.
+ * @return std::vector<double> Przyblizone wartosci kwantyli.
+ */
+std::vector<double> Analyzer::getPercentiles(std::tm s, std::tm e, DataType type, const std::vector<double>& qs) const {
+    QuantileSketch sketch = tree.sketch(type, Measurement::toEpoch(s), Measurement::toEpoch(e));
+    std::vector<double> out;
+    out.reserve(qs.size());
+    for (double q : qs) out.push_back(sketch.quantile(q));
+    return out;
+}
+
+/**
+ * @brief Wybiera najdrobniejsza rozdzielczosc, ktorej szereg miesci sie w budzecie.
+ *
+ * Liczba kubelkow godzinowych i dobowych to liczba pelnych godzin (dob)
+ * dotknietych przez przedzial, a miesiecznych - liczba miesiecy
+ * kalendarzowych; dla danych z przerwami jest to ograniczenie gorne.
+ *
+ * @param s Data poczatkowa.
+ * @param e Data koncowa.
+ * @param maxPoints Maksymalna liczba punktow.
+ * @return Resolution Wybrana rozdzielczosc.
+ */
+Resolution Analyzer::pickResolution(std::tm s, std::tm e, std::size_t maxPoints) {
+    time_t start = Measurement::toEpoch(s), end = Measurement::toEpoch(e);
+    if (start > end || rangeStats(start, end).count <= maxPoints) return Resolution::RAW;
+
+    // Numer kubelka (zaokraglenie w dol rowniez dla czasow ujemnych)
+    auto bucket = [](time_t t, time_t width) { return t / width - (t % width < 0); };
+    if (static_cast<std::size_t>(bucket(end, 3600) - bucket(start, 3600) + 1) <= maxPoints) return Resolution::HOUR;
+    if (static_cast<std::size_t>(bucket(end, 86400) - bucket(start, 86400) + 1) <= maxPoints) return Resolution::DAY;
+    return Resolution::MONTH;
+}
+
+/**
+ * @brief Zwraca szereg zagregowany przedzialu.
+ *
+ * @param s Data poczatkowa.
+ * @param e Data koncowa.
+ * @param res Rozdzielczosc kubelkow.
+ * @return std::vector<SeriesPoint> Punkty szeregu.
+ */
+std::vector<SeriesPoint> Analyzer::getSeries(std::tm s, std::tm e, Resolution res) {
+    return tree.series(Measurement::toEpoch(s), Measurement::toEpoch(e), res);
+}
+
+/**
+ * @brief Zwraca szereg w rozdzielczosci wybranej dla budzetu punktow.
+ *
+ * @param s Data poczatkowa.
+ * @param e Data koncowa.
+ * @param maxPoints Maksymalna liczba punktow.
+ * @return std::vector<SeriesPoint> Punkty szeregu.
+ */
+std::vector<SeriesPoint> Analyzer::getSeries(std::tm s, std::tm e, std::size_t maxPoints) {
+    return getSeries(s, e, pickResolution(s, e, maxPoints));
+}
+
+/**
+ * @brief Wyszukuje rekordy o zadanej wartosci z uwzglednieniem tolerancji.
+ *
+ * Dopasowanie wykonuje EnergyTree::find - wezly, ktorych zakres wartosci
+ * (agregaty min/max) nie przecina [val - tol, val + tol], sa pomijane,
+ * a kolumny wartosci pozostalych blokow sa porownywane z granicami petlami
+ * wektorowymi.
  *
  * @param type Typ danych do sprawdzenia.
  * @param val Szukana wartosc wzorcowa.
  * @param tol Tolerancja (+/-) od wartosci wzorcowej.
  * @param s Data poczatkowa zakresu przeszukiwania.
  * @param e Data koncowa zakresu przeszukiwania.
+ * @return std::vector<Measurement> Znalezione pomiary.
  */
-void Analyzer::search(DataType type, double val, double tol, std::tm s, std::tm e) {
-    auto sel = getSelector(type);
-    time_t start = mktime(&s), end = mktime(&e);
-    for (auto it = tree.begin(); it != tree.end(); ++it) {
-        double v = sel(*it);
-        if (it->tmToTime() >= start && it->tmToTime() <= end && v >= val - tol && v <= val + tol) {
-            std::cout << "Znaleziono: " << v << " W przy dacie " << it->timestamp.tm_mday << "." << it->timestamp.tm_mon + 1 << "\n";
-        }
+std::vector<Measurement> Analyzer::search(DataType type, double val, double tol, std::tm s, std::tm e) {
+    return tree.find(type, val - tol, val + tol, Measurement::toEpoch(s), Measurement::toEpoch(e), pool);
+}
+
+/**
+ * @brief Wypisuje wszystkie pomiary z zadanego zakresu.
+ *
+ * Dla kazdego pomiaru z przedzialu [s, e] wypisuje date oraz piec wartosci
+ * energetycznych w kolejnosci: autokonsumpcja, eksport, import, pobor, produkcja.
+ *
+ * @param s Data poczatkowa.
+ * @param e Data koncowa.
+ */
+void Analyzer::printRange(std::tm s, std::tm e) {
+    for (const Measurement& m : tree.range(s, e)) {
+        std::cout << m.timestamp.tm_mday << "." << m.timestamp.tm_mon + 1 << "." << m.timestamp.tm_year + 1900 << " "
+            << m.timestamp.tm_hour << ":" << (m.timestamp.tm_min < 10 ? "0" : "") << m.timestamp.tm_min << " | "
+            << m.autoconsumption << " " << m.exportEnergy << " " << m.importEnergy << " "
+            << m.consumption << " " << m.production << "\n";
     }
 }
 
@@ -117,7 +303,77 @@ void Analyzer::search(DataType type, double val, double tol, std::tm s, std::tm
  * @param type Typ danych, ktory jest porownywany.
  */
 void Analyzer::compare(std::tm s1, std::tm e1, std::tm s2, std::tm e2, DataType type) {
-    double sum1 = getSum(s1, e1, type);
-    double sum2 = getSum(s2, e2, type);
-    std::cout << "Przedzial 1: " << sum1 << " W, Przedzial 2: " << sum2 << " W. Roznica: " << sum1 - sum2 << " W\n";
+    ComparisonResult r = compareMany({ Comparison{ s1, e1, s2, e2, type } }).front();
+    std::cout << "Przedzial 1: " << r.value << " W, Przedzial 2: " << r.baseline << " W. Roznica: " << r.difference << " W\n";
+}
+
+/**
+ * @brief Wykonuje porownania okresow na agregatach z jednego przejscia po drzewie.
+ *
+ * Kazdy rozny przedzial (para sekund od epoki) dostaje jeden indeks
+ * w zapytaniu EnergyTree::aggregateMany, wiec np. 60 porownan rok do roku
+ * (12 miesiecy x 5 pol) to tylko 24 przedzialy.
+ *
+ * @param items Porownania do wykonania.
+ * @return std::vector<Analyzer::ComparisonResult> Wyniki w kolejnosci porownan.
+ */
+std::vector<Analyzer::ComparisonResult> Analyzer::compareMany(const std::vector<Comparison>& items) const {
+    std::vector<std::pair<time_t, time_t>> ranges;
+    std::map<std::pair<time_t, time_t>, std::size_t> index;
+    auto slot = [&](const std::tm& s, const std::tm& e) {
+        auto range = std::make_pair(Measurement::toEpoch(s), Measurement::toEpoch(e));
+        auto [it, added] = index.emplace(range, ranges.size());
+        if (added) ranges.push_back(range);
+        return it->second;
+    };
+    std::vector<std::pair<std::size_t, std::size_t>> slots;
+    slots.reserve(items.size());
+    for (const Comparison& c : items) {
+        std::size_t current = slot(c.start, c.end);
+        slots.emplace_back(current, slot(c.baseStart, c.baseEnd));
+    }
+
+    std::vector<NodeStats> stats = tree.aggregateMany(ranges);
+    std::vector<ComparisonResult> result(items.size());
+    for (std::size_t i = 0; i < items.size(); i++) {
+        const NodeStats& current = stats[slots[i].first];
+        const NodeStats& base = stats[slots[i].second];
+        ComparisonResult& r = result[i];
+        r.type = items[i].type;
+        r.value = current.field(r.type).sum;
+        r.baseline = base.field(r.type).sum;
+        r.difference = r.value - r.baseline;
+        r.relative = r.baseline != 0 ? r.difference / std::fabs(r.baseline) : 0;
+        r.count = current.count;
+        r.baselineCount = base.count;
+    }
+    return result;
+}
+
+/**
+ * @brief Tworzy porownania miesiecy roku z odpowiadajacymi miesiacami roku poprzedniego.
+ *
+ * Okres miesiaca to [pierwszy dzien 00:00:00, ostatni dzien 23:59:59].
+ *
+ * @param year Rok biezacy.
+ * @return std::vector<Analyzer::Comparison> Porownania dla wszystkich miesiecy i pol.
+ */
+std::vector<Analyzer::Comparison> Analyzer::yearOverYear(int year) {
+    auto monthStart = [](int y, int m) {
+        std::tm t{};
+        t.tm_year = y - 1900 + m / 12;
+        t.tm_mon = m % 12;
+        t.tm_mday = 1;
+        return t;
+    };
+    auto monthEnd = [&](int y, int m) { return Measurement::fromEpoch(Measurement::toEpoch(monthStart(y, m + 1)) - 1); };
+
+    std::vector<Comparison> items;
+    items.reserve(12 * FIELD_COUNT);
+    for (int m = 0; m < 12; m++) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            items.push_back({ monthStart(year, m), monthEnd(year, m), monthStart(year - 1, m), monthEnd(year - 1, m), static_cast<DataType>(f) });
+        }
+    }
+    return items;
 }
\ No newline at end of file
@@ -12,20 +12,9 @@
 
 #include "EnergyTree.h"
 #include <functional>
-
- /**
-  * @brief Typ wyliczeniowy okreslajacy rodzaj danych energetycznych.
-  *
-  * Uzywany do wskazywania, na ktorym polu struktury Measurement ma operowac
-  * dana funkcja analityczna.
-  */
-enum class DataType {
-    AUTO,   /**< Autokonsumpcja */
-    EXPORT, /**< Energia wyeksportowana do sieci */
-    IMPORT, /**< Energia pobrana z sieci */
-    CONS,   /**< Calkowita konsumpcja */
-    PROD    /**< Calkowita produkcja */
-};
+#include <list>
+#include <map>
+#include <utility>
 
 /**
  * @class Analyzer
@@ -41,15 +30,126 @@ class Analyzer {
      * * Analizator nie posiada danych na wlasnosc, lecz operuje na istniejacym
      * obiekcie EnergyTree przekazanym w konstruktorze.
      */
-    EnergyTree& tree;
+    const EnergyTree& tree;
+
+    /**
+     * @brief Pula watkow dla zapytan rownoleglych (nullptr = wykonanie na jednym watku).
+     *
+     * Pula nie jest wlasnoscia analizatora - musi istniec dluzej niz zapytania.
+     */
+    ThreadPool* pool = nullptr;
+
+    /**
+     * @struct CacheEntry
+     * @brief Zapamietany wynik zapytania o agregaty przedzialu.
+     */
+    struct CacheEntry {
+        time_t start;           /**< Poczatek przedzialu (sekundy od epoki). */
+        time_t end;             /**< Koniec przedzialu. */
+        NodeStats stats;        /**< Agregaty wszystkich pol przedzialu. */
+        std::uint64_t epoch;    /**< Numer zapisu drzewa w chwili obliczenia (EnergyTree::epoch). */
+    };
+
+    /** @brief Wpisy pamieci podrecznej od ostatnio do najdawniej uzytego (LRU). */
+    std::list<CacheEntry> lru;
+
+    /** @brief Indeks wpisow wg znormalizowanego przedzialu [start, end]. */
+    std::map<std::pair<time_t, time_t>, std::list<CacheEntry>::iterator> cacheIndex;
+
+    std::size_t cacheCapacity = DEFAULT_CACHE_CAPACITY; /**< Maksymalna liczba wpisow (0 = brak pamieci podrecznej). */
+    std::size_t hits = 0;                               /**< Liczba zapytan obsluzonych z pamieci podrecznej. */
+    std::size_t misses = 0;                             /**< Liczba zapytan policzonych od nowa. */
+
+    /**
+     * @brief Zwraca agregaty przedzialu - z pamieci podrecznej lub z drzewa.
+     *
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie).
+     * @return NodeStats Agregaty przedzialu.
+     */
+    NodeStats rangeStats(time_t start, time_t end);
 
 public:
+    /** @brief Domyslna pojemnosc pamieci podrecznej wynikow (liczba przedzialow). */
+    static constexpr std::size_t DEFAULT_CACHE_CAPACITY = 64;
+
     /**
      * @brief Konstruktor klasy Analyzer.
      *
      * @param t Referencja do istniejacego obiektu EnergyTree z danymi.
+     * @param p Opcjonalna pula watkow wlaczajaca tryb rownolegly (zob. setThreadPool).
+     */
+    Analyzer(const EnergyTree& t, ThreadPool* p = nullptr) : tree(t), pool(p) {}
+
+    /**
+     * @brief Wlacza lub wylacza rownolegle wykonywanie zapytan.
+     *
+     * Z pula watkow zapytania dziela przedzial na miesiace drzewa, ktore sa
+     * przetwarzane na watkach puli, a wyniki czastkowe sa laczone w stalej
+     * (chronologicznej) kolejnosci. Wyniki sa takie same jak bez puli.
+     *
+     * @param p Pula watkow lub nullptr (wykonanie na jednym watku).
+     */
+    void setThreadPool(ThreadPool* p) { pool = p; }
+
+    Analyzer(const Analyzer&) = delete;
+    Analyzer& operator=(const Analyzer&) = delete;
+
+    /**
+     * @brief Ustawia pojemnosc pamieci podrecznej wynikow zapytan.
+     *
+     * getSum, getAvg i getSummary zapamietuja agregaty wszystkich pol dla
+     * przedzialu (klucz: poczatek i koniec w sekundach od epoki), wiec
+     * zapytania o rozne pola tego samego przedzialu korzystaja z jednego
+     * wpisu. Wpis jest aktualny, dopoki zaden wezel roku/miesiaca
+     * przecinajacy przedzial nie zostal zmieniony (EnergyTree::unchangedSince).
+     * Po przekroczeniu pojemnosci usuwany jest najdawniej uzyty wpis.
+     *
+     * @param capacity Maksymalna liczba wpisow; 0 wylacza pamiec podreczna.
      */
-    Analyzer(EnergyTree& t) : tree(t) {}
+    void setCacheCapacity(std::size_t capacity);
+
+    /**
+     * @brief Usuwa wszystkie wpisy pamieci podrecznej.
+     */
+    void clearCache();
+
+    /** @brief Zwraca liczbe zapytan obsluzonych z pamieci podrecznej. */
+    std::size_t cacheHits() const { return hits; }
+
+    /** @brief Zwraca liczbe zapytan policzonych na drzewie. */
+    std::size_t cacheMisses() const { return misses; }
+
+    /**
+     * @struct FieldSummary
+     * @brief Statystyki jednego pola w przedziale.
+     */
+    struct FieldSummary {
+        double sum = 0; /**< Suma wartosci. */
+        double avg = 0; /**< Srednia wartosc. */
+        double min = 0; /**< Najmniejsza wartosc. */
+        double max = 0; /**< Najwieksza wartosc. */
+    };
+
+    /**
+     * @struct Summary
+     * @brief Zestawienie wszystkich metryk przedzialu (wynik getSummary).
+     *
+     * Dla pustego przedzialu wszystkie wartosci sa rowne 0.
+     */
+    struct Summary {
+        std::size_t count = 0;                  /**< Liczba pomiarow. */
+        FieldSummary fields[FIELD_COUNT];       /**< Statystyki pol, indeks = (int)DataType. */
+        double selfConsumption = 0;             /**< Autokonsumpcja / produkcja (udzial zuzytej na miejscu produkcji). */
+        double selfSufficiency = 0;             /**< Autokonsumpcja / pobor (udzial zuzycia pokryty z wlasnej produkcji). */
+
+        /**
+         * @brief Zwraca statystyki wskazanego pola.
+         * @param type Typ danych.
+         * @return const FieldSummary& Statystyki pola.
+         */
+        const FieldSummary& field(DataType type) const { return fields[static_cast<int>(type)]; }
+    };
 
     /**
      * @brief Statyczna metoda pomocnicza wybierajaca pole pomiaru.
@@ -82,20 +182,107 @@ public:
      */
     double getAvg(std::tm s, std::tm e, DataType type);
 
+    /**
+     * @brief Oblicza przyblizony kwantyl (percentyl) wartosci w zadanym przedziale czasu.
+     *
+     * Wynik pochodzi ze szkicow kwantyli wezlow drzewa (EnergyTree::sketch)
+     * i rozni sie od dokladnego co najwyzej o QuantileSketch::RELATIVE_ERROR
+     * wzglednie, bez kopiowania i sortowania wartosci.
+     *
+     * @param s Data poczatkowa przedzialu.
+     * @param e Data koncowa przedzialu.
+     * @param type Typ danych.
+     * @param q Rzad kwantyla z przedzialu [0, 1], np. 0.95 dla P95.
+     * @return double Wartosc kwantyla; 0 dla pustego przedzialu.
+     */
+    double getPercentile(std::tm s, std::tm e, DataType type, double q) const;
+
+    /**
+     * @brief Oblicza kilka kwantyli tego samego pola z jednego szkicu (np. P50, P95, P99).
+     *
+     * @param s Data poczatkowa przedzialu.
+     * @param e Data koncowa przedzialu.
+     * @param type Typ danych.
+     * @param qs Rzedy kwantyli.
+     * @return std::vector<double> Wartosci kwantyli w kolejnosci qs.
+     */
+    std::vector<double> getPercentiles(std::tm s, std::tm e, DataType type, const std::vector<double>& qs) const;
+
+    /**
+     * @brief Oblicza sume, srednia, minimum i maksimum wszystkich pol naraz.
+     *
+     * Wszystkie metryki (wraz ze wskaznikami autokonsumpcji i samowystarczalnosci)
+     * pochodza z jednego przejscia po drzewie.
+     *
+     * @param s Data poczatkowa przedzialu.
+     * @param e Data koncowa przedzialu.
+     * @return Summary Zestawienie metryk.
+     */
+    Summary getSummary(std::tm s, std::tm e);
+
+    /**
+     * @brief Zamienia agregaty (np. z drzewa lub pliku BinaryArchive) na zestawienie metryk.
+     *
+     * @param stats Agregaty przedzialu.
+     * @return Summary Zestawienie metryk.
+     */
+    static Summary summarize(const NodeStats& stats);
+
+    /**
+     * @brief Wybiera rozdzielczosc wykresu mieszczaca sie w budzecie punktow.
+     *
+     * Zaczynajac od pojedynczych pomiarow, przechodzi do coraz wiekszych
+     * kubelkow (godzina, doba, miesiac), az liczba punktow przedzialu nie
+     * przekracza maxPoints. Liczba pomiarow pochodzi z agregatow przedzialu,
+     * a liczba kubelkow z kalendarza, wiec wybor nie przeglada danych.
+     * Gdy nawet szereg miesieczny jest za dlugi, zwracane jest MONTH.
+     *
+     * @param s Data poczatkowa.
+     * @param e Data koncowa.
+     * @param maxPoints Maksymalna liczba punktow szeregu.
+     * @return Resolution Najdrobniejsza rozdzielczosc mieszczaca sie w budzecie.
+     */
+    Resolution pickResolution(std::tm s, std::tm e, std::size_t maxPoints);
+
+    /**
+     * @brief Zwraca szereg zagregowany o zadanej rozdzielczosci (zob. EnergyTree::series).
+     *
+     * @param s Data poczatkowa.
+     * @param e Data koncowa.
+     * @param res Rozdzielczosc kubelkow.
+     * @return std::vector<SeriesPoint> Punkty w porzadku chronologicznym.
+     */
+    std::vector<SeriesPoint> getSeries(std::tm s, std::tm e, Resolution res);
+
+    /**
+     * @brief Zwraca szereg do wykresu z co najwyzej maxPoints punktami.
+     *
+     * Rozdzielczosc jest wybierana przez pickResolution (z wyjatkiem
+     * przypadku, gdy nawet szereg miesieczny przekracza budzet).
+     *
+     * @param s Data poczatkowa.
+     * @param e Data koncowa.
+     * @param maxPoints Maksymalna liczba punktow.
+     * @return std::vector<SeriesPoint> Punkty w porzadku chronologicznym.
+     */
+    std::vector<SeriesPoint> getSeries(std::tm s, std::tm e, std::size_t maxPoints);
+
     /**
      * @brief Wyszukuje pomiary o zadanej wartosci z okreslona tolerancja.
      *
-     * Przeszukuje drzewo w zadanym przedziale czasu i wypisuje na wyjscie
-     * te rekordy, ktorych wartosc wskazanego typu miesci sie w zakresie
-     * [value - tolerance, value + tolerance].
+     * Przeszukuje drzewo w zadanym przedziale czasu i zwraca te rekordy,
+     * ktorych wartosc wskazanego typu miesci sie w zakresie
+     * [value - tolerance, value + tolerance]. Metoda niczego nie wypisuje -
+     * prezentacja wyniku nalezy do wywolujacego.
      *
      * @param type Typ danych do sprawdzenia.
      * @param value Szukana wartosc wzorcowa.
      * @param tolerance Dopuszczalne odchylenie od wartosci wzorcowej.
      * @param s Data poczatkowa przeszukiwania.
      * @param e Data koncowa przeszukiwania.
+     * @return std::vector<Measurement> Znalezione pomiary w porzadku chronologicznym.
      */
-    void search(DataType type, double value, double tolerance, std::tm s, std::tm e);
+    std::vector<Measurement> search(DataType type, double value, double tolerance, std::tm s, std::tm e);
 
     /**
      * @brief Wypisuje wszystkie pomiary z zadanego zakresu.
@@ -118,6 +305,54 @@ public:
      * @param type Typ danych do porownania.
      */
     void compare(std::tm s1, std::tm e1, std::tm s2, std::tm e2, DataType type);
+
+    /**
+     * @struct Comparison
+     * @brief Zadanie porownania: pole w okresie biezacym wzgledem okresu odniesienia.
+     */
+    struct Comparison {
+        std::tm start;          /**< Poczatek okresu biezacego (wlacznie). */
+        std::tm end;            /**< Koniec okresu biezacego (wlacznie). */
+        std::tm baseStart;      /**< Poczatek okresu odniesienia (wlacznie). */
+        std::tm baseEnd;        /**< Koniec okresu odniesienia (wlacznie). */
+        DataType type;          /**< Porownywane pole. */
+    };
+
+    /**
+     * @struct ComparisonResult
+     * @brief Wynik porownania sum pola w dwoch okresach.
+     */
+    struct ComparisonResult {
+        DataType type = DataType::AUTO; /**< Porownywane pole. */
+        double value = 0;               /**< Suma w okresie biezacym. */
+        double baseline = 0;            /**< Suma w okresie odniesienia. */
+        double difference = 0;          /**< Roznica bezwzgledna: value - baseline. */
+        double relative = 0;            /**< Roznica wzgledna: difference / |baseline| (0, gdy baseline == 0). */
+        std::size_t count = 0;          /**< Liczba pomiarow w okresie biezacym. */
+        std::size_t baselineCount = 0;  /**< Liczba pomiarow w okresie odniesienia. */
+    };
+
+    /**
+     * @brief Wykonuje wiele porownan okresow jednym przejsciem po drzewie.
+     *
+     * Rozne przedzialy wszystkich porownan sa zbierane bez powtorzen
+     * i liczone razem przez EnergyTree::aggregateMany, a kazde porownanie
+     * odczytuje sumy swojego pola z agregatow obu przedzialow - porownania
+     * wszystkich pol tych samych okresow kosztuja tyle, co jedno.
+     * Pamiec podreczna Analyzer nie jest uzywana.
+     *
+     * @param items Porownania do wykonania.
+     * @return std::vector<ComparisonResult> Wyniki w kolejnosci porownan.
+     */
+    std::vector<ComparisonResult> compareMany(const std::vector<Comparison>& items) const;
+
+    /**
+     * @brief Tworzy porownania rok do roku: kazdy miesiac roku z tym samym miesiacem roku poprzedniego.
+     *
+     * @param year Rok biezacy.
+     * @return std::vector<Comparison> 12 * FIELD_COUNT porownan (miesiace po kolei, w kazdym wszystkie pola).
+     */
+    static std::vector<Comparison> yearOverYear(int year);
 };
 
 #endif
\ No newline at end of file
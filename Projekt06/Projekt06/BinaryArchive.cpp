@@ -0,0 +1,306 @@
+/**
+ * @file BinaryArchive.cpp
+ * @brief Implementacja zapisu i odczytu pliku danych w formacie v2.
+ *
+ * Plik zawiera zapis drzewa do blokow kolumnowych (bez kompresji lub
+ * kodowanych przez TimeSeriesCodec), weryfikacje struktury odwzorowanego
+ * pliku oraz zapytania i wczytywanie danych bezposrednio z blokow.
+ */
+
+#include "BinaryArchive.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static_assert(sizeof(BinaryArchive::Header) == 64, "Naglowek musi miec staly rozmiar");
+static_assert(sizeof(BinaryArchive::BlockInfo) == 32 + 3 * FIELD_COUNT * sizeof(double), "Wpis indeksu bez wypelnien");
+
+namespace {
+    /**
+     * @brief Bufor jednego bloku zbieranego podczas zapisu.
+     */
+    struct BlockBuffer {
+        std::vector<std::int64_t> times;            /**< Czasy pomiarow. */
+        std::vector<double> values[FIELD_COUNT];    /**< Kolumny wartosci. */
+        BinaryArchive::BlockInfo info;              /**< Agregaty bloku. */
+
+        BlockBuffer() { reset(); }
+
+        /**
+         * @brief Czysci bufor przed zbieraniem kolejnego bloku.
+         */
+        void reset() {
+            times.clear();
+            for (auto& v : values) v.clear();
+            info = {};
+            for (int i = 0; i < FIELD_COUNT; i++) {
+                info.min[i] = std::numeric_limits<double>::infinity();
+                info.max[i] = -std::numeric_limits<double>::infinity();
+            }
+        }
+    };
+
+    /**
+     * @brief Zamienia wpis indeksu na agregaty w postaci NodeStats.
+     * @param info Wpis indeksu bloku.
+     * @return NodeStats Agregaty bloku.
+     */
+    NodeStats blockStats(const BinaryArchive::BlockInfo& info) {
+        NodeStats s;
+        s.count = static_cast<std::size_t>(info.count);
+        s.first = static_cast<time_t>(info.first);
+        s.last = static_cast<time_t>(info.last);
+        for (int i = 0; i < FIELD_COUNT; i++) {
+            s.fields[i].sum = info.sum[i];
+            s.fields[i].min = info.min[i];
+            s.fields[i].max = info.max[i];
+        }
+        return s;
+    }
+}
+
+/**
+ * @brief Zapisuje zawartosc drzewa do pliku w formacie v2.
+ *
+ * Pomiary sa odczytywane iteratorem drzewa (rosnaco wg czasu) i zbierane
+ * w bufor bloku. Pelny blok jest zapisywany kolumnami, a jego opis trafia
+ * do indeksu. Naglowek jest zapisywany najpierw jako miejsce zarezerwowane
+ * i uzupelniany po zapisaniu indeksu, dzieki czemu zapis odbywa sie
+ * w jednym przejsciu bez znajomosci liczby pomiarow z gory.
+ * Blok skompresowany jest dopelniany zerami do wielokrotnosci 8 bajtow,
+ * aby kolejne bloki i indeks pozostaly wyrownane.
+ *
+ * @param tree Drzewo z danymi.
+ * @param filename Sciezka do pliku docelowego.
+ * @param codec Sposob zapisu blokow.
+ * @return bool True, jesli zapis sie powiodl.
+ */
+bool BinaryArchive::write(EnergyTree& tree, const std::string& filename, Codec codec) {
+    std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+    if (!ofs) return false;
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.endianMarker = ENDIAN_MARKER;
+    header.blockRecords = BLOCK_RECORDS;
+    header.codec = static_cast<std::uint32_t>(codec);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<BlockInfo> blocks;
+    BlockBuffer buf;
+    std::uint64_t offset = sizeof(Header);
+    std::vector<std::uint8_t> encoded;
+
+    auto flush = [&]() {
+        if (buf.times.empty()) return;
+        buf.info.offset = offset;
+        buf.info.count = buf.times.size();
+        buf.info.first = buf.times.front();
+        buf.info.last = buf.times.back();
+        if (codec == Codec::GORILLA) {
+            const double* columns[FIELD_COUNT];
+            for (int i = 0; i < FIELD_COUNT; i++) columns[i] = buf.values[i].data();
+            encoded.clear();
+            TimeSeriesCodec::encode(buf.times.data(), columns, buf.times.size(), encoded);
+            encoded.resize((encoded.size() + 7) / 8 * 8, 0);
+            ofs.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+            offset += encoded.size();
+        }
+        else {
+            ofs.write(reinterpret_cast<const char*>(buf.times.data()), buf.times.size() * sizeof(std::int64_t));
+            for (auto& v : buf.values) ofs.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
+            offset += buf.times.size() * (sizeof(std::int64_t) + FIELD_COUNT * sizeof(double));
+        }
+        blocks.push_back(buf.info);
+        buf.reset();
+    };
+
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        buf.times.push_back(static_cast<std::int64_t>(it.time()));
+        for (int i = 0; i < FIELD_COUNT; i++) {
+            double v = it.value(static_cast<DataType>(i));
+            buf.values[i].push_back(v);
+            buf.info.sum[i] += v;
+            if (v < buf.info.min[i]) buf.info.min[i] = v;
+            if (v > buf.info.max[i]) buf.info.max[i] = v;
+        }
+        header.recordCount++;
+        if (buf.times.size() == BLOCK_RECORDS) flush();
+    }
+    flush();
+
+    header.blockCount = blocks.size();
+    header.indexOffset = offset;
+    if (!blocks.empty()) {
+        header.first = blocks.front().first;
+        header.last = blocks.back().last;
+    }
+    ofs.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(BlockInfo));
+
+    // Uzupelnienie naglowka
+    ofs.seekp(0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return static_cast<bool>(ofs);
+}
+
+/**
+ * @brief Sprawdza, czy plik zaczyna sie od sygnatury formatu v2.
+ *
+ * @param filename Sciezka do pliku.
+ * @return bool True dla pliku v2.
+ */
+bool BinaryArchive::isArchive(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    ifs.read(magic, sizeof(magic));
+    return ifs && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**
+ * @brief Odwzorowuje plik w pamieci i sprawdza jego strukture.
+ *
+ * Naglowek i indeks sa czytane bezposrednio z odwzorowania (poczatek
+ * odwzorowania jest wyrownany do strony, a wszystkie sekcje pliku do
+ * 8 bajtow), wiec otwarcie nie kopiuje danych niezaleznie od rozmiaru pliku.
+ *
+ * @param filename Sciezka do pliku.
+ */
+BinaryArchive::BinaryArchive(const std::string& filename) : file(filename) {
+    if (!file.isOpen() || file.size() < sizeof(Header)) return;
+
+    const Header* h = reinterpret_cast<const Header*>(file.data());
+    if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0) return;
+    if (h->version != VERSION || h->endianMarker != ENDIAN_MARKER) return;
+    if (h->codec != static_cast<std::uint32_t>(Codec::RAW) && h->codec != static_cast<std::uint32_t>(Codec::GORILLA)) return;
+
+    // Indeks i bloki musza miescic sie w pliku
+    std::uint64_t size = file.size();
+    if (h->indexOffset % 8 != 0 || h->indexOffset > size) return;
+    if (h->blockCount > (size - h->indexOffset) / sizeof(BlockInfo)) return;
+
+    const BlockInfo* idx = reinterpret_cast<const BlockInfo*>(file.data() + h->indexOffset);
+    std::uint64_t total = 0, previousEnd = sizeof(Header);
+    for (std::uint64_t i = 0; i < h->blockCount; i++) {
+        const BlockInfo& b = idx[i];
+        if (b.count == 0 || b.count > h->blockRecords || b.offset % 8 != 0) return;
+        if (b.offset < previousEnd || b.offset > h->indexOffset) return;
+        // Dlugosc bloku skompresowanego wynika z polozenia nastepnego bloku
+        std::uint64_t bytes = h->codec == static_cast<std::uint32_t>(Codec::RAW)
+            ? b.count * (sizeof(std::int64_t) + FIELD_COUNT * sizeof(double)) : 1;
+        if (bytes > h->indexOffset - b.offset) return;
+        previousEnd = b.offset + bytes;
+        total += b.count;
+    }
+    if (total != h->recordCount) return;
+
+    header = h;
+    index = idx;
+}
+
+/**
+ * @brief Zwraca widok na kolumny wskazanego bloku.
+ *
+ * @param i Numer bloku.
+ * @param scratch Bufor na zdekodowane kolumny (uzywany tylko dla kompresji).
+ * @param view Widok wynikowy.
+ * @return bool False dla uszkodzonego bloku skompresowanego.
+ */
+bool BinaryArchive::block(std::size_t i, Columns& scratch, Block& view) const {
+    view.info = &index[i];
+    const char* base = file.data() + view.info->offset;
+    std::size_t count = static_cast<std::size_t>(view.info->count);
+
+    if (codec() == Codec::RAW) {
+        view.times = reinterpret_cast<const std::int64_t*>(base);
+        const double* col = reinterpret_cast<const double*>(base + count * sizeof(std::int64_t));
+        for (int f = 0; f < FIELD_COUNT; f++) view.values[f] = col + f * count;
+        return true;
+    }
+
+    std::uint64_t next = i + 1 < blockCount() ? index[i + 1].offset : header->indexOffset;
+    scratch.times.resize(count);
+    double* columns[FIELD_COUNT];
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        scratch.values[f].resize(count);
+        columns[f] = scratch.values[f].data();
+        view.values[f] = columns[f];
+    }
+    view.times = scratch.times.data();
+    return TimeSeriesCodec::decode(reinterpret_cast<const std::uint8_t*>(base), static_cast<std::size_t>(next - view.info->offset),
+        count, scratch.times.data(), columns);
+}
+
+/**
+ * @brief Wylicza agregaty pomiarow z przedzialu [start, end] bezposrednio z pliku.
+ *
+ * Pierwszy blok przecinajacy przedzial jest wyszukiwany binarnie w indeksie.
+ * Kolejne bloki w calosci zawarte w przedziale sa dolaczane z indeksu,
+ * a w blokach brzegowych zakres pomiarow jest wyznaczany wyszukiwaniem
+ * binarnym w kolumnie czasow i agregowany petla wektorowa (SimdKernels::stats).
+ *
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @return NodeStats Agregaty pomiarow z przedzialu.
+ */
+NodeStats BinaryArchive::aggregate(time_t start, time_t end) const {
+    NodeStats result;
+    if (!header || start > end) return result;
+
+    Columns scratch;
+    const BlockInfo* blocksEnd = index + header->blockCount;
+    const BlockInfo* b = std::partition_point(index, blocksEnd,
+        [start](const BlockInfo& info) { return info.last < start; });
+
+    for (; b != blocksEnd && b->first <= end; ++b) {
+        if (b->first >= start && b->last <= end) {
+            result.merge(blockStats(*b));
+            continue;
+        }
+        Block view;
+        if (!block(static_cast<std::size_t>(b - index), scratch, view)) continue;
+        const std::int64_t* lo = std::lower_bound(view.times, view.times + view.size(), static_cast<std::int64_t>(start));
+        const std::int64_t* hi = std::upper_bound(lo, view.times + view.size(), static_cast<std::int64_t>(end));
+        if (lo == hi) continue;
+        std::size_t k = static_cast<std::size_t>(lo - view.times), n = static_cast<std::size_t>(hi - lo);
+        result.addTimes(static_cast<time_t>(*lo), static_cast<time_t>(hi[-1]), n);
+        for (int f = 0; f < FIELD_COUNT; f++) SimdKernels::stats(view.values[f] + k, n, result.fields[f]);
+    }
+    return result;
+}
+
+/**
+ * @brief Dodaje wszystkie pomiary z pliku do drzewa.
+ *
+ * Kazdy blok (w razie potrzeby zdekodowany) jest zamieniany na paczke
+ * obiektow Measurement (data odtwarzana arytmetycznie przez
+ * Measurement::fromEpoch) i przekazywany do EnergyTree::bulkLoad.
+ * Bufory paczki i kolumn sa wspolne dla wszystkich blokow. Wczytywanie
+ * zatrzymuje sie na pierwszym uszkodzonym bloku.
+ *
+ * @param tree Drzewo docelowe.
+ * @return std::size_t Liczba dodanych pomiarow.
+ */
+std::size_t BinaryArchive::loadInto(EnergyTree& tree) const {
+    std::size_t added = 0;
+    std::vector<Measurement> batch;
+    Columns scratch;
+    for (std::size_t i = 0; i < blockCount(); i++) {
+        Block view;
+        if (!block(i, scratch, view)) break;
+        batch.resize(view.size());
+        for (std::size_t k = 0; k < view.size(); k++) {
+            Measurement& m = batch[k];
+            m.setEpoch(static_cast<time_t>(view.times[k]));
+            m.autoconsumption = view.values[static_cast<int>(DataType::AUTO)][k];
+            m.exportEnergy = view.values[static_cast<int>(DataType::EXPORT)][k];
+            m.importEnergy = view.values[static_cast<int>(DataType::IMPORT)][k];
+            m.consumption = view.values[static_cast<int>(DataType::CONS)][k];
+            m.production = view.values[static_cast<int>(DataType::PROD)][k];
+        }
+        added += tree.bulkLoad(batch);
+    }
+    return added;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file BinaryArchive.h
+ * @brief Definicja wersjonowanego formatu binarnego (v2) pliku z danymi.
+ *
+ * Plik naglowkowy zawierajacy klase BinaryArchive, ktora zapisuje zawartosc
+ * drzewa do pliku w formacie kolumnowym oraz udostepnia taki plik przez
+ * odwzorowanie w pamieci (MappedFile). Zapytania moga byc obslugiwane
+ * bezposrednio z pliku, bez budowania drzewa. Bloki moga byc zapisane
+ * bez kompresji albo skompresowane (TimeSeriesCodec).
+ */
+
+#ifndef BINARYARCHIVE_H
+#define BINARYARCHIVE_H
+
+#include "EnergyTree.h"
+#include "MappedFile.h"
+#include "TimeSeriesCodec.h"
+#include <cstdint>
+#include <string>
+
+ /**
+  * @class BinaryArchive
+  * @brief Plik danych w formacie v2: naglowek, bloki kolumnowe i indeks blokow.
+  *
+  * Uklad pliku (wszystkie pola wyrownane do 8 bajtow):
+  * - Header (64 bajty): sygnatura, wersja, znacznik kolejnosci bajtow,
+  *   liczba pomiarow i blokow, polozenie indeksu, zakres czasu.
+  * - Bloki danych: do BLOCK_RECORDS pomiarow posortowanych wg czasu,
+  *   zapisanych kolumnowo - tablica czasow (int64, sekundy od epoki
+  *   w sensie Measurement::toEpoch), a po niej piec tablic double
+  *   w kolejnosci DataType. Przy kodeku Codec::GORILLA blok jest
+  *   strumieniem TimeSeriesCodec dopelnionym do 8 bajtow; jego dlugosc
+  *   wynika z polozenia nastepnego bloku (lub indeksu).
+  * - Indeks (na koncu pliku): dla kazdego bloku polozenie, liczba pomiarow,
+  *   zakres czasu oraz suma/minimum/maksimum kazdego pola.
+  *
+  * Liczby zapisywane sa w kolejnosci bajtow little-endian (natywnej dla
+  * obslugiwanych platform); plik z inna kolejnoscia jest odrzucany przy
+  * otwarciu na podstawie znacznika ENDIAN_MARKER.
+  */
+class BinaryArchive {
+public:
+    /** @brief Sygnatura pliku v2. */
+    static constexpr char MAGIC[8] = { 'P', '0', '6', 'D', 'A', 'T', 'A', '\0' };
+    /** @brief Wersja formatu. */
+    static constexpr std::uint32_t VERSION = 2;
+    /** @brief Wartosc zapisana natywnie - po odczycie pozwala wykryc inna kolejnosc bajtow. */
+    static constexpr std::uint32_t ENDIAN_MARKER = 0x01020304;
+    /** @brief Maksymalna liczba pomiarow w jednym bloku. */
+    static constexpr std::uint32_t BLOCK_RECORDS = 4096;
+
+    /**
+     * @brief Sposob zapisu blokow danych.
+     */
+    enum class Codec : std::uint32_t {
+        RAW = 0,    /**< Kolumny bez kompresji (dostepne bezposrednio z odwzorowania). */
+        GORILLA = 1 /**< Czasy delta-of-delta, wartosci XOR (TimeSeriesCodec). */
+    };
+
+    /**
+     * @struct Header
+     * @brief Naglowek pliku (poczatek pliku).
+     */
+    struct Header {
+        char magic[8];                  /**< Sygnatura MAGIC. */
+        std::uint32_t version;          /**< Wersja formatu (VERSION). */
+        std::uint32_t endianMarker;     /**< ENDIAN_MARKER zapisany w kolejnosci bajtow zapisujacego. */
+        std::uint64_t recordCount;      /**< Liczba pomiarow w pliku. */
+        std::uint64_t blockCount;       /**< Liczba blokow. */
+        std::uint64_t indexOffset;      /**< Polozenie indeksu blokow (bajty od poczatku pliku). */
+        std::int64_t first;             /**< Czas najwczesniejszego pomiaru. */
+        std::int64_t last;              /**< Czas najpozniejszego pomiaru. */
+        std::uint32_t blockRecords;     /**< Pojemnosc bloku uzyta przy zapisie. */
+        std::uint32_t codec;            /**< Kodek blokow (Codec); 0 = bez kompresji. */
+    };
+
+    /**
+     * @struct BlockInfo
+     * @brief Wpis indeksu opisujacy jeden blok danych.
+     */
+    struct BlockInfo {
+        std::uint64_t offset;           /**< Polozenie danych bloku (bajty od poczatku pliku). */
+        std::uint64_t count;            /**< Liczba pomiarow w bloku. */
+        std::int64_t first;             /**< Czas pierwszego pomiaru bloku. */
+        std::int64_t last;              /**< Czas ostatniego pomiaru bloku. */
+        double sum[FIELD_COUNT];        /**< Sumy pol, indeks = (int)DataType. */
+        double min[FIELD_COUNT];        /**< Minima pol. */
+        double max[FIELD_COUNT];        /**< Maksima pol. */
+    };
+
+    /**
+     * @struct Columns
+     * @brief Bufor na zdekodowane kolumny bloku skompresowanego.
+     *
+     * Przekazywany do block() - przy wielu wywolaniach pamiec jest
+     * wykorzystywana ponownie.
+     */
+    struct Columns {
+        std::vector<std::int64_t> times;            /**< Czasy pomiarow. */
+        std::vector<double> values[FIELD_COUNT];    /**< Kolumny wartosci. */
+    };
+
+    /**
+     * @struct Block
+     * @brief Widok na kolumny jednego bloku (w odwzorowanym pliku lub w buforze Columns).
+     */
+    struct Block {
+        const BlockInfo* info;                  /**< Wpis indeksu bloku. */
+        const std::int64_t* times;              /**< Czasy pomiarow (rosnaco). */
+        const double* values[FIELD_COUNT];      /**< Kolumny wartosci, indeks = (int)DataType. */
+
+        /**
+         * @brief Zwraca liczbe pomiarow w bloku.
+         * @return std::size_t Liczba pomiarow.
+         */
+        std::size_t size() const { return static_cast<std::size_t>(info->count); }
+    };
+
+    /**
+     * @brief Zapisuje zawartosc drzewa do pliku w formacie v2.
+     *
+     * @param tree Drzewo z danymi.
+     * @param filename Sciezka do pliku docelowego.
+     * @param codec Sposob zapisu blokow.
+     * @return bool True, jesli zapis sie powiodl.
+     */
+    static bool write(EnergyTree& tree, const std::string& filename, Codec codec = Codec::RAW);
+
+    /**
+     * @brief Sprawdza, czy plik zaczyna sie od sygnatury formatu v2.
+     *
+     * @param filename Sciezka do pliku.
+     * @return bool True dla pliku v2; false dla starego formatu lub braku pliku.
+     */
+    static bool isArchive(const std::string& filename);
+
+    /**
+     * @brief Odwzorowuje plik w pamieci i sprawdza jego strukture.
+     *
+     * Sprawdzane sa: sygnatura, wersja, kolejnosc bajtow oraz to, czy indeks
+     * i wszystkie bloki mieszcza sie w pliku. Przy bledzie isValid() zwraca false.
+     *
+     * @param filename Sciezka do pliku.
+     */
+    explicit BinaryArchive(const std::string& filename);
+
+    /**
+     * @brief Sprawdza, czy plik zostal poprawnie otwarty i zweryfikowany.
+     * @return bool True dla poprawnego pliku v2.
+     */
+    bool isValid() const { return header != nullptr; }
+
+    /**
+     * @brief Zwraca liczbe pomiarow w pliku.
+     * @return std::size_t Liczba pomiarow.
+     */
+    std::size_t size() const { return header ? static_cast<std::size_t>(header->recordCount) : 0; }
+
+    /**
+     * @brief Zwraca liczbe blokow w pliku.
+     * @return std::size_t Liczba blokow.
+     */
+    std::size_t blockCount() const { return header ? static_cast<std::size_t>(header->blockCount) : 0; }
+
+    /**
+     * @brief Zwraca rozmiar pliku w bajtach.
+     * @return std::size_t Rozmiar odwzorowanego pliku.
+     */
+    std::size_t fileSize() const { return file.size(); }
+
+    /**
+     * @brief Zwraca kodek blokow pliku.
+     * @return Codec Sposob zapisu blokow.
+     */
+    Codec codec() const { return header ? static_cast<Codec>(header->codec) : Codec::RAW; }
+
+    /**
+     * @brief Zwraca widok na kolumny wskazanego bloku.
+     *
+     * Blok bez kompresji jest widokiem bezposrednio na odwzorowany plik;
+     * blok skompresowany jest dekodowany do bufora scratch.
+     *
+     * @param i Numer bloku (0 .. blockCount()-1).
+     * @param scratch Bufor na zdekodowane kolumny.
+     * @param view Widok wynikowy.
+     * @return bool False, jesli blok skompresowany jest uszkodzony.
+     */
+    bool block(std::size_t i, Columns& scratch, Block& view) const;
+
+    /**
+     * @brief Wylicza agregaty pomiarow z przedzialu [start, end] bezposrednio z pliku.
+     *
+     * Bloki w calosci zawarte w przedziale sa uwzgledniane przez agregaty
+     * z indeksu, a tylko bloki brzegowe sa przegladane pomiar po pomiarze
+     * (uszkodzony blok skompresowany jest pomijany).
+     *
+     * @param start Poczatek przedzialu (sekundy od epoki, wlacznie).
+     * @param end Koniec przedzialu (sekundy od epoki, wlacznie).
+     * @return NodeStats Agregaty pomiarow z przedzialu.
+     */
+    NodeStats aggregate(time_t start, time_t end) const;
+
+    /**
+     * @brief Dodaje wszystkie pomiary z pliku do drzewa.
+     *
+     * Bloki sa przekazywane kolejno do EnergyTree::bulkLoad, bez parsowania
+     * i bez posredniego strumienia.
+     *
+     * @param tree Drzewo docelowe.
+     * @return std::size_t Liczba dodanych pomiarow.
+     */
+    std::size_t loadInto(EnergyTree& tree) const;
+
+private:
+    MappedFile file;                    /**< Odwzorowany plik. */
+    const Header* header = nullptr;     /**< Naglowek (nullptr dla niepoprawnego pliku). */
+    const BlockInfo* index = nullptr;   /**< Indeks blokow. */
+};
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file CsvFollower.cpp
+ * @brief Implementacja przyrostowego wczytywania rosnacego pliku CSV.
+ *
+ * Plik zawiera odczyt dopisanych fragmentow pliku (od zapamietanego
+ * przesuniecia, paczkami po CHUNK_BYTES), parsowanie kompletnych linii
+ * przez CsvParser oraz petle odpytujaca plik w zadanych odstepach.
+ */
+
+#include "CsvFollower.h"
+#include "CsvParser.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+/**
+ * @brief Wczytuje kompletne linie dopisane do pliku od poprzedniego wywolania.
+ *
+ * Plik jest otwierany przy kazdym wywolaniu (eksporter moze go w miedzyczasie
+ * zamknac lub zastapic). Dane od przesuniecia sa czytane paczkami; z kazdej
+ * paczki przetwarzany jest fragment do ostatniego znaku '\n', a niepelna
+ * linia na koncu jest czytana ponownie w kolejnej paczce lub przy kolejnym
+ * wywolaniu. Linia dluzsza niz CHUNK_BYTES jest odrzucana jako bledna.
+ *
+ * @param tree Drzewo, do ktorego dodawane sa pomiary.
+ * @return std::size_t Liczba dodanych pomiarow.
+ */
+std::size_t CsvFollower::poll(EnergyTree& tree) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) return 0;
+    in.seekg(0, std::ios::end);
+    std::uint64_t size = static_cast<std::uint64_t>(in.tellg());
+    if (size < offset) reset(); // Plik skrocony lub zastapiony - od poczatku
+
+    std::size_t added = 0;
+    Measurement m;
+    while (offset < size) {
+        std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(size - offset, CHUNK_BYTES));
+        buffer.resize(want);
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(buffer.data(), static_cast<std::streamsize>(want));
+        std::size_t got = static_cast<std::size_t>(in.gcount());
+        if (got == 0) break;
+
+        std::string_view data(buffer.data(), got);
+        std::size_t complete = data.rfind('\n');
+        if (complete == std::string_view::npos) {
+            if (got < CHUNK_BYTES) break; // Linia w trakcie zapisu
+            invalid++;                    // Linia dluzsza niz paczka - pomijana
+            offset += got;
+            continue;
+        }
+        data = data.substr(0, complete + 1);
+
+        Metrics::add(Metrics::Counter::BYTES_READ, data.size());
+        std::size_t pos = 0;
+        if (!headerDone) {
+            if (data.substr(0, 3) == "\xEF\xBB\xBF") pos = 3;
+            sep = CsvParser::detectSeparator(CsvParser::nextLine(data, pos));
+            headerDone = true;
+        }
+        while (pos < data.size()) {
+            std::string_view line = CsvParser::nextLine(data, pos);
+            const char* error = line.empty() ? nullptr : CsvParser::parseLine(line, sep, m);
+            if (line.empty() || error) {
+                invalid++;
+                Metrics::add(Metrics::Counter::CSV_LINES_REJECTED);
+                if (error) Metrics::reject(error, 1);
+            }
+            else if (tree.addMeasurement(m)) {
+                valid++; added++;
+                Metrics::add(Metrics::Counter::CSV_LINES_OK);
+            }
+            else duplicates++;
+        }
+        offset += data.size();
+    }
+    return added;
+}
+
+/**
+ * @brief Odpytuje plik w petli az do zakonczenia przez funkcje running.
+ *
+ * @param tree Drzewo, do ktorego dodawane sa pomiary.
+ * @param interval Odstep miedzy sprawdzeniami.
+ * @param running Warunek kontynuacji sprawdzany przed kazdym obiegiem.
+ * @return std::size_t Laczna liczba dodanych pomiarow.
+ */
+std::size_t CsvFollower::follow(EnergyTree& tree, std::chrono::milliseconds interval, const std::function<bool()>& running) {
+    std::size_t added = 0;
+    while (running()) {
+        added += poll(tree);
+        std::this_thread::sleep_for(interval);
+    }
+    return added;
+}
+
+/**
+ * @brief Zeruje przesuniecie - plik zostanie przeczytany od poczatku (wraz z naglowkiem).
+ *
+ * Liczniki pomiarow nie sa zerowane.
+ */
+void CsvFollower::reset() {
+    offset = 0;
+    headerDone = false;
+    sep = ',';
+}
+
+/**
+ * @brief Przeskakuje dane wczytane juz do drzewa (naglowek uznaje sie za pominiety).
+ *
+ * @param position Liczba przetworzonych bajtow pliku.
+ * @param separator Separator kolumn pliku.
+ */
+void CsvFollower::seek(std::uint64_t position, char separator) {
+    reset();
+    if (position == 0) return;
+    offset = position;
+    headerDone = true;
+    sep = separator;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file CsvFollower.h
+ * @brief Definicja przyrostowego wczytywania rosnacego pliku CSV (tryb "tail -f").
+ *
+ * Plik naglowkowy zawierajacy klase CsvFollower, ktora zapamietuje, ile
+ * bajtow pliku eksportu zostalo juz przetworzonych, i przy kolejnym
+ * sprawdzeniu parsuje wylacznie nowo dopisane, kompletne linie.
+ */
+
+#ifndef CSVFOLLOWER_H
+#define CSVFOLLOWER_H
+
+#include "EnergyTree.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+ /**
+  * @class CsvFollower
+  * @brief Sledzenie pliku CSV dopisywanego przez eksporter falownika.
+  *
+  * Kazde wywolanie poll() czyta plik od zapamietanego przesuniecia do konca,
+  * przetwarza kompletne linie (zakonczone znakiem '\n') i przesuwa
+  * przesuniecie za ostatnia z nich - linia w trakcie zapisu zostanie
+  * wczytana przy nastepnym sprawdzeniu. Pierwsze wywolanie pomija znacznik
+  * BOM i naglowek (wykrywajac separator), a pozostale pracuja tylko na
+  * dopisanych bajtach, wiec ich koszt zalezy od ilosci nowych danych,
+  * a nie od rozmiaru pliku. Pomiary sa dodawane przez
+  * EnergyTree::addMeasurement, ktore na biezaco aktualizuje agregaty wezlow.
+  * Plik krotszy niz zapamietane przesuniecie (np. zastapiony nowym
+  * eksportem) jest czytany ponownie od poczatku. Zmiany sa wykrywane
+  * odpytywaniem (follow), co dziala tak samo na Windows i w systemach POSIX.
+  */
+class CsvFollower {
+    std::string filename;           /**< Sciezka do sledzonego pliku. */
+    std::uint64_t offset = 0;       /**< Liczba przetworzonych bajtow pliku (zawsze na granicy linii). */
+    bool headerDone = false;        /**< Czy naglowek zostal juz pominiety. */
+    char sep = ',';                 /**< Separator kolumn wykryty z naglowka. */
+    std::size_t valid = 0;          /**< Liczba dodanych pomiarow. */
+    std::size_t invalid = 0;        /**< Liczba linii odrzuconych przez parser (lub pustych). */
+    std::size_t duplicates = 0;     /**< Liczba pomiarow juz obecnych w drzewie. */
+    std::string buffer;             /**< Bufor odczytu (wielokrotnego uzytku). */
+
+public:
+    /** @brief Maksymalna liczba bajtow czytanych z pliku naraz. */
+    static constexpr std::size_t CHUNK_BYTES = 4 << 20;
+
+    /**
+     * @brief Tworzy obiekt sledzacy plik (od jego poczatku).
+     * @param file Sciezka do pliku CSV.
+     */
+    explicit CsvFollower(std::string file) : filename(std::move(file)) {}
+
+    /**
+     * @brief Wczytuje nowe kompletne linie dopisane od poprzedniego wywolania.
+     *
+     * @param tree Drzewo, do ktorego dodawane sa pomiary.
+     * @return std::size_t Liczba dodanych pomiarow (0, gdy nic sie nie zmienilo lub pliku brak).
+     */
+    std::size_t poll(EnergyTree& tree);
+
+    /**
+     * @brief Sledzi plik, wywolujac poll() co zadany odstep czasu.
+     *
+     * @param tree Drzewo, do ktorego dodawane sa pomiary.
+     * @param interval Odstep miedzy kolejnymi sprawdzeniami pliku.
+     * @param running Funkcja sprawdzana przed kazdym obiegiem; false konczy sledzenie.
+     * @return std::size_t Laczna liczba dodanych pomiarow.
+     */
+    std::size_t follow(EnergyTree& tree, std::chrono::milliseconds interval, const std::function<bool()>& running);
+
+    /**
+     * @brief Wraca na poczatek pliku (przy nastepnym poll() naglowek jest czytany od nowa).
+     */
+    void reset();
+
+    /**
+     * @brief Ustawia przesuniecie za danymi wczytanymi juz innym sposobem (np. FileManager::loadCSV).
+     *
+     * Kolejne poll() czyta tylko linie dopisane za position. Przesuniecie 0
+     * dziala jak reset().
+     *
+     * @param position Liczba przetworzonych bajtow pliku (granica linii, za naglowkiem).
+     * @param separator Separator kolumn pliku.
+     */
+    void seek(std::uint64_t position, char separator);
+
+    /** @brief Zwraca liczbe przetworzonych bajtow pliku. */
+    std::uint64_t position() const { return offset; }
+
+    /** @brief Zwraca liczbe dodanych pomiarow. */
+    std::size_t validCount() const { return valid; }
+
+    /** @brief Zwraca liczbe odrzuconych linii (bledy parsowania i puste linie). */
+    std::size_t invalidCount() const { return invalid; }
+
+    /** @brief Zwraca liczbe pomiarow pominietych jako duplikaty. */
+    std::size_t duplicateCount() const { return duplicates; }
+};
+
+#endif
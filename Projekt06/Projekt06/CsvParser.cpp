@@ -0,0 +1,210 @@
+/**
+ * @file CsvParser.cpp
+ * @brief Implementacja parsera linii CSV dzialajacego bez alokacji pamieci.
+ *
+ * Plik zawiera podzial linii na pola z obsluga cudzyslowow, skaner daty
+ * w formacie "DD.MM.RRRR G:MM" oraz konwersje liczb przez std::from_chars.
+ * Wszystkie funkcje operuja na widokach (std::string_view) wskazujacych
+ * na oryginalny bufor pliku.
+ */
+
+#include "CsvParser.h"
+#include <charconv>
+#include <cstring>
+
+namespace {
+    /**
+     * @brief Usuwa biale znaki z poczatku i konca widoku.
+     * @param text Widok wejsciowy.
+     * @return std::string_view Widok bez otaczajacych spacji i tabulatorow.
+     */
+    std::string_view trim(std::string_view text) {
+        std::size_t b = 0, e = text.size();
+        while (b < e && (text[b] == ' ' || text[b] == '\t')) b++;
+        while (e > b && (text[e - 1] == ' ' || text[e - 1] == '\t')) e--;
+        return text.substr(b, e - b);
+    }
+
+    /**
+     * @brief Wczytuje liczbe calkowita o co najwyzej maxDigits cyfrach.
+     *
+     * @param p Biezaca pozycja (przesuwana za wczytane cyfry).
+     * @param end Koniec tekstu.
+     * @param maxDigits Maksymalna liczba cyfr.
+     * @param value Wartosc wynikowa.
+     * @return bool True, jesli wczytano co najmniej jedna cyfre.
+     */
+    bool scanInt(const char*& p, const char* end, int maxDigits, int& value) {
+        int digits = 0;
+        value = 0;
+        while (p < end && digits < maxDigits && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            p++; digits++;
+        }
+        return digits > 0;
+    }
+
+    /**
+     * @brief Pomija oczekiwany znak.
+     * @return bool True, jesli na pozycji p byl znak c.
+     */
+    bool scanChar(const char*& p, const char* end, char c) {
+        if (p < end && *p == c) { p++; return true; }
+        return false;
+    }
+}
+
+/**
+ * @brief Wykrywa separator kolumn na podstawie wiersza naglowka.
+ *
+ * Eksport Chart_Export.csv uzywa przecinka, starsze pliki - srednika.
+ *
+ * @param header Pierwsza linia pliku.
+ * @return char Wykryty separator.
+ */
+char CsvParser::detectSeparator(std::string_view header) {
+    return header.find(';') != std::string_view::npos ? ';' : ',';
+}
+
+/**
+ * @brief Pobiera kolejna linie z bufora.
+ *
+ * @param data Caly bufor.
+ * @param pos Pozycja poczatku linii (przesuwana na poczatek nastepnej).
+ * @return std::string_view Linia bez znakow konca linii.
+ */
+std::string_view CsvParser::nextLine(std::string_view data, std::size_t& pos) {
+    std::size_t start = pos;
+    const void* nl = std::memchr(data.data() + start, '\n', data.size() - start);
+    std::size_t stop = nl ? static_cast<const char*>(nl) - data.data() : data.size();
+    pos = nl ? stop + 1 : data.size();
+    if (stop > start && data[stop - 1] == '\r') stop--;
+    return data.substr(start, stop - start);
+}
+
+/**
+ * @brief Parsuje date w formacie "DD.MM.RRRR G:MM[:SS]".
+ *
+ * Dzien, miesiac i godzina moga miec jedna lub dwie cyfry. Sprawdzane sa
+ * zakresy pol (miesiac 1-12, dzien 1-31, godzina 0-23, minuta i sekunda 0-59).
+ *
+ * @param text Tekst daty.
+ * @param out Data wynikowa.
+ * @return bool True, jesli data jest poprawna.
+ */
+bool CsvParser::parseDate(std::string_view text, std::tm& out) {
+    text = trim(text);
+    const char* p = text.data();
+    const char* end = p + text.size();
+    int day, month, year, hour, minute, second = 0;
+
+    if (!scanInt(p, end, 2, day) || !scanChar(p, end, '.')) return false;
+    if (!scanInt(p, end, 2, month) || !scanChar(p, end, '.')) return false;
+    if (!scanInt(p, end, 4, year)) return false;
+    if (!scanChar(p, end, ' ')) return false;
+    while (scanChar(p, end, ' ')) {}
+    if (!scanInt(p, end, 2, hour) || !scanChar(p, end, ':')) return false;
+    if (!scanInt(p, end, 2, minute)) return false;
+    if (scanChar(p, end, ':') && !scanInt(p, end, 2, second)) return false;
+    if (p != end) return false;
+
+    if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+    if (hour > 23 || minute > 59 || second > 59) return false;
+
+    out = {};
+    out.tm_mday = day;
+    out.tm_mon = month - 1;   // Miesiace 0-11
+    out.tm_year = year - 1900; // Lata od 1900
+    out.tm_hour = hour;
+    out.tm_min = minute;
+    out.tm_sec = second;
+    out.tm_isdst = -1;
+    return true;
+}
+
+/**
+ * @brief Parsuje liczbe zmiennoprzecinkowa przez std::from_chars.
+ *
+ * Jesli konwersja zatrzyma sie na przecinku dziesietnym, tekst jest
+ * kopiowany do bufora na stosie z zamiana przecinka na kropke.
+ *
+ * @param text Tekst liczby.
+ * @param out Wartosc wynikowa.
+ * @return bool True, jesli caly tekst jest poprawna liczba.
+ */
+bool CsvParser::parseNumber(std::string_view text, double& out) {
+    text = trim(text);
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (first == last) return false;
+
+    auto res = std::from_chars(first, last, out);
+    if (res.ec == std::errc() && res.ptr == last) return true;
+
+    // Przecinek dziesietny (np. "406,8323" w plikach rozdzielanych srednikami)
+    if (res.ptr != last && *res.ptr == ',') {
+        char buf[64];
+        if (text.size() >= sizeof(buf)) return false;
+        for (std::size_t i = 0; i < text.size(); i++) buf[i] = text[i] == ',' ? '.' : text[i];
+        res = std::from_chars(buf, buf + text.size(), out);
+        return res.ec == std::errc() && res.ptr == buf + text.size();
+    }
+    return false;
+}
+
+/**
+ * @brief Parsuje pojedyncza linie danych.
+ *
+ * Pole zaczynajace sie od cudzyslowu konczy sie na zamykajacym cudzyslowie
+ * (podwojony cudzyslow "" jest traktowany jako znak w tresci pola), dzieki
+ * czemu separator wewnatrz cudzyslowow nie dzieli pola.
+ *
+ * @param line Linia danych.
+ * @param sep Separator kolumn.
+ * @param out Pomiar wynikowy.
+ * @return const char* nullptr dla poprawnej linii, w przeciwnym razie opis bledu.
+ */
+const char* CsvParser::parseLine(std::string_view line, char sep, Measurement& out) {
+    constexpr int COLUMNS = 1 + FIELD_COUNT;
+    std::string_view fields[COLUMNS];
+    int count = 0;
+    std::size_t i = 0;
+
+    while (count < COLUMNS) {
+        std::size_t next;
+        if (i < line.size() && line[i] == '"') {
+            // Pole w cudzyslowach
+            std::size_t close = i + 1;
+            for (;;) {
+                close = line.find('"', close);
+                if (close == std::string_view::npos) { close = line.size(); break; }
+                if (close + 1 < line.size() && line[close + 1] == '"') { close += 2; continue; }
+                break;
+            }
+            fields[count++] = line.substr(i + 1, close - i - 1);
+            next = close < line.size() ? line.find(sep, close + 1) : std::string_view::npos;
+        }
+        else {
+            next = line.find(sep, i);
+            fields[count++] = line.substr(i, next == std::string_view::npos ? std::string_view::npos : next - i);
+        }
+        if (next == std::string_view::npos) break;
+        i = next + 1;
+    }
+
+    // Sprawdzenie czy linia ma wystarczajaca liczbe kolumn
+    if (count < COLUMNS) return ERR_COLUMNS;
+
+    std::tm t;
+    if (!parseDate(fields[0], t)) return ERR_DATE;
+
+    // Konwersja wartosci liczbowych
+    if (!parseNumber(fields[1], out.autoconsumption)) return ERR_NUMBER;
+    if (!parseNumber(fields[2], out.exportEnergy)) return ERR_NUMBER;
+    if (!parseNumber(fields[3], out.importEnergy)) return ERR_NUMBER;
+    if (!parseNumber(fields[4], out.consumption)) return ERR_NUMBER;
+    if (!parseNumber(fields[5], out.production)) return ERR_NUMBER;
+
+    out.setTimestamp(t); // Czas liniowy wyliczany raz, przy parsowaniu
+    return nullptr;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file CsvParser.h
+ * @brief Definicja parsera linii w formacie eksportu z falownika (Chart_Export.csv).
+ *
+ * Plik naglowkowy zawierajacy deklaracje klasy CsvParser. Parser dziala na
+ * widokach (std::string_view) wskazujacych bezposrednio na zawartosc pliku,
+ * dzieki czemu przetworzenie linii nie wymaga zadnej alokacji pamieci.
+ */
+
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include "Measurement.h"
+#include <string_view>
+
+ /**
+  * @class CsvParser
+  * @brief Klasa statyczna zamieniajaca linie tekstu CSV na obiekty Measurement.
+  *
+  * Obsluguje format eksportu: data "DD.MM.RRRR G:MM" (opcjonalnie z sekundami),
+  * po ktorej nastepuje piec wartosci liczbowych w kolejnosci: autokonsumpcja,
+  * eksport, import, pobor, produkcja. Pola moga byc ujete w cudzyslowy,
+  * a separatorem jest przecinek (format Chart_Export.csv) lub srednik.
+  * Liczby sa parsowane przez std::from_chars, a data - recznym skanerem.
+  * Bledy nie sa zglaszane wyjatkami, lecz przez zwracany opis przyczyny.
+  */
+class CsvParser {
+public:
+    /** @brief Opis bledu: za malo kolumn w linii. */
+    static constexpr const char* ERR_COLUMNS = "Niepelna linia";
+    /** @brief Opis bledu: niepoprawna data lub godzina. */
+    static constexpr const char* ERR_DATE = "Bledna data";
+    /** @brief Opis bledu: niepoprawna wartosc liczbowa. */
+    static constexpr const char* ERR_NUMBER = "Bledna liczba";
+
+    /**
+     * @brief Wykrywa separator kolumn na podstawie wiersza naglowka.
+     *
+     * @param header Pierwsza linia pliku.
+     * @return char Srednik, jesli wystepuje w naglowku, w przeciwnym razie przecinek.
+     */
+    static char detectSeparator(std::string_view header);
+
+    /**
+     * @brief Pobiera kolejna linie z bufora.
+     *
+     * Zwraca widok na linie zaczynajaca sie na pozycji pos (bez znakow konca
+     * linii "\n" i "\r\n") i przesuwa pos za jej koniec.
+     *
+     * @param data Caly bufor (np. zawartosc odwzorowanego pliku).
+     * @param pos Pozycja poczatku linii; po wywolaniu - poczatek nastepnej.
+     * @return std::string_view Widok na linie.
+     */
+    static std::string_view nextLine(std::string_view data, std::size_t& pos);
+
+    /**
+     * @brief Parsuje date w formacie "DD.MM.RRRR G:MM[:SS]".
+     *
+     * @param text Tekst daty (bez cudzyslowow).
+     * @param out Struktura wynikowa (tm_year od 1900, tm_mon od 0).
+     * @return bool True, jesli data jest poprawna.
+     */
+    static bool parseDate(std::string_view text, std::tm& out);
+
+    /**
+     * @brief Parsuje liczbe zmiennoprzecinkowa.
+     *
+     * Akceptuje kropke lub przecinek jako separator dziesietny (przecinek
+     * wystepuje w eksportach rozdzielanych srednikami). Biale znaki na
+     * poczatku i koncu sa pomijane.
+     *
+     * @param text Tekst liczby (bez cudzyslowow).
+     * @param out Wartosc wynikowa.
+     * @return bool True, jesli caly tekst jest poprawna liczba.
+     */
+    static bool parseNumber(std::string_view text, double& out);
+
+    /**
+     * @brief Parsuje pojedyncza linie danych.
+     *
+     * Dzieli linie na pola (z obsluga cudzyslowow), parsuje date i piec
+     * wartosci oraz wylicza czas liniowy pomiaru (Measurement::setTimestamp).
+     *
+     * @param line Linia danych (bez znakow konca linii).
+     * @param sep Separator kolumn.
+     * @param out Pomiar wynikowy.
+     * @return const char* nullptr w przypadku sukcesu, w przeciwnym razie opis bledu (ERR_*).
+     */
+    static const char* parseLine(std::string_view line, char sep, Measurement& out);
+};
+
+#endif
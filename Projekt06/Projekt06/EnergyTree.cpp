@@ -8,114 +8,923 @@
  */
 
 #include "EnergyTree.h"
+#include "Metrics.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+#include <type_traits>
+
+namespace {
+    /**
+     * @brief Dodaje wartosci pol pomiaru do szkicow kwantyli miesiaca i roku.
+     *
+     * Klucz kubelka kazdej wartosci jest liczony raz dla obu poziomow.
+     */
+    void addToSketches(const Measurement& m, MonthNode& month, YearNode& year) {
+        const double row[FIELD_COUNT] = { m.autoconsumption, m.exportEnergy, m.importEnergy, m.consumption, m.production };
+        std::int32_t keys[FIELD_COUNT];
+        for (int f = 0; f < FIELD_COUNT; f++) keys[f] = QuantileSketch::key(row[f]);
+        month.sketches.add(row, keys);
+        year.sketches.add(row, keys);
+    }
+}
 
  /**
   * @brief Dodaje nowy pomiar do struktury drzewiastej.
   *
-  * Metoda analizuje date pomiaru, aby okreslic sciezke w drzewie:
-  * Rok -> Miesiac -> Dzien -> Kwadrans (blok 6-godzinny).
-  * Wykorzystuje mechanizm leniwej inicjalizacji (lazy initialization) -
-  * jesli wezel dla danego roku, miesiaca, dnia lub kwadransa nie istnieje,
-  * jest tworzony dynamicznie za pomoca std::make_unique.
+  * Przejmuje wlasnosc obiektu i deleguje do wariantu przyjmujacego referencje -
+  * wartosci sa kopiowane do kolumn liscia, a sam obiekt zwalniany.
   *
   * @param m Unikalny wskaznik do obiektu Measurement. Przejmuje wlasnosc obiektu.
   * @return bool Zwraca true, jesli pomiar udalo sie dodac (np. nie byl duplikatem).
   */
 bool EnergyTree::addMeasurement(std::unique_ptr<Measurement> m) {
+    return addMeasurement(*m);
+}
+
+/**
+ * @brief Dodaje kopie pomiaru do struktury drzewiastej.
+ *
+ * Metoda analizuje date pomiaru, aby okreslic sciezke w drzewie:
+ * Rok -> Miesiac -> Dzien -> Kwadrans (blok 6-godzinny).
+ * Czas pomiaru (epochTime, wyliczony przy parsowaniu) jest zamieniany na date, dzieki czemu
+ * klucze wezlow pochodza ze znormalizowanej daty (np. tm_mday == 0 trafia
+ * do ostatniego dnia poprzedniego miesiaca).
+ * Wykorzystuje mechanizm leniwej inicjalizacji (lazy initialization) -
+ * jesli wezel dla danego roku, miesiaca, dnia lub kwadransa nie istnieje,
+ * jest tworzony w arenie drzewa (try_emplace - wezel mapy zawiera wezel drzewa).
+ *
+ * @param m Dodawany pomiar.
+ * @return bool Zwraca true, jesli pomiar udalo sie dodac (np. nie byl duplikatem).
+ */
+bool EnergyTree::addMeasurement(const Measurement& m) {
+    Metrics::ScopedTimer timer(Metrics::Histogram::ADD_NS, Metrics::sample());
+    time_t t = m.epochTime();
+    std::tm n = Measurement::fromEpoch(t);
+
     // Ekstrakcja kluczy dla poszczegolnych poziomow drzewa
-    int y = m->timestamp.tm_year + 1900;
-    int mon = m->timestamp.tm_mon + 1;
-    int d = m->timestamp.tm_mday;
-    int q = m->timestamp.tm_hour / 6; // Obliczenie indeksu kwadransa (0-3)
+    int y = n.tm_year + 1900;
+    int mon = n.tm_mon + 1;
+    int d = n.tm_mday;
+    int q = n.tm_hour / 6; // Obliczenie indeksu kwadransa (0-3)
 
-    // Tworzenie brakujacych wezlow w sciezce
-    if (!root[y]) root[y] = std::make_unique<YearNode>();
-    if (!root[y]->months[mon]) root[y]->months[mon] = std::make_unique<MonthNode>();
-    if (!root[y]->months[mon]->days[d]) root[y]->months[mon]->days[d] = std::make_unique<DayNode>();
-    if (!root[y]->months[mon]->days[d]->quarters[q]) root[y]->months[mon]->days[d]->quarters[q] = std::make_unique<QuarterNode>();
+    // Tworzenie brakujacych wezlow w sciezce (alokator mapy przekazuje arene w dol)
+    YearNode& yearNode = root->try_emplace(y).first->second;
+    MonthNode& monthNode = yearNode.months.try_emplace(mon).first->second;
+    DayNode& dayNode = monthNode.days.try_emplace(d).first->second;
+    QuarterNode& leaf = dayNode.quarters.try_emplace(q, QuarterNode::blockStart(t)).first->second;
 
     // Delegacja dodania do liscia drzewa (wezel QuarterNode)
-    return root[y]->months[mon]->days[d]->quarters[q]->add(std::move(m));
+    if (!leaf.add(m, t)) {
+        Metrics::add(Metrics::Counter::DUPLICATES);
+        return false;
+    }
+    Metrics::add(Metrics::Counter::MEASUREMENTS_ADDED);
+
+    // Aktualizacja agregatow na calej sciezce od liscia do roku
+    leaf.stats.add(m, t);
+    dayNode.stats.add(m, t);
+    monthNode.stats.add(m, t);
+    yearNode.stats.add(m, t);
+    addToSketches(m, monthNode, yearNode);
+    monthNode.epoch = yearNode.epoch = ++writes;
+    return true;
+}
+
+/**
+ * @brief Dodaje do drzewa paczke pomiarow posortowanych rosnaco wg czasu.
+ *
+ * Przechowuje sciezke do ostatnio uzywanego liscia. Pomiar mieszczacy sie
+ * w biezacym bloku 6-godzinnym trafia wprost do jego slotu; dopiero zmiana
+ * bloku powoduje wyliczenie kluczy i zejscie po mapach, przy czym wezly sa
+ * wstawiane z podpowiedzia konca mapy (try_emplace z hintem), co dla danych
+ * dopisywanych na koncu daje koszt staly zamiast logarytmicznego.
+ * Agregaty pomiarow biezacego bloku sa zbierane lokalnie i dolaczane do
+ * dnia, miesiaca i roku przy zmianie bloku, a szkice kwantyli - przy zmianie
+ * miesiaca (lokalny szkic jest maly i pozostaje w pamieci podrecznej procesora).
+ *
+ * @param batch Pomiary posortowane rosnaco wg czasu.
+ * @param duplicates Opcjonalnie: indeksy odrzuconych duplikatow.
+ * @return std::size_t Liczba dodanych pomiarow.
+ */
+std::size_t EnergyTree::bulkLoad(const std::vector<Measurement>& batch, std::vector<std::size_t>* duplicates) {
+    Metrics::ScopedTimer timer(Metrics::Histogram::BULK_LOAD_NS);
+    YearNode* yearNode = nullptr;
+    MonthNode* monthNode = nullptr;
+    DayNode* dayNode = nullptr;
+    QuarterNode* leaf = nullptr;
+    NodeStats run; // Agregaty pomiarow dodanych do biezacego bloku
+    // Szkice kwantyli pomiarow dodanych do biezacego miesiaca (pamiec robocza spoza areny)
+    std::pmr::unsynchronized_pool_resource scratch(std::pmr::new_delete_resource());
+    NodeSketches monthSketch(&scratch);
+    std::size_t monthCount = 0;
+    MonthNode* sketchMonth = nullptr; // Miesiac i rok, do ktorych nalezy monthSketch
+    YearNode* sketchYear = nullptr;
+
+    // Dolaczenie agregatow biezacego bloku do wezlow nadrzednych
+    auto flush = [&]() {
+        if (run.count == 0) return;
+        dayNode->stats.merge(run);
+        monthNode->stats.merge(run);
+        yearNode->stats.merge(run);
+        run = NodeStats();
+    };
+
+    // Dolaczenie szkicow biezacego miesiaca - jedno dodanie tablic licznikow na pole i poziom
+    auto flushMonth = [&]() {
+        if (monthCount == 0) return;
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            sketchMonth->sketches.fields[f].merge(monthSketch.fields[f]);
+            sketchYear->sketches.fields[f].merge(monthSketch.fields[f]);
+            monthSketch.fields[f].clear();
+        }
+        monthCount = 0;
+    };
+
+    std::size_t added = 0;
+    std::size_t direct = 0, rejected = 0; // Wynik sciezki bez addMeasurement (do Metrics)
+    time_t prev = 0;
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        const Measurement& m = batch[i];
+        time_t t = m.epochTime();
+
+        if (i > 0 && t <= prev) {
+            // Duplikat sasiada lub naruszenie porzadku - sciezka ogolna
+            bool ok = t != prev && addMeasurement(m);
+            if (ok) added++;
+            else {
+                if (t == prev) rejected++;
+                if (duplicates) duplicates->push_back(i);
+            }
+            continue;
+        }
+        prev = t;
+
+        if (!leaf || t >= leaf->base + QuarterNode::BLOCK_SECONDS) {
+            flush();
+            std::tm n = Measurement::fromEpoch(t);
+            int y = n.tm_year + 1900, mon = n.tm_mon + 1, d = n.tm_mday, q = n.tm_hour / 6;
+
+            yearNode = &root->try_emplace(root->end(), y)->second;
+            monthNode = &yearNode->months.try_emplace(yearNode->months.end(), mon)->second;
+            dayNode = &monthNode->days.try_emplace(monthNode->days.end(), d)->second;
+            leaf = &dayNode->quarters.try_emplace(dayNode->quarters.end(), q, QuarterNode::blockStart(t))->second;
+            if (monthNode != sketchMonth) {
+                flushMonth();
+                sketchMonth = monthNode;
+                sketchYear = yearNode;
+            }
+        }
+
+        if (leaf->add(m, t)) {
+            leaf->stats.add(m, t);
+            run.add(m, t);
+            const double row[FIELD_COUNT] = { m.autoconsumption, m.exportEnergy, m.importEnergy, m.consumption, m.production };
+            for (int f = 0; f < FIELD_COUNT; f++) monthSketch.fields[f].add(row[f]);
+            monthCount++;
+            monthNode->epoch = yearNode->epoch = ++writes;
+            added++;
+            direct++;
+        }
+        else {
+            rejected++;
+            if (duplicates) duplicates->push_back(i);
+        }
+    }
+    flush();
+    flushMonth();
+    Metrics::add(Metrics::Counter::MEASUREMENTS_ADDED, direct);
+    Metrics::add(Metrics::Counter::DUPLICATES, rejected);
+    return added;
+}
+
+namespace {
+    void accumulate(const QuarterNode& node, time_t start, time_t end, NodeStats& out);
+    void accumulate(const DayNode& node, time_t start, time_t end, NodeStats& out);
+    void accumulate(const MonthNode& node, time_t start, time_t end, NodeStats& out);
+
+    /**
+     * @brief Dolacza do wyniku agregaty wezlow potomnych przecinajacych przedzial.
+     *
+     * Wezly rozlaczne z przedzialem sa pomijane, wezly calkowicie pokryte
+     * dolaczane sa przez swoje agregaty, a pozostale (brzegowe) rozwijane
+     * rekurencyjnie. Dzieci sa uporzadkowane chronologicznie, wiec po
+     * napotkaniu wezla zaczynajacego sie za koncem przedzialu mozna przerwac.
+     */
+    template <typename Child>
+    void accumulateChildren(const std::pmr::map<int, Child>& children, time_t start, time_t end, NodeStats& out) {
+        for (const auto& entry : children) {
+            const NodeStats& st = entry.second.stats;
+            if (st.count == 0 || st.last < start) continue;
+            if (st.first > end) break;
+            if (start <= st.first && st.last <= end) out.merge(st);
+            else accumulate(entry.second, start, end, out);
+        }
+    }
+
+    /**
+     * @brief Zwraca maske slotow o indeksach [lo, hi] (0 <= lo <= hi < 32).
+     */
+    std::uint32_t slotRange(time_t lo, time_t hi) {
+        return (~0u << lo) & (~0u >> (31 - hi));
+    }
+
+    /**
+     * @brief Zwraca maske slotow bloku lezacych w przedziale czasu [start, end].
+     */
+    std::uint32_t slotsWithin(const QuarterNode& node, time_t start, time_t end) {
+        time_t lo = start <= node.base ? 0 : (start - node.base + QuarterNode::SLOT_SECONDS - 1) / QuarterNode::SLOT_SECONDS;
+        time_t hi = end < node.base ? -1 : (end - node.base) / QuarterNode::SLOT_SECONDS;
+        if (hi >= QuarterNode::SLOT_COUNT) hi = QuarterNode::SLOT_COUNT - 1;
+        return lo <= hi ? slotRange(lo, hi) : 0;
+    }
+
+    void accumulate(const QuarterNode& node, time_t start, time_t end, NodeStats& out) {
+        Metrics::add(Metrics::Counter::BLOCKS_SCANNED);
+        // Sloty siatki w przedziale: maska zakresu nalozona na maske zajetosci
+        std::uint32_t bits = node.occupied & slotsWithin(node, start, end);
+        if (bits) {
+            out.addTimes(node.slotTime(std::countr_zero(bits)), node.slotTime(31 - std::countl_zero(bits)), std::popcount(bits));
+            for (int f = 0; f < FIELD_COUNT; f++) SimdKernels::maskedStats(node.slots[f], QuarterNode::SLOT_COUNT, bits, out.fields[f]);
+        }
+
+        // Pomiary spoza siatki sa posortowane - wystarczy znalezc podzakres kolumn
+        std::size_t from = std::lower_bound(node.times.begin(), node.times.end(), start) - node.times.begin();
+        std::size_t to = std::upper_bound(node.times.begin(), node.times.end(), end) - node.times.begin();
+        if (from < to) {
+            out.addTimes(node.times[from], node.times[to - 1], to - from);
+            for (int f = 0; f < FIELD_COUNT; f++) SimdKernels::stats(node.values[f].data() + from, to - from, out.fields[f]);
+        }
+    }
+
+    void accumulate(const DayNode& node, time_t start, time_t end, NodeStats& out) { accumulateChildren(node.quarters, start, end, out); }
+    void accumulate(const MonthNode& node, time_t start, time_t end, NodeStats& out) { accumulateChildren(node.days, start, end, out); }
+
+    /**
+     * @brief Wywoluje fn dla kazdego bloku (QuarterNode) przecinajacego przedzial czasu.
+     *
+     * Schodzi rekurencyjnie tylko do wezlow, ktorych zakres czasu (NodeStats)
+     * ma czesc wspolna z przedzialem, a ktorych agregaty nie zostaly odrzucone
+     * przez skip; bloki sa odwiedzane chronologicznie.
+     */
+    template <typename Child, typename Fn, typename Skip>
+    void visitLeaves(const std::pmr::map<int, Child>& children, time_t start, time_t end, Fn& fn, const Skip& skip) {
+        for (const auto& entry : children) {
+            const NodeStats& st = entry.second.stats;
+            if (st.count == 0 || st.last < start) continue;
+            if (st.first > end) break;
+            if (skip(st)) continue;
+            if constexpr (std::is_same_v<Child, QuarterNode>) fn(entry.second);
+            else if constexpr (std::is_same_v<Child, DayNode>) visitLeaves(entry.second.quarters, start, end, fn, skip);
+            else if constexpr (std::is_same_v<Child, MonthNode>) visitLeaves(entry.second.days, start, end, fn, skip);
+            else visitLeaves(entry.second.months, start, end, fn, skip);
+        }
+    }
+
+    /**
+     * @brief Zwraca chronologiczna liste miesiecy (partycji) przecinajacych przedzial czasu.
+     */
+    std::vector<const MonthNode*> monthsWithin(const YearMap& root, time_t start, time_t end) {
+        std::vector<const MonthNode*> out;
+        for (const auto& year : root) {
+            const NodeStats& ys = year.second.stats;
+            if (ys.count == 0 || ys.last < start) continue;
+            if (ys.first > end) break;
+            for (const auto& month : year.second.months) {
+                const NodeStats& ms = month.second.stats;
+                if (ms.count == 0 || ms.last < start) continue;
+                if (ms.first > end) break;
+                out.push_back(&month.second);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Dopisuje do wyniku pomiary bloku z przedzialu [start, end], w ktorych pole f miesci sie w [lo, hi].
+     *
+     * Sloty siatki sa filtrowane maska (zakres czasu i zajetosc) i porownywane
+     * z granicami jednym wywolaniem SimdKernels::maskedMatch, a podzakres listy
+     * nadmiarowej - wywolaniem SimdKernels::match. Trafienia z obu zrodel
+     * sa scalane w porzadku chronologicznym.
+     */
+    void scanLeaf(const QuarterNode& leaf, int f, double lo, double hi, time_t start, time_t end,
+        std::vector<std::size_t>& hits, std::vector<Measurement>& out) {
+        Metrics::add(Metrics::Counter::BLOCKS_SCANNED);
+        std::uint32_t bits = SimdKernels::maskedMatch(leaf.slots[f], QuarterNode::SLOT_COUNT, leaf.occupied & slotsWithin(leaf, start, end), lo, hi);
+
+        std::size_t from = std::lower_bound(leaf.times.begin(), leaf.times.end(), start) - leaf.times.begin();
+        std::size_t to = std::upper_bound(leaf.times.begin(), leaf.times.end(), end) - leaf.times.begin();
+        hits.clear();
+        if (from < to) SimdKernels::match(leaf.values[f].data() + from, to - from, lo, hi, hits);
+
+        std::size_t k = 0;
+        while (bits || k < hits.size()) {
+            int slot = bits ? std::countr_zero(bits) : QuarterNode::SLOT_COUNT;
+            if (slot < QuarterNode::SLOT_COUNT && (k == hits.size() || leaf.slotTime(slot) < leaf.times[from + hits[k]])) {
+                out.push_back(leaf.at(QuarterNode::Position{ slot, leaf.times.size() }));
+                bits &= bits - 1;
+            }
+            else out.push_back(leaf.at(QuarterNode::Position{ QuarterNode::SLOT_COUNT, from + hits[k++] }));
+        }
+    }
+
+    /**
+     * @brief Segmenty osi czasu zapytania zbiorczego (EnergyTree::aggregateMany).
+     *
+     * Posortowane granice wszystkich przedzialow (poczatki i konce + 1) dziela
+     * os czasu na segmenty [bounds[k], bounds[k + 1] - 1]. Kazdy przedzial
+     * zapytania jest ciagiem kolejnych segmentow; segmenty lezace w luce
+     * miedzy przedzialami (used bez zmiany) nie sa liczone.
+     */
+    struct Sweep {
+        std::vector<time_t> bounds;         /**< Granice segmentow, rosnaco. */
+        std::vector<std::size_t> used;      /**< used[k] - liczba potrzebnych segmentow o indeksie < k. */
+        std::vector<NodeStats> segments;    /**< Agregaty segmentow. */
+
+        /**
+         * @brief Zwraca indeks segmentu zawierajacego chwile t (-1 przed pierwszym, size() za ostatnim).
+         */
+        std::ptrdiff_t locate(time_t t) const {
+            return std::upper_bound(bounds.begin(), bounds.end(), t) - bounds.begin() - 1;
+        }
+
+        /**
+         * @brief Sprawdza, czy ktorykolwiek z segmentow [lo, hi] nalezy do przedzialu zapytania.
+         */
+        bool needed(std::ptrdiff_t lo, std::ptrdiff_t hi) const { return used[hi + 1] > used[lo]; }
+    };
+
+    /**
+     * @brief Rozdziela pomiary wezlow potomnych miedzy segmenty w jednym przejsciu.
+     *
+     * Wezel lezacy w calosci w jednym segmencie wnosi swoje agregaty; wezel
+     * przecinajacy granice segmentow jest rozwijany, a blok - liczony osobno
+     * dla kazdego przecinanego segmentu (accumulate). Kazdy wezel drzewa jest
+     * odwiedzany co najwyzej raz, niezaleznie od liczby przedzialow zapytania.
+     */
+    template <typename Child>
+    void sweepChildren(const std::pmr::map<int, Child>& children, Sweep& s) {
+        std::ptrdiff_t top = static_cast<std::ptrdiff_t>(s.segments.size()) - 1;
+        for (const auto& entry : children) {
+            const NodeStats& st = entry.second.stats;
+            if (st.count == 0 || st.last < s.bounds.front()) continue;
+            if (st.first >= s.bounds.back()) break;
+            std::ptrdiff_t from = s.locate(st.first), to = s.locate(st.last);
+            std::ptrdiff_t lo = std::max<std::ptrdiff_t>(from, 0), hi = std::min(to, top);
+            if (!s.needed(lo, hi)) continue;
+            if (from == to) s.segments[lo].merge(st);
+            else if constexpr (std::is_same_v<Child, QuarterNode>) {
+                for (std::ptrdiff_t k = lo; k <= hi; k++) {
+                    if (s.needed(k, k)) accumulate(entry.second, s.bounds[k], s.bounds[k + 1] - 1, s.segments[k]);
+                }
+            }
+            else if constexpr (std::is_same_v<Child, DayNode>) sweepChildren(entry.second.quarters, s);
+            else if constexpr (std::is_same_v<Child, MonthNode>) sweepChildren(entry.second.days, s);
+            else sweepChildren(entry.second.months, s);
+        }
+    }
+
+    /**
+     * @brief Dodaje do szkicu wartosci pola f pomiarow bloku z przedzialu [start, end].
+     */
+    void sketchLeaf(const QuarterNode& node, int f, time_t start, time_t end, QuantileSketch& out) {
+        Metrics::add(Metrics::Counter::BLOCKS_SCANNED);
+        for (std::uint32_t bits = node.occupied & slotsWithin(node, start, end); bits; bits &= bits - 1) {
+            out.add(node.slots[f][std::countr_zero(bits)]);
+        }
+        std::size_t from = std::lower_bound(node.times.begin(), node.times.end(), start) - node.times.begin();
+        std::size_t to = std::upper_bound(node.times.begin(), node.times.end(), end) - node.times.begin();
+        for (std::size_t i = from; i < to; i++) out.add(node.values[f][i]);
+    }
+
+    /**
+     * @brief Dolacza do szkicu pole f pomiarow wezlow potomnych przecinajacych przedzial.
+     *
+     * Tak jak accumulateChildren: miesiac lub rok calkowicie pokryty wnosi
+     * swoj szkic, a wezly brzegowe sa rozwijane. Dni nie maja szkicow, wiec
+     * wartosci pojedynczych pomiarow sa dodawane z blokow dni przecinajacych
+     * przedzial (najwyzej dwa brzegowe miesiace).
+     */
+    template <typename Child>
+    void sketchChildren(const std::pmr::map<int, Child>& children, int f, time_t start, time_t end, QuantileSketch& out) {
+        for (const auto& entry : children) {
+            const NodeStats& st = entry.second.stats;
+            if (st.count == 0 || st.last < start) continue;
+            if (st.first > end) break;
+            if constexpr (std::is_same_v<Child, QuarterNode>) sketchLeaf(entry.second, f, start, end, out);
+            else if constexpr (std::is_same_v<Child, DayNode>) sketchChildren(entry.second.quarters, f, start, end, out);
+            else if (start <= st.first && st.last <= end) out.merge(entry.second.sketches.fields[f]);
+            else if constexpr (std::is_same_v<Child, MonthNode>) sketchChildren(entry.second.days, f, start, end, out);
+            else sketchChildren(entry.second.months, f, start, end, out);
+        }
+    }
+}
+
+/**
+ * @brief Oblicza agregaty pomiarow z przedzialu czasu.
+ *
+ * Rok calkowicie pokryty przez przedzial wnosi od razu swoje zapamietane
+ * agregaty, a lata brzegowe sa dzielone na partycje - miesiace przecinajace
+ * przedzial. Miesiac calkowicie pokryty wnosi swoje agregaty, a miesiace
+ * brzegowe sa rozwijane (accumulate) tylko tam, gdzie przedzial czesciowo
+ * przecina wezel - na watkach puli, jesli zostala podana. Koszt laczenia
+ * zalezy wiec od liczby lat, a nie miesiecy przedzialu. Agregaty partycji
+ * sa laczone zawsze w porzadku chronologicznym, dlatego wynik (co do bitu)
+ * nie zalezy od liczby watkow ani od tego, czy pula zostala uzyta.
+ *
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @param pool Opcjonalna pula watkow.
+ * @return NodeStats Agregaty pomiarow z przedzialu.
+ */
+NodeStats EnergyTree::aggregate(time_t start, time_t end, ThreadPool* pool) const {
+    Metrics::add(Metrics::Counter::QUERIES);
+    Metrics::ScopedTimer timer(Metrics::Histogram::QUERY_NS);
+    std::vector<NodeStats> parts;
+    std::vector<std::pair<std::size_t, const MonthNode*>> partial; // Miesiace brzegowe wymagajace zejscia w dol
+
+    for (const auto& year : *root) {
+        const NodeStats& ys = year.second.stats;
+        if (ys.count == 0 || ys.last < start) continue;
+        if (ys.first > end) break;
+        if (start <= ys.first && ys.last <= end) {
+            parts.push_back(ys);
+            continue;
+        }
+        for (const auto& month : year.second.months) {
+            const NodeStats& ms = month.second.stats;
+            if (ms.count == 0 || ms.last < start) continue;
+            if (ms.first > end) break;
+            if (start <= ms.first && ms.last <= end) parts.push_back(ms);
+            else {
+                partial.emplace_back(parts.size(), &month.second);
+                parts.emplace_back();
+            }
+        }
+    }
+    forEachPartition(partial.size(), pool, [&](std::size_t k) {
+        accumulate(*partial[k].second, start, end, parts[partial[k].first]);
+    });
+
+    NodeStats result;
+    for (const NodeStats& part : parts) result.merge(part);
+    return result;
+}
+
+/**
+ * @brief Oblicza agregaty wielu przedzialow czasu w jednym przejsciu po drzewie.
+ *
+ * Granice przedzialow sa sortowane i wyznaczaja segmenty elementarne;
+ * sweepChildren rozdziela miedzy nie pomiary drzewa, schodzac tylko do
+ * wezlow przecinajacych granice (pozostale wnosza zapamietane agregaty).
+ * Wynik przedzialu to polaczenie agregatow jego segmentow w porzadku
+ * chronologicznym. Koszt zalezy od liczby roznych granic, a nie od liczby
+ * przedzialow - powtarzajace sie i stykajace przedzialy sa niemal darmowe.
+ *
+ * @param ranges Przedzialy [poczatek, koniec] (wlacznie), w dowolnej kolejnosci.
+ * @return std::vector<NodeStats> Agregaty kolejnych przedzialow (puste dla poczatek > koniec).
+ */
+std::vector<NodeStats> EnergyTree::aggregateMany(const std::vector<std::pair<time_t, time_t>>& ranges) const {
+    Metrics::add(Metrics::Counter::QUERIES);
+    Metrics::ScopedTimer timer(Metrics::Histogram::QUERY_NS);
+    std::vector<NodeStats> result(ranges.size());
+
+    Sweep s;
+    for (const auto& [start, end] : ranges) {
+        if (start > end) continue;
+        s.bounds.push_back(start);
+        s.bounds.push_back(end + 1);
+    }
+    if (s.bounds.empty()) return result;
+    std::sort(s.bounds.begin(), s.bounds.end());
+    s.bounds.erase(std::unique(s.bounds.begin(), s.bounds.end()), s.bounds.end());
+    std::size_t count = s.bounds.size() - 1;
+    s.segments.resize(count);
+
+    // Segmenty pokryte przez przedzialy: roznice na granicach, potem sumy prefiksowe
+    std::vector<int> cover(count + 1, 0);
+    for (const auto& [start, end] : ranges) {
+        if (start > end) continue;
+        cover[s.locate(start)]++;
+        cover[s.locate(end + 1)]--;
+    }
+    s.used.assign(count + 1, 0);
+    int depth = 0;
+    for (std::size_t k = 0; k < count; k++) {
+        depth += cover[k];
+        s.used[k + 1] = s.used[k] + (depth > 0 ? 1 : 0);
+    }
+
+    sweepChildren(*root, s);
+
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+        const auto& [start, end] = ranges[i];
+        if (start > end) continue;
+        for (std::ptrdiff_t k = s.locate(start), stop = s.locate(end + 1); k < stop; k++) result[i].merge(s.segments[k]);
+    }
+    return result;
+}
+
+/**
+ * @brief Buduje szkic kwantyli pola z pomiarow przedzialu czasu.
+ *
+ * Laczone sa szkice najwiekszych wezlow (rok, miesiac) lezacych w calosci
+ * w przedziale; wartosci pojedynczych pomiarow sa dodawane z blokow dni
+ * miesiecy brzegowych.
+ *
+ * @param type Typ danych (pole pomiaru).
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @return QuantileSketch Szkic wartosci pola w przedziale (pusty dla nieznanego typu).
+ */
+QuantileSketch EnergyTree::sketch(DataType type, time_t start, time_t end) const {
+    Metrics::add(Metrics::Counter::QUERIES);
+    Metrics::ScopedTimer timer(Metrics::Histogram::QUERY_NS);
+    int f = static_cast<int>(type);
+    if (f < 0 || f >= FIELD_COUNT) return QuantileSketch();
+    QuantileSketch out;
+    if (start <= end) sketchChildren(*root, f, start, end, out);
+    return out;
+}
+
+/**
+ * @brief Wyszukuje pomiary, w ktorych wartosc pola miesci sie w zadanym przedziale.
+ *
+ * Agregaty wezlow sluza jako indeks wartosci: wezel (rok, miesiac, dzien,
+ * blok), ktorego zakres [min, max] wskazanego pola jest rozlaczny z [lo, hi],
+ * jest pomijany wraz z calym poddrzewem. Przegladane sa wiec tylko bloki,
+ * ktore moga zawierac trafienia - dla danych o wartosciach zmieniajacych
+ * sie plynnie koszt jest bliski O(log n + k) zamiast O(n).
+ * Kazdy pozostaly miesiac jest osobna partycja: jego bloki sa przegladane
+ * funkcja scanLeaf (petle SimdKernels) do osobnego wektora, a wektory sa
+ * na koniec sklejane w porzadku chronologicznym. Z pula watkow partycje
+ * sa przetwarzane rownolegle, a wynik jest taki sam.
+ *
+ * @param type Typ danych (pole pomiaru).
+ * @param lo Dolna granica wartosci (wlacznie).
+ * @param hi Gorna granica wartosci (wlacznie).
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @param pool Opcjonalna pula watkow.
+ * @return std::vector<Measurement> Znalezione pomiary.
+ */
+std::vector<Measurement> EnergyTree::find(DataType type, double lo, double hi, time_t start, time_t end, ThreadPool* pool) const {
+    Metrics::add(Metrics::Counter::QUERIES);
+    Metrics::ScopedTimer timer(Metrics::Histogram::QUERY_NS);
+    int f = static_cast<int>(type);
+    if (f < 0 || f >= FIELD_COUNT) return {};
+    auto outside = [f, lo, hi](const NodeStats& st) { return st.fields[f].max < lo || st.fields[f].min > hi; };
+
+    std::vector<const MonthNode*> months;
+    if (start <= end) {
+        for (const MonthNode* month : monthsWithin(*root, start, end)) {
+            if (!outside(month->stats)) months.push_back(month);
+        }
+    }
+    std::vector<std::vector<Measurement>> parts(months.size());
+
+    forEachPartition(months.size(), pool, [&](std::size_t i) {
+        std::vector<std::size_t> hits; // Indeksy trafien w liscie nadmiarowej (wspolny bufor partycji)
+        auto scan = [&](const QuarterNode& leaf) { scanLeaf(leaf, f, lo, hi, start, end, hits, parts[i]); };
+        visitLeaves(months[i]->days, start, end, scan, outside);
+    });
+
+    if (parts.size() == 1) return std::move(parts[0]);
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    std::vector<Measurement> result;
+    result.reserve(total);
+    for (const auto& part : parts) result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+
+/**
+ * @brief Buduje szereg zagregowany o zadanej rozdzielczosci.
+ *
+ * Schodzi po wezlach przecinajacych przedzial tylko do poziomu kubelka:
+ * dla MONTH i DAY kubelkiem jest wezel miesiaca lub dnia (jego agregaty,
+ * albo accumulate, gdy przedzial przecina go czesciowo), dla HOUR - kazda
+ * z szesciu godzin bloku (accumulate z przedzialem zawezonym do godziny),
+ * a dla RAW - kazdy pomiar bloku z przedzialu.
+ *
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @param res Rozdzielczosc kubelkow.
+ * @return std::vector<SeriesPoint> Niepuste kubelki w porzadku chronologicznym.
+ */
+std::vector<SeriesPoint> EnergyTree::series(time_t start, time_t end, Resolution res) const {
+    Metrics::add(Metrics::Counter::QUERIES);
+    Metrics::ScopedTimer timer(Metrics::Histogram::QUERY_NS);
+    std::vector<SeriesPoint> out;
+    if (start > end) return out;
+
+    // Wezel rozlaczny z przedzialem: -1 (przed nim), 1 (za nim), 0 - przecina
+    auto overlap = [&](const NodeStats& st) { return st.count == 0 || st.last < start ? -1 : st.first > end ? 1 : 0; };
+    auto covered = [&](const NodeStats& st) { return start <= st.first && st.last <= end; };
+    // Kubelek wezla: jego agregaty albo czesc z przedzialu
+    auto bucket = [&](time_t from, const auto& node) {
+        SeriesPoint p{ from, {} };
+        if (covered(node.stats)) p.stats = node.stats;
+        else accumulate(node, start, end, p.stats);
+        if (p.stats.count) out.push_back(p);
+    };
+
+    for (const auto& year : *root) {
+        int ov = overlap(year.second.stats);
+        if (ov < 0) continue;
+        if (ov > 0) break;
+        for (const auto& month : year.second.months) {
+            if ((ov = overlap(month.second.stats)) < 0) continue;
+            if (ov > 0) break;
+            std::tm tm = {};
+            tm.tm_year = year.first - 1900;
+            tm.tm_mon = month.first - 1;
+            tm.tm_mday = 1;
+            time_t monthStart = Measurement::toEpoch(tm);
+            if (res == Resolution::MONTH) { bucket(monthStart, month.second); continue; }
+
+            for (const auto& day : month.second.days) {
+                if ((ov = overlap(day.second.stats)) < 0) continue;
+                if (ov > 0) break;
+                if (res == Resolution::DAY) { bucket(monthStart + (day.first - 1) * 86400LL, day.second); continue; }
+
+                for (const auto& quarter : day.second.quarters) {
+                    const QuarterNode& leaf = quarter.second;
+                    if ((ov = overlap(leaf.stats)) < 0) continue;
+                    if (ov > 0) break;
+                    if (res == Resolution::HOUR) {
+                        for (time_t h = leaf.base; h < leaf.base + QuarterNode::BLOCK_SECONDS; h += 3600) {
+                            SeriesPoint p{ h, {} };
+                            accumulate(leaf, std::max(start, h), std::min(end, h + 3599), p.stats);
+                            if (p.stats.count) out.push_back(p);
+                        }
+                        continue;
+                    }
+                    Metrics::add(Metrics::Counter::BLOCKS_SCANNED);
+                    for (QuarterNode::Position pos = leaf.first(); leaf.valid(pos); leaf.next(pos)) {
+                        time_t t = leaf.time(pos);
+                        if (t < start) continue;
+                        if (t > end) break;
+                        SeriesPoint p{ t, {} };
+                        p.stats.addTime(t);
+                        for (int f = 0; f < FIELD_COUNT; f++) p.stats.fields[f].add(leaf.value(pos, static_cast<DataType>(f)));
+                        out.push_back(p);
+                    }
+                }
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Laczy agregaty wszystkich wezlow roku.
+ *
+ * @return NodeStats Agregaty calego drzewa.
+ */
+NodeStats EnergyTree::totals() const {
+    NodeStats result;
+    for (const auto& year : *root) result.merge(year.second.stats);
+    return result;
+}
+
+/**
+ * @brief Usuwa wszystkie wezly, oddajac arene drzewa.
+ *
+ * Wezly, mapy i kolumny nadmiarowe maja pamiec wylacznie z areny, wiec
+ * nie sa niszczone pojedynczo: release() zwalnia kilka duzych blokow areny
+ * naraz, a w pustej arenie tworzona jest nowa mapa lat.
+ */
+void EnergyTree::clear() {
+    arena->release();
+    root = newRoot();
+    clearedAt = ++writes;
+}
+
+/**
+ * @brief Zlicza wezly drzewa i rozmiary blokow.
+ *
+ * @return TreeShape Ksztalt drzewa.
+ */
+TreeShape EnergyTree::shape() const {
+    TreeShape out;
+    for (const auto& year : *root) {
+        out.years++;
+        for (const auto& month : year.second.months) {
+            out.months++;
+            for (const auto& day : month.second.days) {
+                out.days++;
+                for (const auto& quarter : day.second.quarters) {
+                    const QuarterNode& leaf = quarter.second;
+                    std::size_t n = static_cast<std::size_t>(std::popcount(leaf.occupied)) + leaf.times.size();
+                    out.leaves++;
+                    out.measurements += n;
+                    out.overflow += leaf.times.size();
+                    if (out.leafSizes.size() <= n) out.leafSizes.resize(n + 1);
+                    out.leafSizes[n]++;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Sprawdza, czy dane z przedzialu nie zmienily sie od zapisu o numerze epoch.
+ *
+ * Klucze lat i miesiecy pochodza z dat granic przedzialu (tak jak
+ * w addMeasurement), wiec sprawdzane sa rowniez wezly utworzone po
+ * zapamietaniu numeru. Koszt to odczyt numerow kilku wezlow, niezaleznie
+ * od liczby pomiarow.
+ *
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @param epoch Zapamietany numer zapisu.
+ * @return bool True, jesli zaden wezel przedzialu nie zostal zmieniony.
+ */
+bool EnergyTree::unchangedSince(time_t start, time_t end, std::uint64_t epoch) const {
+    if (clearedAt > epoch) return false;
+    if (start > end) return true;
+    std::tm a = Measurement::fromEpoch(start), b = Measurement::fromEpoch(end);
+    int firstYear = a.tm_year + 1900, lastYear = b.tm_year + 1900;
+
+    for (auto y = root->lower_bound(firstYear); y != root->end() && y->first <= lastYear; ++y) {
+        if (y->second.epoch <= epoch) continue;
+        int firstMonth = y->first == firstYear ? a.tm_mon + 1 : 1;
+        int lastMonth = y->first == lastYear ? b.tm_mon + 1 : 12;
+        const auto& months = y->second.months;
+        for (auto m = months.lower_bound(firstMonth); m != months.end() && m->first <= lastMonth; ++m) {
+            if (m->second.epoch > epoch) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Zwraca widok na pomiary z przedzialu czasu.
+ *
+ * Zamienia obie daty na sekundy od epoki (Measurement::toEpoch), a nastepnie
+ * tworzy iterator zakresowy, ktory sam odnajduje pierwszy pomiar przedzialu.
+ *
+ * @param start Data poczatkowa (wlacznie).
+ * @param end Data koncowa (wlacznie).
+ * @return EnergyTree::Range Widok na pomiary z przedzialu.
+ */
+EnergyTree::Range EnergyTree::range(std::tm start, std::tm end) const {
+    time_t s = Measurement::toEpoch(start), e = Measurement::toEpoch(end);
+    return Range(Iterator(*root, Measurement::fromEpoch(s), s, e), Iterator(*root, true));
 }
 
 /**
  * @brief Konstruktor iteratora EnergyTree.
  *
- * Inicjalizuje zagniezdzone iteratory (dla lat, miesiecy, dni, kwadransow i wektora pomiarow).
+ * Inicjalizuje zagniezdzone iteratory (dla lat, miesiecy, dni i kwadransow) oraz pozycje w kolumnach liscia.
  * Jesli tworzony jest iterator begin, ustawia wskazniki na pierwszy dostepny element.
  * Jesli tworzony jest iterator end lub drzewo jest puste, ustawia flage isEnd na true.
  *
  * @param r Referencja do mapy glownej (korzenia drzewa).
  * @param end Flaga okreslajaca, czy tworzymy iterator konca.
  */
-EnergyTree::Iterator::Iterator(std::map<int, std::unique_ptr<YearNode>>& r, bool end) : isEnd(end) {
+EnergyTree::Iterator::Iterator(const YearMap& r, bool end) : isEnd(end) {
     yIt = r.begin(); yEnd = r.end();
 
     // Obsluga pustego drzewa lub zadania iteratora end
     if (isEnd || yIt == yEnd) { isEnd = true; return; }
 
     // Inicjalizacja iteratorow w dol hierarchii
-    mIt = yIt->second->months.begin(); mEnd = yIt->second->months.end();
-    dIt = mIt->second->days.begin(); dEnd = mIt->second->days.end();
-    qIt = dIt->second->quarters.begin(); qEnd = dIt->second->quarters.end();
-    vIt = qIt->second->measurements.begin(); vEnd = qIt->second->measurements.end();
+    enterYear();
+}
+
+/**
+ * @brief Konstruktor iteratora zakresowego.
+ *
+ * Na kazdym poziomie drzewa wyszukuje (lower_bound) wezel o kluczu daty
+ * poczatkowej. Jesli wezel o dokladnie takim kluczu nie istnieje, iterator
+ * wchodzi na poczatek pierwszego pozniejszego wezla - wszystkie jego pomiary
+ * sa juz pozniejsze niz poczatek przedzialu. Na koniec pomijane sa pomiary
+ * z pierwszego bloku, ktore poprzedzaja poczatek przedzialu.
+ *
+ * @param r Referencja do mapy glownej (korzenia drzewa).
+ * @param from Znormalizowana data poczatku przedzialu (zrodlo kluczy).
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ */
+EnergyTree::Iterator::Iterator(const YearMap& r, const std::tm& from, time_t start, time_t end)
+    : isEnd(false), bounded(true), limit(end) {
+    int y = from.tm_year + 1900;
+    int mon = from.tm_mon + 1;
+    int d = from.tm_mday;
+    int q = from.tm_hour / 6;
+
+    yEnd = r.end();
+    yIt = r.lower_bound(y);
+    if (yIt == yEnd) { isEnd = true; return; }
+    if (yIt->first != y) { enterYear(); }
+    else {
+        const auto& months = yIt->second.months;
+        mIt = months.lower_bound(mon); mEnd = months.end();
+        if (mIt == mEnd) advanceYear();
+        else if (mIt->first != mon) enterMonth();
+        else {
+            const auto& days = mIt->second.days;
+            dIt = days.lower_bound(d); dEnd = days.end();
+            if (dIt == dEnd) advanceMonth();
+            else if (dIt->first != d) enterDay();
+            else {
+                const auto& quarters = dIt->second.quarters;
+                qIt = quarters.lower_bound(q); qEnd = quarters.end();
+                if (qIt == qEnd) advanceDay();
+                else enterQuarter();
+            }
+        }
+    }
+
+    // Pominiecie pomiarow sprzed poczatku przedzialu (tylko w pierwszych blokach)
+    while (!isEnd && time() < start) {
+        if (qIt->second.stats.last < start) advanceQuarter();
+        else ++(*this);
+    }
+}
+
+void EnergyTree::Iterator::enterYear() {
+    mIt = yIt->second.months.begin(); mEnd = yIt->second.months.end();
+    if (mIt == mEnd) advanceYear();
+    else enterMonth();
+}
+
+void EnergyTree::Iterator::enterMonth() {
+    dIt = mIt->second.days.begin(); dEnd = mIt->second.days.end();
+    if (dIt == dEnd) advanceMonth();
+    else enterDay();
+}
+
+void EnergyTree::Iterator::enterDay() {
+    qIt = dIt->second.quarters.begin(); qEnd = dIt->second.quarters.end();
+    if (qIt == qEnd) advanceDay();
+    else enterQuarter();
+}
+
+/**
+ * @brief Wejscie na pierwszy pomiar biezacego bloku.
+ *
+ * Dla iteratora zakresowego korzysta z agregatow bloku: jesli caly blok
+ * lezy za koncem przedzialu, iteracja jest konczona, a jesli caly blok
+ * miesci sie przed koncem, granica nie jest sprawdzana dla jego pomiarow.
+ */
+void EnergyTree::Iterator::enterQuarter() {
+    Metrics::add(Metrics::Counter::ITERATOR_BLOCKS);
+    leaf = &qIt->second;
+    pos = leaf->first(); loaded = false;
+    if (!leaf->valid(pos)) { advanceQuarter(); return; }
+    if (bounded) {
+        const NodeStats& st = qIt->second.stats;
+        if (st.first > limit) { isEnd = true; return; }
+        checkLimit = st.last > limit;
+        checkBound();
+    }
+}
+
+void EnergyTree::Iterator::advanceYear() {
+    if (++yIt != yEnd) enterYear();
+    else isEnd = true; // Koniec danych w drzewie
+}
+
+void EnergyTree::Iterator::advanceMonth() {
+    if (++mIt != mEnd) enterMonth();
+    else advanceYear();
+}
+
+void EnergyTree::Iterator::advanceDay() {
+    if (++dIt != dEnd) enterDay();
+    else advanceMonth();
+}
+
+void EnergyTree::Iterator::advanceQuarter() {
+    if (++qIt != qEnd) enterQuarter();
+    else advanceDay();
+}
+
+void EnergyTree::Iterator::checkBound() {
+    if (bounded && checkLimit && time() > limit) isEnd = true;
 }
 
 /**
  * @brief Operator pre-inkrementacji iteratora (++it).
  *
- * Odpowiada za przejscie do nastepnego pomiaru. Posiada zlozona logike
- * wyjscia z zagniezdzen:
- * 1. Przesuwa iterator wektora pomiarow.
- * 2. Jesli wektor sie skonczyl, przechodzi do nastepnego kwadransa.
+ * Odpowiada za przejscie do nastepnego pomiaru:
+ * 1. Przesuwa pozycje w biezacym lisciu (nastepny zajety slot lub pomiar spoza siatki).
+ * 2. Jesli lisc sie skonczyl, przechodzi do nastepnego kwadransa.
  * 3. Jesli kwadransy sie skonczyly, szuka nastepnego dnia, miesiaca lub roku.
+ * Dla iteratora zakresowego konczy iteracje po przekroczeniu konca przedzialu.
  *
  * @return EnergyTree::Iterator& Referencja do zaktualizowanego iteratora.
  */
 EnergyTree::Iterator& EnergyTree::Iterator::operator++() {
-    // 1. Probuj przesunac wewnatrz biezacego wektora pomiarow
-    if (++vIt != vEnd) return *this;
-
-    // 2. Probuj przesunac na nastepny kwadrans w biezacym dniu
-    if (++qIt != qEnd) {
-        vIt = qIt->second->measurements.begin();
-        vEnd = qIt->second->measurements.end();
-        return *this;
-    }
-
-    // Lambda pomocnicza do szukania nastepnego niepustego wezla wyzszego rzedu
-    auto nextDay = [&]() {
-        // Sprawdz kolejne dni
-        if (++dIt != dEnd) {
-            qIt = dIt->second->quarters.begin();
-            qEnd = dIt->second->quarters.end();
-            return true;
-        }
-        // Sprawdz kolejne miesiace
-        if (++mIt != mEnd) {
-            dIt = mIt->second->days.begin();
-            dEnd = mIt->second->days.end();
-            return true;
-        }
-        // Sprawdz kolejne lata
-        if (++yIt != yEnd) {
-            mIt = yIt->second->months.begin();
-            mEnd = yIt->second->months.end();
-            return true;
-        }
-        return false; // Koniec danych w drzewie
-        };
-
-    // 3. Szukaj danych w kolejnych wezlach (dzien -> miesiac -> rok)
-    while (nextDay()) {
-        if (!dIt->second->quarters.empty()) {
-            qIt = dIt->second->quarters.begin(); qEnd = dIt->second->quarters.end();
-            vIt = qIt->second->measurements.begin(); vEnd = qIt->second->measurements.end();
-            return *this;
-        }
-    }
-
-    // Jesli nic nie znaleziono, ustaw flage konca
-    isEnd = true;
+    // 1. Probuj przesunac wewnatrz biezacego liscia
+    loaded = false;
+    leaf->next(pos);
+    if (leaf->valid(pos)) checkBound();
+    // 2-3. Szukaj danych w kolejnych wezlach (kwadrans -> dzien -> miesiac -> rok)
+    else advanceQuarter();
     return *this;
-}
\ No newline at end of file
+}
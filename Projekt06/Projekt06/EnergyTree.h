@@ -12,6 +12,47 @@
 #define ENERGYTREE_H
 
 #include "TreeStructure.h"
+#include <algorithm>
+#include <utility>
+
+class ThreadPool;
+
+/**
+ * @brief Rozdzielczosc szeregu czasowego zwracanego przez EnergyTree::series.
+ *
+ * Kolejnosc wartosci odpowiada rosnacej szerokosci przedzialu (kubelka).
+ */
+enum class Resolution {
+    RAW,    /**< Pojedyncze pomiary (co 15 minut). */
+    HOUR,   /**< Kubelki godzinowe. */
+    DAY,    /**< Kubelki dobowe. */
+    MONTH   /**< Kubelki miesieczne. */
+};
+
+/**
+ * @struct TreeShape
+ * @brief Liczby wezlow na poziomach drzewa i rozklad rozmiarow blokow (wynik EnergyTree::shape).
+ */
+struct TreeShape {
+    std::size_t years = 0;                  /**< Liczba wezlow roku. */
+    std::size_t months = 0;                 /**< Liczba wezlow miesiaca. */
+    std::size_t days = 0;                   /**< Liczba wezlow dnia. */
+    std::size_t leaves = 0;                 /**< Liczba blokow 6-godzinnych (QuarterNode). */
+    std::size_t measurements = 0;           /**< Liczba pomiarow. */
+    std::size_t overflow = 0;               /**< Pomiary spoza siatki 15-minutowej (listy nadmiarowe). */
+    std::vector<std::size_t> leafSizes;     /**< Liczba blokow wg liczby pomiarow (indeks = liczba pomiarow). */
+};
+
+/**
+ * @struct SeriesPoint
+ * @brief Punkt szeregu zagregowanego - agregaty pomiarow jednego kubelka.
+ *
+ * Srednia pola to stats.fields[i].sum / stats.count.
+ */
+struct SeriesPoint {
+    time_t start = 0;   /**< Poczatek kubelka (pelna godzina, polnoc lub pierwszy dzien miesiaca). */
+    NodeStats stats;    /**< Liczba pomiarow oraz suma, minimum i maksimum kazdego pola. */
+};
 
  /**
   * @class EnergyTree
@@ -21,19 +62,73 @@
   * bezposrednio na wezlach (YearNode, MonthNode itd.), uzytkownik korzysta
   * z metod tej klasy do dodawania pomiarow oraz iterowania po nich.
   * Wewnetrznie dane sa zorganizowane w mapie, gdzie kluczem jest rok.
+  *
+  * Wszystkie wezly (wraz z wezlami map i kolumnami nadmiarowymi lisci) sa
+  * alokowane z areny drzewa (std::pmr::monotonic_buffer_resource): kolejne
+  * wezly leza obok siebie w duzych blokach pamieci, a wstawienie nowego
+  * wezla nie wywoluje malloc. Pamiec nie jest zwalniana pojedynczo - clear()
+  * i destruktor oddaja cala arene naraz, bez przechodzenia po wezlach.
   */
 class EnergyTree {
 private:
+    /** @brief Rozmiar pierwszego bloku areny w bajtach (kolejne bloki sa coraz wieksze). */
+    static constexpr std::size_t ARENA_CHUNK = 64 * 1024;
+
+    /** @brief Arena, z ktorej pochodzi cala pamiec drzewa (na stercie, aby przeniesienie drzewa nie zmienialo jej adresu). */
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+
     /**
-     * @brief Korzen struktury - mapa lat.
+     * @brief Korzen struktury - mapa lat (utworzona w arenie).
      *
      * Klucz: numer roku (int).
-     * Wartosc: unikalny wskaznik do wezla roku (YearNode).
+     * Wartosc: wezel roku (YearNode).
      * Dzieki uzyciu std::map dane sa automatycznie posortowane chronologicznie.
      */
-    std::map<int, std::unique_ptr<YearNode>> root;
+    YearMap* root = nullptr;
+
+    /** @brief Licznik zapisow - zwiekszany przy kazdym dodanym pomiarze i przy czyszczeniu. */
+    std::uint64_t writes = 0;
+
+    /** @brief Numer zapisu, w ktorym drzewo zostalo ostatnio wyczyszczone. */
+    std::uint64_t clearedAt = 0;
+
+    /** @brief Tworzy pusta mape lat w arenie. */
+    YearMap* newRoot() { return std::pmr::polymorphic_allocator<>(arena.get()).new_object<YearMap>(); }
 
 public:
+    /** @brief Tworzy puste drzewo z wlasna arena. */
+    EnergyTree() : arena(std::make_unique<std::pmr::monotonic_buffer_resource>(ARENA_CHUNK)), root(newRoot()) {}
+
+    /**
+     * @brief Konstruktor przenoszacy - przejmuje arene (wezly nie sa kopiowane).
+     *
+     * Przeniesiony obiekt moze byc juz tylko zniszczony lub nadpisany przypisaniem.
+     *
+     * @param other Przenoszone drzewo.
+     */
+    EnergyTree(EnergyTree&& other) noexcept
+        : arena(std::move(other.arena)), root(std::exchange(other.root, nullptr)), writes(other.writes), clearedAt(other.clearedAt) {}
+
+    /**
+     * @brief Przypisanie przenoszace - zwalnia wlasna arene i przejmuje arene other.
+     *
+     * Licznik zapisow nie cofa sie, a przejecie dziala jak clear - wyniki
+     * zapamietane przez Analyzer dla tego obiektu (unchangedSince) traca waznosc.
+     *
+     * @param other Przenoszone drzewo.
+     * @return EnergyTree& Referencja do tego obiektu.
+     */
+    EnergyTree& operator=(EnergyTree&& other) noexcept {
+        arena = std::move(other.arena);
+        root = std::exchange(other.root, nullptr);
+        writes = std::max(writes, other.writes) + 1;
+        clearedAt = writes;
+        return *this;
+    }
+
+    EnergyTree(const EnergyTree&) = delete;
+    EnergyTree& operator=(const EnergyTree&) = delete;
+
     /**
      * @brief Dodaje nowy pomiar do drzewa.
      *
@@ -47,34 +142,223 @@ public:
      */
     bool addMeasurement(std::unique_ptr<Measurement> m);
 
+    /**
+     * @brief Dodaje kopie pomiaru do drzewa.
+     *
+     * Wariant bez alokacji - wartosci pomiaru sa kopiowane do kolumn liscia,
+     * wiec wywolujacy moze uzyc obiektu tymczasowego (np. na stosie).
+     *
+     * @param m Dodawany pomiar.
+     * @return bool Zwraca true, jesli pomiar zostal dodany, false dla duplikatu.
+     */
+    bool addMeasurement(const Measurement& m);
+
+    /**
+     * @brief Dodaje do drzewa paczke pomiarow posortowanych rosnaco wg czasu.
+     *
+     * Buduje wezly roku, miesiaca, dnia i kwadransa w jednym liniowym
+     * przejsciu: dopoki kolejne pomiary trafiaja do tego samego bloku,
+     * nie sa wykonywane zadne wyszukiwania w mapach, a nowe wezly sa
+     * wstawiane z podpowiedzia pozycji (koniec mapy). Agregaty wezlow
+     * nadrzednych sa aktualizowane raz na blok, a nie raz na pomiar.
+     * Duplikaty sa wykrywane miedzy sasiednimi pomiarami paczki oraz
+     * wzgledem danych juz obecnych w drzewie. Pomiar naruszajacy porzadek
+     * jest dodawany zwyklym addMeasurement (wynik pozostaje poprawny).
+     *
+     * @param batch Pomiary posortowane rosnaco wg epochTime().
+     * @param duplicates Opcjonalnie: indeksy pomiarow odrzuconych jako duplikaty.
+     * @return std::size_t Liczba dodanych pomiarow.
+     */
+    std::size_t bulkLoad(const std::vector<Measurement>& batch, std::vector<std::size_t>* duplicates = nullptr);
+
+    /**
+     * @brief Oblicza agregaty pomiarow z przedzialu czasu [start, end].
+     *
+     * Wezly calkowicie pokryte przez przedzial sa dolaczane w calosci na
+     * podstawie ich zapamietanych agregatow (NodeStats), bez odwiedzania
+     * pomiarow. Pomiary sa przegladane pojedynczo tylko w blokach brzegowych,
+     * ktore przedzial przecina czesciowo.
+     *
+     * Z pula watkow miesiace brzegowe sa przetwarzane rownolegle; wynik jest
+     * identyczny jak bez puli (stala kolejnosc laczenia partycji).
+     *
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki (Measurement::toEpoch).
+     * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+     * @param pool Opcjonalna pula watkow (nie moze to byc pula, na ktorej wykonuje sie wywolanie).
+     * @return NodeStats Agregaty (liczba, suma, min, max) dla wszystkich pol.
+     */
+    NodeStats aggregate(time_t start, time_t end, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Oblicza agregaty wielu przedzialow czasu jednym przejsciem po drzewie.
+     *
+     * Rownowazne wywolaniu aggregate dla kazdego przedzialu, ale kazdy wezel
+     * jest odwiedzany co najwyzej raz: granice wszystkich przedzialow sa
+     * sortowane, a drzewo rozwijane tylko tam, gdzie wezel przecina ktoras
+     * z nich. Przeznaczone dla raportow porownujacych wiele okresow naraz.
+     *
+     * @param ranges Pary (poczatek, koniec) - przedzialy wlacznie, sekundy od epoki.
+     * @return std::vector<NodeStats> Agregaty w kolejnosci przedzialow wejsciowych.
+     */
+    std::vector<NodeStats> aggregateMany(const std::vector<std::pair<time_t, time_t>>& ranges) const;
+
+    /**
+     * @brief Zwraca szkic kwantyli pola dla przedzialu czasu [start, end].
+     *
+     * Szkice wezlow miesiaca i roku sa utrzymywane przy wstawianiu
+     * (addMeasurement, bulkLoad), wiec zapytanie laczy szkice wezlow
+     * calkowicie pokrytych, a pojedyncze wartosci czyta tylko z blokow
+     * miesiecy brzegowych (dni nie maja szkicow - tablica licznikow dnia
+     * bylaby wieksza od jego 96 pomiarow). Wynik jest taki sam, jak szkic
+     * zbudowany ze wszystkich pomiarow przedzialu.
+     *
+     * @param type Typ danych (pole pomiaru).
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+     * @return QuantileSketch Szkic do odczytu kwantyli (QuantileSketch::quantile).
+     */
+    QuantileSketch sketch(DataType type, time_t start, time_t end) const;
+
+    /**
+     * @brief Wyszukuje pomiary z przedzialu czasu, w ktorych pole miesci sie w [lo, hi].
+     *
+     * Odwiedzane sa tylko bloki przecinajace przedzial czasu, a wezly, w ktorych
+     * zakres wartosci pola (NodeStats min/max) nie przecina [lo, hi], sa
+     * pomijane bez schodzenia nizej. W kazdym bloku
+     * kolumna wskazanego pola jest porownywana z granicami petla wektorowa
+     * (SimdKernels), a obiekty Measurement sa odtwarzane wylacznie dla trafien.
+     * Z pula watkow kazdy miesiac jest przegladany jako osobne zadanie.
+     *
+     * @param type Typ danych (pole pomiaru).
+     * @param lo Dolna granica wartosci (wlacznie).
+     * @param hi Gorna granica wartosci (wlacznie).
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+     * @param pool Opcjonalna pula watkow (nie moze to byc pula, na ktorej wykonuje sie wywolanie).
+     * @return std::vector<Measurement> Znalezione pomiary w porzadku chronologicznym (puste dla nieznanego typu).
+     */
+    std::vector<Measurement> find(DataType type, double lo, double hi, time_t start, time_t end, ThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Zwraca szereg zagregowany (downsampling) dla przedzialu [start, end].
+     *
+     * Kubelki dobowe i miesieczne to agregaty wezlow dnia i miesiaca,
+     * aktualizowane na biezaco przy kazdym dodanym pomiarze - wezel
+     * calkowicie pokryty przez przedzial daje punkt bez odwiedzania pomiarow.
+     * Kubelki godzinowe powstaja z czterech slotow liscia (maska slotow
+     * i SimdKernels), a kubelki przeciete granica przedzialu obejmuja tylko
+     * pomiary z przedzialu. Liczba odwiedzanych wezlow jest wiec
+     * proporcjonalna do liczby zwroconych punktow, a nie pomiarow.
+     * Puste kubelki sa pomijane.
+     *
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+     * @param res Rozdzielczosc kubelkow.
+     * @return std::vector<SeriesPoint> Punkty w porzadku chronologicznym.
+     */
+    std::vector<SeriesPoint> series(time_t start, time_t end, Resolution res) const;
+
+    /**
+     * @brief Zwraca agregaty wszystkich pomiarow drzewa (polaczone agregaty lat).
+     * @return NodeStats Agregaty calego drzewa.
+     */
+    NodeStats totals() const;
+
+    /**
+     * @brief Zlicza wezly kazdego poziomu oraz pomiary w blokach.
+     *
+     * Przeglada wszystkie wezly (bez pomiarow) - koszt proporcjonalny do
+     * liczby blokow; przeznaczone do diagnostyki (Metrics::stats).
+     *
+     * @return TreeShape Ksztalt drzewa.
+     */
+    TreeShape shape() const;
+
     /**
      * @brief Czysci cala zawartosc drzewa.
      *
      * Usuwa wszystkie wezly i zwalnia pamiec. Po wywolaniu tej metody
-     * kontener jest pusty.
+     * kontener jest pusty. Pamiec jest oddawana calymi blokami areny,
+     * bez odwiedzania wezlow - koszt nie zalezy od liczby pomiarow.
      */
-    void clear() { root.clear(); }
+    void clear();
+
+    /**
+     * @brief Zwraca biezacy numer zapisu drzewa.
+     *
+     * Kazdy dodany pomiar oznacza swoj wezel roku i miesiaca kolejnym
+     * numerem zapisu. Zapamietany numer pozwala pozniej sprawdzic
+     * (unchangedSince), czy dane z danego przedzialu mogly sie zmienic.
+     *
+     * @return std::uint64_t Numer ostatniego zapisu.
+     */
+    std::uint64_t epoch() const { return writes; }
+
+    /**
+     * @brief Sprawdza, czy zaden wezel przecinajacy przedzial nie zmienil sie po zapisie epoch.
+     *
+     * Sprawdzane sa numery zapisu lat z przedzialu, a dla lat zmienionych -
+     * miesiecy z przedzialu. Zmiany w innych miesiacach nie uniewazniaja
+     * wyniku; wyczyszczenie drzewa uniewaznia wszystko.
+     *
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+     * @param epoch Numer zapisu z chwili obliczenia wyniku (epoch()).
+     * @return bool True, jesli wynik zapytania o przedzial jest nadal aktualny.
+     */
+    bool unchangedSince(time_t start, time_t end, std::uint64_t epoch) const;
 
     /**
      * @class Iterator
      * @brief Iterator pozwalajacy na liniowe przejscie po wszystkich pomiarach.
      *
      * Iterator ten ukrywa skomplikowana, zagniezdzona strukture drzewa
-     * (Rok -> Miesiac -> Dzien -> Kwadrans -> Wektor Pomiarow).
+     * (Rok -> Miesiac -> Dzien -> Kwadrans -> Kolumny Pomiarow).
      * Umozliwia uzycie petli for-each lub standardowych algorytmow STL
      * na obiekcie EnergyTree tak, jakby byl to plaski kontener.
+     * Iterator moze byc ograniczony do przedzialu czasu (zob. EnergyTree::range) -
+     * wtedy startuje od pierwszego pomiaru w przedziale i konczy sie zaraz
+     * po przekroczeniu jego konca.
      */
     class Iterator {
         // Iteratory dla poszczegolnych poziomow zagniezdzenia
-        std::map<int, std::unique_ptr<YearNode>>::iterator yIt, yEnd;
-        std::map<int, std::unique_ptr<MonthNode>>::iterator mIt, mEnd;
-        std::map<int, std::unique_ptr<DayNode>>::iterator dIt, dEnd;
-        std::map<int, std::unique_ptr<QuarterNode>>::iterator qIt, qEnd;
-        std::vector<std::unique_ptr<Measurement>>::iterator vIt, vEnd;
+        YearMap::const_iterator yIt, yEnd;
+        MonthMap::const_iterator mIt, mEnd;
+        DayMap::const_iterator dIt, dEnd;
+        QuarterMap::const_iterator qIt, qEnd;
+
+        // Pozycja w biezacym lisciu (slot siatki lub lista nadmiarowa)
+        const QuarterNode* leaf = nullptr;
+        QuarterNode::Position pos;
+
+        // Pomiar odtwarzany z kolumn dopiero przy dereferencji
+        mutable Measurement current;
+        mutable bool loaded = false;
 
         // Flaga oznaczajaca koniec iteracji
         bool isEnd;
 
+        // Gorna granica czasu (wlacznie) dla iteratora zakresowego
+        bool bounded = false;
+        time_t limit = 0;
+        // Czy w biezacym bloku trzeba sprawdzac granice dla kazdego pomiaru
+        bool checkLimit = false;
+
+        // Wejscie na pierwszy element wezla danego poziomu
+        void enterYear();
+        void enterMonth();
+        void enterDay();
+        void enterQuarter();
+
+        // Przejscie do nastepnego wezla danego poziomu (lub wyzej, gdy poziom sie skonczyl)
+        void advanceYear();
+        void advanceMonth();
+        void advanceDay();
+        void advanceQuarter();
+
+        // Sprawdzenie gornej granicy dla biezacego pomiaru
+        void checkBound();
+
     public:
         /**
          * @brief Konstruktor iteratora.
@@ -86,26 +370,62 @@ public:
          * @param r Referencja do korzenia drzewa (mapy lat).
          * @param end Flaga okreslajaca, czy tworzymy iterator begin (false) czy end (true).
          */
-        Iterator(std::map<int, std::unique_ptr<YearNode>>& r, bool end);
+        Iterator(const YearMap& r, bool end);
+
+        /**
+         * @brief Konstruktor iteratora zakresowego.
+         *
+         * Pozycjonuje iterator na pierwszym pomiarze nie wczesniejszym niz
+         * from, schodzac po kluczach (rok, miesiac, dzien, kwadrans) za pomoca
+         * std::map::lower_bound - bez przegladania wczesniejszych danych.
+         * Iteracja konczy sie po pierwszym pomiarze pozniejszym niz end.
+         *
+         * @param r Referencja do korzenia drzewa (mapy lat).
+         * @param from Znormalizowana data poczatku przedzialu.
+         * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+         * @param end Koniec przedzialu (wlacznie), sekundy od epoki.
+         */
+        Iterator(const YearMap& r, const std::tm& from, time_t start, time_t end);
 
         /**
          * @brief Operator dereferencji.
+         *
+         * Pomiary sa przechowywane kolumnowo, wiec zwracany jest widok -
+         * obiekt Measurement odtworzony z kolumn biezacego liscia (tylko raz
+         * na pozycje, przy pierwszym odwolaniu).
+         *
          * @return const Measurement& Referencja do biezacego pomiaru.
          */
-        const Measurement& operator*() const { return *(*vIt); }
+        const Measurement& operator*() const {
+            if (!loaded) { current = leaf->at(pos); loaded = true; }
+            return current;
+        }
 
         /**
          * @brief Operator dostepu do skladowych (strzalka).
          * @return const Measurement* Wskaznik do biezacego pomiaru.
          */
-        const Measurement* operator->() const { return vIt->get(); }
+        const Measurement* operator->() const { return &**this; }
+
+        /**
+         * @brief Zwraca czas biezacego pomiaru bez odtwarzania obiektu Measurement.
+         * @return time_t Sekundy od epoki.
+         */
+        time_t time() const { return leaf->time(pos); }
+
+        /**
+         * @brief Zwraca wartosc pola biezacego pomiaru bezposrednio z kolumny.
+         * @param type Typ danych.
+         * @return double Wartosc pola.
+         */
+        double value(DataType type) const { return leaf->value(pos, type); }
 
         /**
          * @brief Operator pre-inkrementacji (++it).
          *
-         * Przesuwa iterator na nastepny element. Jesli wektor w biezacym wezle
+         * Przesuwa iterator na nastepny element. Jesli kolumny w biezacym wezle
          * sie skonczyl, przechodzi do nastepnego kwadransa, dnia, miesiaca lub roku,
-         * az znajdzie kolejne dane lub osiagnie koniec struktury.
+         * az znajdzie kolejne dane lub osiagnie koniec struktury (albo koniec zakresu).
          *
          * @return Iterator& Referencja do zaktualizowanego iteratora.
          */
@@ -119,17 +439,55 @@ public:
         bool operator!=(const Iterator& other) const { return isEnd != other.isEnd; }
     };
 
+    /**
+     * @class Range
+     * @brief Widok na pomiary z zadanego przedzialu czasu.
+     *
+     * Para iteratorow (poczatek, koniec) zwracana przez EnergyTree::range,
+     * umozliwiajaca uzycie petli for-each wylacznie po pomiarach z przedzialu.
+     */
+    class Range {
+        Iterator first, last;
+    public:
+        /**
+         * @brief Konstruktor widoku.
+         * @param b Iterator pierwszego pomiaru w przedziale.
+         * @param e Iterator konca.
+         */
+        Range(Iterator b, Iterator e) : first(b), last(e) {}
+
+        /** @brief Zwraca iterator pierwszego pomiaru w przedziale. */
+        Iterator begin() const { return first; }
+
+        /** @brief Zwraca iterator konca przedzialu. */
+        Iterator end() const { return last; }
+    };
+
     /**
      * @brief Zwraca iterator wskazujacy na pierwszy element drzewa.
      * @return Iterator Iterator begin.
      */
-    Iterator begin() { return Iterator(root, false); }
+    Iterator begin() const { return Iterator(*root, false); }
 
     /**
      * @brief Zwraca iterator wskazujacy na koniec zakresu (za ostatnim elementem).
      * @return Iterator Iterator end.
      */
-    Iterator end() { return Iterator(root, true); }
+    Iterator end() const { return Iterator(*root, true); }
+
+    /**
+     * @brief Zwraca widok na pomiary z przedzialu [start, end].
+     *
+     * Iterator poczatkowy jest pozycjonowany bezposrednio na pierwszym
+     * pomiarze przedzialu (std::map::lower_bound na kazdym poziomie), a
+     * iteracja konczy sie zaraz za koncem przedzialu. Koszt zalezy wiec od
+     * liczby zwroconych pomiarow, a nie od rozmiaru calego drzewa.
+     *
+     * @param start Data poczatkowa (wlacznie).
+     * @param end Data koncowa (wlacznie).
+     * @return Range Widok z metodami begin() i end().
+     */
+    Range range(std::tm start, std::tm end) const;
 };
 
 #endif
\ No newline at end of file
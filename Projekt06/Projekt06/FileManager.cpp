@@ -9,15 +9,22 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "FileManager.h"
+#include "MappedFile.h"
+#include "CsvParser.h"
+#include "ThreadPool.h"
+#include "BinaryArchive.h"
+#include "IngestLog.h"
+#include "Metrics.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
  /**
   * @brief Generuje biezacy znacznik czasowy jako lancuch znakow.
   *
   * Funkcja pomocnicza uzywana do tworzenia unikalnych nazw plikow logow.
   * Pobiera aktualny czas systemowy i formatuje go w postaci "RRRRMMDD_GGMMSS".
-  * Korzysta z bezpiecznej funkcji localtime_s (standard MSVC/C11).
+  * Korzysta z bezpiecznej funkcji localtime_s (MSVC) lub localtime_r (POSIX).
   *
   * @return std::string Znacznik czasu, np. "20231027_153000". W przypadku bledu zwraca "00000000_000000".
   */
@@ -25,120 +32,281 @@ std::string FileManager::getTimestampStr() {
     auto t = std::time(nullptr);
     std::tm tm;
 
+#ifdef _WIN32
     // localtime_s zwraca 0 w przypadku sukcesu (standard MSVC)
     if (localtime_s(&tm, &t) != 0) {
         return "00000000_000000"; // Fallback w razie bledu
     }
+#else
+    if (localtime_r(&t, &tm) == nullptr) {
+        return "00000000_000000"; // Fallback w razie bledu
+    }
+#endif
 
     std::ostringstream oss;
     oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
     return oss.str();
 }
 
+namespace {
+    /** @brief Opis bledu: pusta linia w pliku. */
+    constexpr const char* ERR_EMPTY = "Pusta linia";
+    /** @brief Opis bledu: pomiar o tej samej dacie jest juz w drzewie. */
+    constexpr const char* ERR_DUPLICATE = "Duplikat";
+
+    /** @brief Zwraca rozmiar pliku w bajtach (0, gdy pliku nie ma). */
+    std::uint64_t fileSize(const std::string& filename) {
+        std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+        return ifs ? static_cast<std::uint64_t>(ifs.tellg()) : 0;
+    }
+
+    /**
+     * @brief Wynik parsowania jednej linii w trybie wielowatkowym.
+     */
+    struct ParsedLine {
+        std::string_view line;  /**< Tresc linii (widok na odwzorowany plik). */
+        const char* error;      /**< nullptr lub opis bledu parsowania. */
+    };
+
+    /**
+     * @brief Wynik parsowania jednego fragmentu pliku.
+     *
+     * Poprawne pomiary sa zbierane w osobnej paczce (w kolejnosci pliku),
+     * ktora jest dolaczana do drzewa jednym wywolaniem EnergyTree::bulkLoad.
+     */
+    struct ParsedChunk {
+        std::vector<ParsedLine> lines;      /**< Wszystkie linie fragmentu. */
+        std::vector<Measurement> records;   /**< Pomiary z linii bez bledu parsowania. */
+    };
+
+    /**
+     * @brief Pomija znacznik BOM i naglowek, wykrywajac separator kolumn.
+     *
+     * @param data Zawartosc pliku (BOM jest usuwany z widoku).
+     * @param pos Pozycja za naglowkiem.
+     * @return char Separator kolumn.
+     */
+    char skipHeader(std::string_view& data, std::size_t& pos) {
+        // Pominiecie znacznika BOM (UTF-8)
+        if (data.substr(0, 3) == "\xEF\xBB\xBF") data.remove_prefix(3);
+        pos = 0;
+        if (data.empty()) return ',';
+        return CsvParser::detectSeparator(CsvParser::nextLine(data, pos)); // Pomin naglowek
+    }
+
+    /**
+     * @brief Uzupelnia wynik importu o przesuniecie za ostatnia pelna linia pliku i separator.
+     *
+     * Niepelna linia na koncu pliku (w trakcie zapisu) nie jest wliczana,
+     * wiec CsvFollower ustawiony na to przesuniecie przeczyta ja po dokonczeniu.
+     */
+    IngestLog::Totals withPosition(IngestLog::Totals totals, std::string_view file, char sep) {
+        std::size_t complete = file.rfind('\n');
+        totals.consumed = complete == std::string_view::npos ? 0 : complete + 1;
+        totals.separator = sep;
+        return totals;
+    }
+}
+
 /**
  * @brief Wczytuje dane pomiarowe z pliku CSV do drzewa.
  *
- * Funkcja otwiera plik CSV, pomija pierwszy wiersz (naglowek) i parsuje kolejne linie.
+ * Plik jest odwzorowywany w pamieci (MappedFile), a linie sa parsowane
+ * bezposrednio z bufora systemu, bez kopiowania do obiektow std::string
+ * i bez alokacji na kazda linie. Pierwszy wiersz (naglowek) jest pomijany
+ * i sluzy do wykrycia separatora (przecinek lub srednik).
  * Dla kazdej linii:
- * 1. Rozdziela dane separatorem srednika (;).
+ * 1. Rozdziela pola z obsluga cudzyslowow (CsvParser::parseLine).
  * 2. Konwertuje date i czas oraz wartosci liczbowe (double).
- * 3. Tworzy obiekt Measurement i probuje dodac go do EnergyTree.
+ * 3. Dodaje pomiar do EnergyTree.
  *
- * Podczas dzialania tworzone sa dwa pliki logow z unikalnym znacznikiem czasu:
- * - log_DATA_CZAS.txt: Zawiera informacje o kazdej przetworzonej linii (sukces lub blad).
- * - log_error_DATA_CZAS.txt: Zawiera wylacznie informacje o bledach (np. bledny format, duplikat).
+ * Przebieg importu jest rejestrowany przez IngestLog (pliki log_DATA_CZAS.txt
+ * i log_error_DATA_CZAS.txt zapisywane w tle). Domyslnie zapisywane sa
+ * tylko probki bledow i podsumowanie; wpisy "OK:" dla kazdej linii
+ * wymagaja poziomu IngestLog::Level::ALL.
  *
  * @param tree Referencja do drzewa, do ktorego beda dodawane pomiary.
  * @param filename Sciezka do pliku CSV.
+ * @param log Ustawienia dziennika importu.
+ * @return IngestLog::Totals Liczby linii poprawnych i odrzuconych oraz przetworzone bajty pliku.
  */
-void FileManager::loadCSV(EnergyTree& tree, const std::string& filename) {
-    std::ifstream file(filename);
-    std::string ts = getTimestampStr();
-    std::ofstream logAll("log_" + ts + ".txt");
-    std::ofstream logErr("log_error_" + ts + ".txt");
-
-    int valid = 0, invalid = 0;
-    std::string line;
-    std::getline(file, line); // Pomin naglowek
-
-    while (std::getline(file, line)) {
-        if (line.empty()) { invalid++; continue; }
-        std::stringstream ss(line);
-        std::string part;
-        std::vector<std::string> parts;
-        // Rozdzielanie linii po srednikach
-        while (std::getline(ss, part, ';')) parts.push_back(part);
-
-        try {
-            // Sprawdzenie czy linia ma wystarczajaca liczbe kolumn
-            if (parts.size() < 6) throw std::runtime_error("Niepelna linia");
-
-            auto m = std::make_unique<Measurement>();
-            std::stringstream dss(parts[0]);
-            char d;
-            // Parsowanie formatu daty: DD.MM.RRRR GG:MM
-            dss >> m->timestamp.tm_mday >> d >> m->timestamp.tm_mon >> d >> m->timestamp.tm_year >> m->timestamp.tm_hour >> d >> m->timestamp.tm_min;
-
-            // Korekta dla struktury std::tm
-            m->timestamp.tm_mon -= 1;   // Miesiace 0-11
-            m->timestamp.tm_year -= 1900; // Lata od 1900
-
-            // Konwersja wartosci liczbowych
-            m->autoconsumption = std::stod(parts[1]);
-            m->exportEnergy = std::stod(parts[2]);
-            m->importEnergy = std::stod(parts[3]);
-            m->consumption = std::stod(parts[4]);
-            m->production = std::stod(parts[5]);
-
-            // Proba dodania do drzewa (zwraca false jesli duplikat daty)
-            if (tree.addMeasurement(std::move(m))) {
-                valid++;
-                logAll << "OK: " << line << "\n";
-            }
-            else {
-                throw std::runtime_error("Duplikat");
-            }
+IngestLog::Totals FileManager::loadCSV(EnergyTree& tree, const std::string& filename, const IngestLog::Options& log) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        if (!log.quiet) std::cout << "Nie mozna otworzyc pliku: " << filename << "\n";
+        return {};
+    }
+
+    IngestLog report(getTimestampStr(), log);
+    std::string_view data = file.view();
+    Metrics::add(Metrics::Counter::BYTES_READ, data.size());
+    std::size_t pos;
+    char sep = skipHeader(data, pos);
+
+    Measurement m;
+    while (pos < data.size()) {
+        std::string_view line = CsvParser::nextLine(data, pos);
+        if (line.empty()) { report.error(ERR_EMPTY, line); continue; }
+
+        const char* error = CsvParser::parseLine(line, sep, m);
+        // Proba dodania do drzewa (zwraca false jesli duplikat daty)
+        if (!error && !tree.addMeasurement(m)) error = ERR_DUPLICATE;
+        report.record(line, error);
+    }
+    report.finish();
+    if (!log.quiet) std::cout << "Wczytano: " << report.validCount() << ", Blednych: " << report.invalidCount() << "\n";
+    return withPosition(report.totals(), file.view(), sep);
+}
+
+/**
+ * @brief Wczytuje dane pomiarowe z pliku CSV do drzewa, parsujac go wielowatkowo.
+ *
+ * Odwzorowany plik jest dzielony na fragmenty konczace sie na granicy linii.
+ * Fragmenty sa parsowane rownolegle na puli watkow do lokalnych buforow
+ * (bez dostepu do drzewa), a watek wywolujacy dolacza gotowe bufory do
+ * drzewa w kolejnosci fragmentow (EnergyTree::bulkLoad) - w trakcie, gdy
+ * kolejne fragmenty sa jeszcze parsowane. Dzieki zachowaniu kolejnosci duplikaty sa wykrywane
+ * i logowane dokladnie tak samo jak w loadCSV. Liczba fragmentow w locie
+ * jest ograniczona, wiec zuzycie pamieci nie zalezy od rozmiaru pliku.
+ *
+ * @param tree Referencja do drzewa, do ktorego beda dodawane pomiary.
+ * @param filename Sciezka do pliku CSV.
+ * @param threads Liczba watkow parsujacych; 0 oznacza liczbe rdzeni.
+ * @param log Ustawienia dziennika importu.
+ * @return IngestLog::Totals Liczby linii poprawnych i odrzuconych oraz przetworzone bajty pliku.
+ */
+IngestLog::Totals FileManager::loadCSVParallel(EnergyTree& tree, const std::string& filename, unsigned threads, const IngestLog::Options& log) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        if (!log.quiet) std::cout << "Nie mozna otworzyc pliku: " << filename << "\n";
+        return {};
+    }
+
+    IngestLog report(getTimestampStr(), log);
+    std::string_view data = file.view();
+    Metrics::add(Metrics::Counter::BYTES_READ, data.size());
+    std::size_t pos;
+    char sep = skipHeader(data, pos);
+
+    ThreadPool pool(threads);
+    const std::size_t inFlight = pool.size() * 2;
+    // Fragmenty ok. 1/8 pliku na watek, ale nie mniejsze niz 256 KB i nie wieksze niz 8 MB
+    std::size_t chunkBytes = (data.size() - pos) / (pool.size() * 8);
+    chunkBytes = std::clamp<std::size_t>(chunkBytes, 256 * 1024, 8 * 1024 * 1024);
+
+    // Parsowanie jednego fragmentu do lokalnego bufora
+    auto parseChunk = [sep](std::string_view chunk) {
+        ParsedChunk out;
+        out.lines.reserve(chunk.size() / 48 + 1);
+        out.records.reserve(chunk.size() / 48 + 1);
+        std::size_t p = 0;
+        Measurement m;
+        while (p < chunk.size()) {
+            ParsedLine pl;
+            pl.line = CsvParser::nextLine(chunk, p);
+            pl.error = pl.line.empty() ? nullptr : CsvParser::parseLine(pl.line, sep, m);
+            if (!pl.line.empty() && !pl.error) out.records.push_back(m);
+            out.lines.push_back(pl);
         }
-        catch (std::exception& e) {
-            invalid++;
-            // Logowanie bledow do obu plikow
-            logAll << "ERR: " << e.what() << " | " << line << "\n";
-            logErr << "ERR: " << e.what() << " | " << line << "\n";
+        return out;
+    };
+
+    // Zlecenie kolejnego fragmentu (konczacego sie na znaku nowej linii)
+    std::deque<std::future<ParsedChunk>> pending;
+    auto submitNext = [&]() {
+        if (pos >= data.size()) return false;
+        std::size_t stop = std::min(pos + chunkBytes, data.size());
+        std::size_t nl = data.find('\n', stop - 1);
+        stop = nl == std::string_view::npos ? data.size() : nl + 1;
+        std::string_view chunk = data.substr(pos, stop - pos);
+        pos = stop;
+        pending.push_back(pool.submit([parseChunk, chunk]() { return parseChunk(chunk); }));
+        return true;
+    };
+
+    std::vector<std::size_t> duplicates;
+    while (pending.size() < inFlight && submitNext()) {}
+    while (!pending.empty()) {
+        ParsedChunk chunk = pending.front().get();
+        pending.pop_front();
+        submitNext();
+
+        // Scalanie do drzewa w kolejnosci pliku jednym przejsciem
+        duplicates.clear();
+        tree.bulkLoad(chunk.records, &duplicates);
+
+        std::size_t record = 0, dup = 0;
+        for (const ParsedLine& pl : chunk.lines) {
+            if (pl.line.empty()) { report.error(ERR_EMPTY, pl.line); continue; }
+            const char* error = pl.error;
+            if (!error) {
+                if (dup < duplicates.size() && duplicates[dup] == record) { error = ERR_DUPLICATE; dup++; }
+                record++;
+            }
+            report.record(pl.line, error);
         }
     }
-    std::cout << "Wczytano: " << valid << ", Blednych: " << invalid << "\n";
+    report.finish();
+    if (!log.quiet) std::cout << "Wczytano: " << report.validCount() << ", Blednych: " << report.invalidCount() << "\n";
+    return withPosition(report.totals(), file.view(), sep);
 }
 
 /**
  * @brief Zapisuje stan calego drzewa do pliku binarnego.
  *
- * Wykorzystuje iterator drzewa (EnergyTree::Iterator) aby przejsc sekwencyjnie
- * przez wszystkie pomiary i wywolac na nich metode serialize().
+ * Plik jest zapisywany w formacie v2 (BinaryArchive): naglowek z sygnatura
+ * i wersja, bloki kolumnowe czasow i wartosci oraz indeks blokow.
+ * W trybie kompresji bloki sa kodowane przez TimeSeriesCodec.
  *
  * @param tree Referencja do drzewa danych.
  * @param filename Nazwa pliku wyjsciowego.
+ * @param compress Czy kompresowac bloki.
  */
-void FileManager::saveBinary(EnergyTree& tree, const std::string& filename) {
-    std::ofstream ofs(filename, std::ios::binary);
-    for (auto it = tree.begin(); it != tree.end(); ++it) it->serialize(ofs);
+void FileManager::saveBinary(EnergyTree& tree, const std::string& filename, bool compress) {
+    BinaryArchive::Codec codec = compress ? BinaryArchive::Codec::GORILLA : BinaryArchive::Codec::RAW;
+    if (!BinaryArchive::write(tree, filename, codec)) std::cout << "Nie mozna zapisac pliku: " << filename << "\n";
+    if constexpr (Metrics::ENABLED) Metrics::add(Metrics::Counter::BYTES_WRITTEN, fileSize(filename));
 }
 
 /**
  * @brief Odtwarza stan drzewa z pliku binarnego.
  *
- * Funkcja najpierw czysci biezaca zawartosc drzewa. Nastepnie w petli
- * odczytuje kolejne obiekty Measurement az do napotkania konca pliku (EOF).
- * Obiekty sa deserializowane i dodawane do struktury drzewiastej.
+ * Funkcja najpierw czysci biezaca zawartosc drzewa. Format pliku jest
+ * rozpoznawany po sygnaturze:
+ * - v2 (BinaryArchive): plik jest odwzorowywany w pamieci, a jego bloki
+ *   (skompresowane - dekodowane blok po bloku) trafiaja do drzewa bez
+ *   parsowania (BinaryArchive::loadInto).
+ * - stary format (surowe rekordy Measurement::serialize): obiekty sa
+ *   odczytywane az do konca pliku (EOF), zbierane w paczki i dodawane
+ *   przez EnergyTree::bulkLoad (plik zapisany z drzewa jest posortowany).
  *
  * @param tree Referencja do drzewa danych (zostanie wyczyszczone przed wczytaniem).
  * @param filename Nazwa pliku wejsciowego.
  */
 void FileManager::loadBinary(EnergyTree& tree, const std::string& filename) {
     tree.clear();
+    if (BinaryArchive::isArchive(filename)) {
+        BinaryArchive archive(filename);
+        if (!archive.isValid()) {
+            std::cout << "Uszkodzony plik lub nieobslugiwana wersja: " << filename << "\n";
+            return;
+        }
+        Metrics::add(Metrics::Counter::BYTES_READ, archive.fileSize());
+        if (archive.loadInto(tree) != archive.size()) std::cout << "Plik uszkodzony - wczytano czesc danych: " << filename << "\n";
+        return;
+    }
+
     std::ifstream ifs(filename, std::ios::binary);
+    if constexpr (Metrics::ENABLED) Metrics::add(Metrics::Counter::BYTES_READ, fileSize(filename));
+    constexpr std::size_t BATCH = 4096;
+    std::vector<Measurement> batch;
+    batch.reserve(BATCH);
     while (ifs.peek() != EOF) {
-        auto m = std::make_unique<Measurement>();
-        m->deserialize(ifs);
-        tree.addMeasurement(std::move(m));
+        batch.emplace_back().deserialize(ifs);
+        if (batch.size() == BATCH) {
+            tree.bulkLoad(batch);
+            batch.clear();
+        }
     }
-}
\ No newline at end of file
+    tree.bulkLoad(batch);
+}
@@ -11,6 +11,7 @@
 #define FILEMANAGER_H
 
 #include "EnergyTree.h"
+#include "IngestLog.h"
 #include <string>
 
  /**
@@ -26,32 +27,59 @@ public:
     /**
      * @brief Wczytuje dane z pliku CSV i dodaje je do drzewa.
      *
-     * Metoda parsuje plik tekstowy w formacie CSV (rozdzielany srednikami),
-     * konwertuje dane tekstowe na typy liczbowe oraz tworzy obiekty Measurement.
-     * Podczas operacji tworzone sa logi (zapisywane w osobnych plikach txt),
-     * ktore raportuja sukcesy oraz bledy parsowania dla kazdej linii.
+     * Metoda odwzorowuje plik w pamieci i parsuje go w miejscu (bez kopiowania
+     * linii) w formacie eksportu Chart_Export.csv: pola rozdzielane przecinkiem
+     * (lub srednikiem, wykrywanym z naglowka), liczby ujete w cudzyslowy.
+     * Konwertuje dane tekstowe na typy liczbowe oraz tworzy obiekty Measurement.
+     * Podczas operacji tworzone sa logi (zapisywane w osobnych plikach txt
+     * przez IngestLog), ktore raportuja bledy parsowania (pierwsze probki
+     * kazdej kategorii i podsumowanie), a na poziomie ALL rowniez sukcesy.
      *
      * @param tree Referencja do obiektu drzewa, do ktorego zostana dodane dane.
      * @param filename Sciezka do pliku zrodlowego CSV.
+     * @param log Ustawienia dziennika importu (poziom, limit probek).
+     * @return IngestLog::Totals Wynik importu (opened == false, gdy pliku nie udalo sie otworzyc).
      */
-    static void loadCSV(EnergyTree& tree, const std::string& filename);
+    static IngestLog::Totals loadCSV(EnergyTree& tree, const std::string& filename, const IngestLog::Options& log = {});
+
+    /**
+     * @brief Wczytuje dane z pliku CSV, parsujac fragmenty pliku na wielu watkach.
+     *
+     * Plik jest dzielony na granicach linii na fragmenty, ktore sa parsowane
+     * rownolegle do lokalnych buforow, a nastepnie dolaczane do drzewa
+     * w kolejnosci wystepowania w pliku. Wynik (zawartosc drzewa, logi,
+     * wykrywanie duplikatow) jest taki sam jak dla loadCSV.
+     *
+     * @param tree Referencja do obiektu drzewa, do ktorego zostana dodane dane.
+     * @param filename Sciezka do pliku zrodlowego CSV.
+     * @param threads Liczba watkow parsujacych; 0 oznacza liczbe rdzeni procesora.
+     * @param log Ustawienia dziennika importu (poziom, limit probek).
+     * @return IngestLog::Totals Wynik importu (opened == false, gdy pliku nie udalo sie otworzyc).
+     */
+    static IngestLog::Totals loadCSVParallel(EnergyTree& tree, const std::string& filename, unsigned threads = 0, const IngestLog::Options& log = {});
 
     /**
      * @brief Zapisuje (serializuje) zawartosc drzewa do pliku binarnego.
      *
-     * Zrzuca cala strukture danych do pliku w formacie binarnym.
+     * Zrzuca cala strukture danych do pliku w formacie binarnym v2
+     * (BinaryArchive): naglowek z wersja, bloki kolumnowe i indeks blokow.
      * Jest to metoda znacznie szybsza niz zapis tekstowy i pozwala na
      * zachowanie precyzji danych zmiennoprzecinkowych.
+     * Tryb kompresji (delta-of-delta dla czasow, XOR dla wartosci) znacznie
+     * zmniejsza plik dla regularnych danych 15-minutowych.
      *
      * @param tree Referencja do drzewa, ktorego stan ma zostac zapisany.
      * @param filename Sciezka do pliku docelowego.
+     * @param compress Czy kompresowac bloki danych (TimeSeriesCodec).
      */
-    static void saveBinary(EnergyTree& tree, const std::string& filename);
+    static void saveBinary(EnergyTree& tree, const std::string& filename, bool compress = false);
 
     /**
      * @brief Wczytuje (deserializuje) dane z pliku binarnego.
      *
      * Odtwarza stan drzewa na podstawie wczesniej zapisanego pliku binarnego.
+     * Obslugiwany jest format v2 (BinaryArchive) oraz starszy format
+     * surowych rekordow, rozpoznawany po braku sygnatury.
      * Przed wczytaniem obecna zawartosc drzewa jest czyszczona.
      *
      * @param tree Referencja do drzewa, ktore zostanie wypelnione danymi.
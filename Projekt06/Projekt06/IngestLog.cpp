@@ -0,0 +1,144 @@
+/**
+ * @file IngestLog.cpp
+ * @brief Implementacja dziennika importu z zapisem paczkami na osobnym watku.
+ *
+ * Plik zawiera zbieranie wpisow w paczki, przekazywanie paczek do watku
+ * zapisu, limit probek na kategorie bledu oraz zapis podsumowania.
+ */
+
+#include "IngestLog.h"
+#include "Metrics.h"
+
+/**
+ * @brief Tworzy dziennik i uruchamia watek zapisu.
+ *
+ * Dla poziomu OFF pliki nie sa tworzone, a watek nie jest uruchamiany.
+ *
+ * @param ts Znacznik czasu w nazwach plikow.
+ * @param options Ustawienia dziennika.
+ */
+IngestLog::IngestLog(const std::string& ts, const Options& options) : level(options.level), samples(options.samples) {
+    if (level == Level::OFF) return;
+    logAll.open("log_" + ts + options.suffix + ".txt");
+    logErr.open("log_error_" + ts + options.suffix + ".txt");
+    writer = std::thread([this]() { writerLoop(); });
+}
+
+/**
+ * @brief Konczy dziennik, jesli wywolujacy nie zrobil tego wczesniej.
+ */
+IngestLog::~IngestLog() {
+    finish();
+}
+
+/**
+ * @brief Rejestruje odrzucona linie.
+ *
+ * Linia jest zapisywana tylko wtedy, gdy jej kategoria nie przekroczyla
+ * jeszcze limitu probek - pozostale sa wylacznie zliczane.
+ *
+ * @param category Opis bledu.
+ * @param line Tresc linii.
+ */
+void IngestLog::error(const char* category, std::string_view line) {
+    invalid++;
+    std::size_t& count = categories[category];
+    count++;
+    if (level >= Level::ERRORS && count <= samples) append(category, line);
+}
+
+/**
+ * @brief Zwraca liczbe linii odrzuconych z podanego powodu.
+ * @param category Opis bledu.
+ * @return std::size_t Liczba linii.
+ */
+std::size_t IngestLog::categoryCount(const std::string& category) const {
+    auto it = categories.find(category);
+    return it == categories.end() ? 0 : it->second;
+}
+
+/**
+ * @brief Dopisuje wpis linii do biezacej paczki.
+ *
+ * @param category nullptr dla wpisu "OK:", w przeciwnym razie opis bledu.
+ * @param line Tresc linii.
+ */
+void IngestLog::append(const char* category, std::string_view line) {
+    if (!category) {
+        current.all.append("OK: ").append(line).push_back('\n');
+    }
+    else {
+        // Logowanie bledow do obu plikow
+        std::size_t from = current.all.size();
+        current.all.append("ERR: ").append(category).append(" | ").append(line).push_back('\n');
+        current.err.append(current.all, from, std::string::npos);
+    }
+    if (current.all.size() + current.err.size() >= BATCH_BYTES) submit();
+}
+
+/**
+ * @brief Przekazuje biezaca paczke do watku zapisu.
+ */
+void IngestLog::submit() {
+    if (current.all.empty() && current.err.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(std::move(current));
+    }
+    cv.notify_one();
+    current = Batch();
+    current.all.reserve(BATCH_BYTES);
+}
+
+/**
+ * @brief Petla watku zapisu.
+ *
+ * Pobiera paczki z kolejki i dopisuje je do plikow poza sekcja krytyczna.
+ * Konczy sie po zamknieciu dziennika i oproznieniu kolejki.
+ */
+void IngestLog::writerLoop() {
+    for (;;) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            batch = std::move(queue.front());
+            queue.pop_front();
+        }
+        logAll << batch.all;
+        logErr << batch.err;
+    }
+}
+
+/**
+ * @brief Zapisuje podsumowanie i zatrzymuje watek zapisu.
+ *
+ * Podsumowanie (liczba poprawnych i odrzuconych linii oraz liczniki
+ * kategorii, z informacja o pominietych probkach) trafia do obu plikow.
+ */
+void IngestLog::finish() {
+    if (finished) return;
+    finished = true;
+    Metrics::add(Metrics::Counter::CSV_LINES_OK, valid);
+    Metrics::add(Metrics::Counter::CSV_LINES_REJECTED, invalid);
+    for (const auto& [category, count] : categories) Metrics::reject(category, count);
+    if (level == Level::OFF) return;
+
+    std::string summary = "--- Podsumowanie: poprawnych " + std::to_string(valid) + ", blednych " + std::to_string(invalid) + " ---\n";
+    for (const auto& [category, count] : categories) {
+        summary += category + ": " + std::to_string(count);
+        if (level >= Level::ERRORS && count > samples) summary += " (zapisano " + std::to_string(samples) + " pierwszych)";
+        summary += "\n";
+    }
+    current.all += summary;
+    current.err += summary;
+    submit();
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    writer.join();
+}
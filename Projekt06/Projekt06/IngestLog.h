@@ -0,0 +1,201 @@
+/**
+ * @file IngestLog.h
+ * @brief Definicja dziennika importu danych z buforowanym zapisem w tle.
+ *
+ * Plik naglowkowy zawierajacy klase IngestLog, ktora zbiera wyniki
+ * przetwarzania linii podczas importu: liczniki poprawnych i odrzuconych
+ * linii, liczniki wg kategorii bledu, probki pierwszych bledow kazdej
+ * kategorii oraz podsumowanie. Zapis do plikow odbywa sie paczkami na
+ * osobnym watku, dzieki czemu nie spowalnia parsowania.
+ */
+
+#ifndef INGESTLOG_H
+#define INGESTLOG_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+ /**
+  * @class IngestLog
+  * @brief Dziennik importu z poziomami szczegolowosci i zapisem w tle.
+  *
+  * Tworzy dwa pliki z unikalnym znacznikiem czasu:
+  * - log_DATA_CZAS.txt: wpisy wszystkich rejestrowanych linii (wg poziomu) i podsumowanie,
+  * - log_error_DATA_CZAS.txt: wylacznie probki bledow i podsumowanie.
+  * Dla kazdej kategorii bledu zapisywane jest co najwyzej Options::samples
+  * pierwszych linii; pozostale sa tylko zliczane i ujete w podsumowaniu.
+  * Metody rejestrujace wywoluje jeden watek (watek importu); zapis do
+  * plikow wykonuje wewnetrzny watek roboczy.
+  */
+class IngestLog {
+public:
+    /**
+     * @brief Poziom szczegolowosci dziennika.
+     */
+    enum class Level {
+        OFF,     /**< Brak plikow - tylko liczniki w pamieci. */
+        SUMMARY, /**< Tylko podsumowanie (liczniki kategorii). */
+        ERRORS,  /**< Probki bledow i podsumowanie. */
+        ALL      /**< Dodatkowo wpis "OK:" dla kazdej poprawnej linii. */
+    };
+
+    /**
+     * @struct Options
+     * @brief Ustawienia dziennika importu.
+     */
+    struct Options {
+        Level level = Level::ERRORS;    /**< Poziom szczegolowosci. */
+        std::size_t samples = 50;       /**< Limit zapisywanych linii na kategorie bledu. */
+        std::string suffix{};           /**< Dopisek do nazw plikow (np. "_licznik1"), gdy kilka importow trwa jednoczesnie. */
+        bool quiet = false;             /**< Bez komunikatow na konsoli - wynik importu raportuje wywolujacy (Totals). */
+    };
+
+    /**
+     * @struct Totals
+     * @brief Wynik importu jednego pliku.
+     */
+    struct Totals {
+        bool opened = false;            /**< Czy plik udalo sie otworzyc. */
+        std::size_t valid = 0;          /**< Liczba poprawnie zaimportowanych linii. */
+        std::size_t invalid = 0;        /**< Liczba odrzuconych linii. */
+        std::uint64_t consumed = 0;     /**< Przetworzone bajty pliku - do konca ostatniej pelnej linii (CsvFollower::seek). */
+        char separator = ',';           /**< Separator kolumn wykryty z naglowka. */
+    };
+
+    /**
+     * @brief Tworzy dziennik i (dla poziomu innego niz OFF) pliki logow.
+     *
+     * @param ts Znacznik czasu w nazwach plikow (FileManager::getTimestampStr).
+     * @param options Ustawienia dziennika.
+     */
+    IngestLog(const std::string& ts, const Options& options);
+
+    /**
+     * @brief Konczy dziennik (finish), jesli nie zostal zakonczony wczesniej.
+     */
+    ~IngestLog();
+
+    IngestLog(const IngestLog&) = delete;
+    IngestLog& operator=(const IngestLog&) = delete;
+
+    /**
+     * @brief Rejestruje poprawnie zaimportowana linie.
+     *
+     * Poza poziomem ALL jest to wylacznie zwiekszenie licznika.
+     *
+     * @param line Tresc linii.
+     */
+    void ok(std::string_view line) {
+        valid++;
+        if (level == Level::ALL) append(nullptr, line);
+    }
+
+    /**
+     * @brief Rejestruje odrzucona linie.
+     *
+     * @param category Opis (kategoria) bledu, np. CsvParser::ERR_DATE.
+     * @param line Tresc linii.
+     */
+    void error(const char* category, std::string_view line);
+
+    /**
+     * @brief Rejestruje wynik przetworzenia linii.
+     *
+     * @param line Tresc linii.
+     * @param category nullptr dla sukcesu, w przeciwnym razie opis bledu.
+     */
+    void record(std::string_view line, const char* category) {
+        if (!category) ok(line);
+        else error(category, line);
+    }
+
+    /**
+     * @brief Zapisuje podsumowanie, oproznia bufory i zatrzymuje watek zapisu.
+     *
+     * Kolejne wywolania nie maja efektu.
+     */
+    void finish();
+
+    /**
+     * @brief Zwraca liczbe poprawnie zaimportowanych linii.
+     * @return std::size_t Liczba linii.
+     */
+    std::size_t validCount() const { return valid; }
+
+    /**
+     * @brief Zwraca liczbe odrzuconych linii.
+     * @return std::size_t Liczba linii.
+     */
+    std::size_t invalidCount() const { return invalid; }
+
+    /**
+     * @brief Zwraca wynik importu (liczniki linii poprawnych i odrzuconych).
+     * @return Totals Wynik importu otwartego pliku (bez przesuniecia i separatora - uzupelnia je FileManager).
+     */
+    Totals totals() const { return Totals{ true, valid, invalid, 0, ',' }; }
+
+    /**
+     * @brief Zwraca liczbe linii odrzuconych z podanego powodu.
+     * @param category Opis bledu.
+     * @return std::size_t Liczba linii.
+     */
+    std::size_t categoryCount(const std::string& category) const;
+
+private:
+    /** @brief Rozmiar paczki tekstu, po ktorego przekroczeniu paczka trafia do watku zapisu. */
+    static constexpr std::size_t BATCH_BYTES = 64 * 1024;
+
+    /**
+     * @struct Batch
+     * @brief Paczka tekstu do dopisania do obu plikow.
+     */
+    struct Batch {
+        std::string all;    /**< Tekst dla log_DATA_CZAS.txt. */
+        std::string err;    /**< Tekst dla log_error_DATA_CZAS.txt. */
+    };
+
+    Level level;                                /**< Poziom szczegolowosci. */
+    std::size_t samples;                        /**< Limit probek na kategorie. */
+    std::size_t valid = 0;                      /**< Liczba poprawnych linii. */
+    std::size_t invalid = 0;                    /**< Liczba odrzuconych linii. */
+    std::map<std::string, std::size_t> categories; /**< Liczniki wg kategorii bledu. */
+
+    Batch current;                              /**< Paczka w trakcie zbierania. */
+
+    std::ofstream logAll;                       /**< Log wszystkich wpisow. */
+    std::ofstream logErr;                       /**< Log bledow. */
+    std::deque<Batch> queue;                    /**< Paczki oczekujace na zapis. */
+    std::mutex mtx;                             /**< Ochrona kolejki. */
+    std::condition_variable cv;                 /**< Powiadamianie watku zapisu. */
+    bool stopping = false;                      /**< Flaga zakonczenia watku zapisu. */
+    bool finished = false;                      /**< Czy finish() zostal juz wywolany. */
+    std::thread writer;                         /**< Watek zapisu do plikow. */
+
+    /**
+     * @brief Dopisuje wpis linii do paczki i wysyla paczke po przekroczeniu BATCH_BYTES.
+     *
+     * @param category nullptr dla wpisu "OK:" (tylko log ogolny), w przeciwnym
+     * razie wpis "ERR:" trafia do obu plikow.
+     * @param line Tresc linii.
+     */
+    void append(const char* category, std::string_view line);
+
+    /**
+     * @brief Przekazuje biezaca paczke do watku zapisu.
+     */
+    void submit();
+
+    /**
+     * @brief Petla watku zapisu - dopisuje paczki do plikow.
+     */
+    void writerLoop();
+};
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Implementacja odwzorowania pliku w pamieci dla Windows i systemow POSIX.
+ *
+ * Plik zawiera zalezna od platformy czesc klasy MappedFile: otwarcie pliku,
+ * utworzenie odwzorowania tylko do odczytu oraz zwolnienie zasobow.
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Otwiera plik i odwzorowuje go w pamieci.
+ *
+ * Pusty plik nie moze zostac odwzorowany (zarowno mmap, jak i
+ * CreateFileMapping zglaszaja blad dla rozmiaru 0), dlatego jest traktowany
+ * jako poprawnie otwarty plik bez danych.
+ *
+ * @param filename Sciezka do pliku.
+ */
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) return;
+    len = static_cast<std::size_t>(fileSize.QuadPart);
+    opened = true;
+    if (len == 0) return;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) { opened = false; len = 0; return; }
+    ptr = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!ptr) { opened = false; len = 0; }
+#else
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) return;
+    len = static_cast<std::size_t>(st.st_size);
+    opened = true;
+    if (len == 0) return;
+
+    void* addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) { opened = false; len = 0; return; }
+    ptr = static_cast<const char*>(addr);
+    ::madvise(addr, len, MADV_SEQUENTIAL); // Dane sa czytane liniowo
+#endif
+}
+
+/**
+ * @brief Zwalnia odwzorowanie i zamyka uchwyty pliku.
+ */
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (ptr) UnmapViewOfFile(ptr);
+    if (mapping) CloseHandle(mapping);
+    if (fileHandle) CloseHandle(fileHandle);
+#else
+    if (ptr) ::munmap(const_cast<char*>(ptr), len);
+    if (fd >= 0) ::close(fd);
+#endif
+}
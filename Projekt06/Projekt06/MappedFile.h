@@ -0,0 +1,83 @@
+/**
+ * @file MappedFile.h
+ * @brief Definicja klasy odwzorowujacej plik w pamieci (memory-mapped file).
+ *
+ * Plik naglowkowy zawierajacy deklaracje klasy MappedFile, ktora udostepnia
+ * zawartosc pliku jako ciagly, tylko do odczytu obszar pamieci. Pozwala to
+ * parsowac dane bezposrednio z bufora systemu operacyjnego, bez kopiowania
+ * ich do obiektow std::string.
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+ /**
+  * @class MappedFile
+  * @brief Odwzorowanie pliku w pamieci tylko do odczytu (RAII).
+  *
+  * Konstruktor otwiera plik i mapuje cala jego zawartosc, destruktor zwalnia
+  * odwzorowanie i zamyka uchwyty. Na Windows wykorzystywane sa funkcje
+  * CreateFileMapping/MapViewOfFile, na systemach POSIX - mmap.
+  * Obiekt nie jest kopiowalny, poniewaz wylacznie posiada zasoby systemowe.
+  */
+class MappedFile {
+    const char* ptr = nullptr; /**< Poczatek odwzorowanego obszaru. */
+    std::size_t len = 0;       /**< Rozmiar pliku w bajtach. */
+    bool opened = false;       /**< Czy plik udalo sie otworzyc. */
+#ifdef _WIN32
+    void* fileHandle = nullptr; /**< Uchwyt pliku (HANDLE). */
+    void* mapping = nullptr;    /**< Uchwyt odwzorowania (HANDLE). */
+#else
+    int fd = -1;                /**< Deskryptor pliku. */
+#endif
+
+public:
+    /**
+     * @brief Otwiera i odwzorowuje plik w pamieci.
+     *
+     * W przypadku bledu obiekt pozostaje w stanie "nieotwartym"
+     * (isOpen() zwraca false), a data() zwraca nullptr.
+     * Pusty plik jest poprawnie otwarty, ale ma rozmiar 0.
+     *
+     * @param filename Sciezka do pliku.
+     */
+    explicit MappedFile(const std::string& filename);
+
+    /**
+     * @brief Zwalnia odwzorowanie i zamyka plik.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Sprawdza, czy plik zostal poprawnie otwarty.
+     * @return bool True, jesli plik jest dostepny do odczytu.
+     */
+    bool isOpen() const { return opened; }
+
+    /**
+     * @brief Zwraca wskaznik na poczatek zawartosci pliku.
+     * @return const char* Wskaznik na dane (nullptr dla pustego lub nieotwartego pliku).
+     */
+    const char* data() const { return ptr; }
+
+    /**
+     * @brief Zwraca rozmiar pliku.
+     * @return std::size_t Rozmiar w bajtach.
+     */
+    std::size_t size() const { return len; }
+
+    /**
+     * @brief Zwraca zawartosc pliku jako widok tekstowy (bez kopiowania).
+     * @return std::string_view Widok na cala zawartosc pliku.
+     */
+    std::string_view view() const { return std::string_view(ptr, len); }
+};
+
+#endif
@@ -13,16 +13,41 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <limits>
+
+/**
+ * @brief Typ wyliczeniowy okreslajacy rodzaj danych energetycznych.
+ *
+ * Uzywany do wskazywania, na ktorym polu struktury Measurement ma operowac
+ * dana funkcja analityczna. Wartosci wyliczenia sa jednoczesnie indeksami
+ * pol w tablicach agregatow (NodeStats), dlatego ich kolejnosc jest istotna.
+ */
+enum class DataType {
+    AUTO,   /**< Autokonsumpcja */
+    EXPORT, /**< Energia wyeksportowana do sieci */
+    IMPORT, /**< Energia pobrana z sieci */
+    CONS,   /**< Calkowita konsumpcja */
+    PROD    /**< Calkowita produkcja */
+};
+
+/** @brief Liczba pol energetycznych w pojedynczym pomiarze (rozmiar DataType). */
+constexpr int FIELD_COUNT = 5;
 
  /**
   * @struct Measurement
   * @brief Struktura reprezentujaca pojedynczy rekord pomiarowy.
   *
   * Przechowuje znaczniki czasu oraz zestaw pieciu wartosci energetycznych.
+  * Obok daty (std::tm, uzywanej do wyswietlania) pomiar moze przechowywac
+  * wyliczony raz czas liniowy (epoch) - porownania i sprawdzanie zakresow
+  * sa wtedy zwyklymi porownaniami liczb calkowitych.
   * Zawiera rowniez metody umozliwiajace porownywanie instancji (na potrzeby
   * sortowania i unikalnosci) oraz serializacje do formatu binarnego.
   */
 struct Measurement {
+    /** @brief Numer dnia 1970-01-01 liczony od 1 marca roku -4800 (zob. toEpoch). */
+    static constexpr long long EPOCH_DAY = 2472632;
+
     std::tm timestamp;      /**< Data i czas wykonania pomiaru. */
     double autoconsumption; /**< Autokonsumpcja energii [W]. */
     double exportEnergy;    /**< Energia wyeksportowana do sieci [W]. */
@@ -30,16 +55,92 @@ struct Measurement {
     double consumption;     /**< Calkowite zuzycie domu [W]. */
     double production;      /**< Calkowita produkcja z instalacji PV [W]. */
 
+    /** @brief Wartosc pola epoch oznaczajaca, ze czas liniowy nie zostal jeszcze wyliczony. */
+    static constexpr time_t NO_EPOCH = std::numeric_limits<time_t>::min();
+
     /**
      * @brief Konstruktor domyslny.
      *
      * Inicjalizuje wszystkie wartosci liczbowe zerami, a strukture czasu
      * ustawia na pusta.
      */
-    Measurement() : autoconsumption(0), exportEnergy(0), importEnergy(0), consumption(0), production(0) {
+    Measurement() : autoconsumption(0), exportEnergy(0), importEnergy(0), consumption(0), production(0), epoch(NO_EPOCH) {
         timestamp = {};
     }
 
+    /**
+     * @brief Ustawia date pomiaru i od razu wylicza jego czas liniowy.
+     * @param t Data i czas pomiaru.
+     */
+    void setTimestamp(const std::tm& t) {
+        timestamp = t;
+        epoch = toEpoch(t);
+    }
+
+    /**
+     * @brief Ustawia czas pomiaru w sekundach od epoki i wylicza z niego date.
+     * @param t Sekundy od epoki (zob. toEpoch).
+     */
+    void setEpoch(time_t t) {
+        epoch = t;
+        timestamp = fromEpoch(t);
+    }
+
+    /**
+     * @brief Sprawdza, czy czas liniowy jest zapamietany (ustawiony przez setTimestamp, setEpoch lub deserialize).
+     * @return bool False, gdy epochTime() wylicza czas z pola timestamp.
+     */
+    bool hasEpoch() const { return epoch != NO_EPOCH; }
+
+    /**
+     * @brief Zwraca czas pomiaru w sekundach od epoki.
+     *
+     * Korzysta z wartosci wyliczonej przy parsowaniu (setTimestamp), a gdy
+     * jej brak - wylicza ja arytmetycznie z pola timestamp. Zapamietana
+     * wartosc ma pierwszenstwo przed polem timestamp, dlatego date pomiaru,
+     * ktory ma juz czas liniowy (hasEpoch), nalezy zmieniac przez setTimestamp.
+     *
+     * @return time_t Sekundy od epoki.
+     */
+    time_t epochTime() const {
+        return epoch != NO_EPOCH ? epoch : toEpoch(timestamp);
+    }
+
+    /**
+     * @brief Zwraca wartosc pola wskazanego w czasie kompilacji.
+     *
+     * Wybor pola odbywa sie przez if constexpr, wiec wywolanie sprowadza sie
+     * do odczytu jednego pola - bez rozgalezien i wywolan posrednich.
+     * Pozwala pisac petle agregujace jako szablony parametryzowane DataType.
+     *
+     * @tparam Type Typ danych (pole pomiaru).
+     * @return double Wartosc pola.
+     */
+    template <DataType Type>
+    double get() const {
+        if constexpr (Type == DataType::AUTO) return autoconsumption;
+        else if constexpr (Type == DataType::EXPORT) return exportEnergy;
+        else if constexpr (Type == DataType::IMPORT) return importEnergy;
+        else if constexpr (Type == DataType::CONS) return consumption;
+        else return production;
+    }
+
+    /**
+     * @brief Zwraca wartosc pola wskazanego w czasie wykonania.
+     * @param type Typ danych (pole pomiaru).
+     * @return double Wartosc pola; 0.0 dla wartosci spoza DataType (jak Analyzer::getSelector).
+     */
+    double get(DataType type) const {
+        switch (type) {
+        case DataType::AUTO: return get<DataType::AUTO>();
+        case DataType::EXPORT: return get<DataType::EXPORT>();
+        case DataType::IMPORT: return get<DataType::IMPORT>();
+        case DataType::CONS: return get<DataType::CONS>();
+        case DataType::PROD: return get<DataType::PROD>();
+        default: return 0.0;
+        }
+    }
+
     /**
      * @brief Operator mniejszosci.
      *
@@ -50,7 +151,7 @@ struct Measurement {
      * @return bool True, jesli biezacy obiekt jest starszy (wczesniejszy) niz other.
      */
     bool operator<(const Measurement& other) const {
-        return tmToTime() < other.tmToTime();
+        return epochTime() < other.epochTime();
     }
 
     /**
@@ -63,14 +164,15 @@ struct Measurement {
      * @return bool True, jesli znaczniki czasu sa identyczne.
      */
     bool operator==(const Measurement& other) const {
-        return tmToTime() == other.tmToTime();
+        return epochTime() == other.epochTime();
     }
 
     /**
-     * @brief Konwertuje strukture std::tm na czas liniowy (time_t).
+     * @brief Konwertuje strukture std::tm na czas liniowy (time_t) w strefie lokalnej.
      *
-     * Metoda pomocnicza ulatwiajaca porownywanie dat poprzez sprowadzenie
-     * ich do pojedynczej liczby calkowitej (liczba sekund od epoki).
+     * Wykorzystuje std::mktime, wiec uwzglednia strefe czasowa i czas letni
+     * systemu. Przeznaczona wylacznie do prezentacji (np. konwersji na czas
+     * systemowy) - porownania i zakresy korzystaja z epochTime().
      * Uzywa kopii lokalnej, aby funkcja mktime nie modyfikowala oryginalu.
      *
      * @return time_t Czas w formacie liniowym.
@@ -80,6 +182,69 @@ struct Measurement {
         return std::mktime(&temp);
     }
 
+    /**
+     * @brief Zamienia date kalendarzowa na liczbe sekund od 1970-01-01 00:00.
+     *
+     * W odroznieniu od std::mktime nie korzysta ze strefy czasowej ani czasu
+     * letniego - data jest traktowana jako "czas scienny" licznika (tak jak
+     * w pliku CSV). Obliczenie jest czysto arytmetyczne i bez rozgalezien:
+     * lata liczone sa od marca roku -4800 (wielokrotnosc 400 lat), dzieki
+     * czemu wszystkie dzielenia dzialaja na liczbach nieujemnych, a dzien
+     * przestepny wypada na koncu roku. Pola spoza zakresu (np. tm_mday == 0,
+     * tm_mon == 12) sa normalizowane tak jak w mktime.
+     *
+     * @param t Data i czas do konwersji.
+     * @return time_t Liczba sekund od epoki.
+     */
+    static time_t toEpoch(const std::tm& t) {
+        // Miesiace od marca roku -4800
+        long long months = t.tm_year * 12LL + t.tm_mon + (1900 + 4800) * 12LL - 2;
+        long long y = months / 12;
+        long long mp = months - y * 12; // 0 = marzec, 11 = luty
+
+        long long days = 365 * y + y / 4 - y / 100 + y / 400 + (153 * mp + 2) / 5 + (t.tm_mday - 1) - EPOCH_DAY;
+        return static_cast<time_t>(days * 86400LL + t.tm_hour * 3600LL + t.tm_min * 60LL + t.tm_sec);
+    }
+
+    /**
+     * @brief Zamienia liczbe sekund od epoki na date kalendarzowa.
+     *
+     * Operacja odwrotna do toEpoch (algorytm civil_from_days liczony od
+     * marca roku -4800, bez rozgalezien). Zwracana struktura jest
+     * znormalizowana i ma ustawione pola tm_wday oraz tm_yday;
+     * tm_isdst = -1, aby ewentualna konwersja mktime (np. do wyswietlenia)
+     * sama ustalila czas letni/zimowy.
+     *
+     * @param t Liczba sekund od epoki.
+     * @return std::tm Data i czas.
+     */
+    static std::tm fromEpoch(time_t t) {
+        long long shifted = static_cast<long long>(t) + EPOCH_DAY * 86400LL;
+        long long dn = shifted / 86400;       // dni od 1 marca roku -4800
+        long long rem = shifted - dn * 86400;
+
+        long long era = dn / 146097;
+        long long doe = dn - era * 146097;
+        long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long long mp = (5 * doy + 2) / 153;
+        long long janFeb = mp >= 10;
+        long long y = yoe + era * 400 + janFeb; // lata od roku -4800
+        long long leap = (y % 4 == 0) & ((y % 100 != 0) | (y % 400 == 0));
+
+        std::tm out = {};
+        out.tm_year = static_cast<int>(y - 4800 - 1900);
+        out.tm_mon = static_cast<int>(mp + 2 - 12 * janFeb);
+        out.tm_mday = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+        out.tm_hour = static_cast<int>(rem / 3600);
+        out.tm_min = static_cast<int>(rem % 3600 / 60);
+        out.tm_sec = static_cast<int>(rem % 60);
+        out.tm_wday = static_cast<int>((dn + 3) % 7);
+        out.tm_yday = static_cast<int>(doy - 306 + (1 - janFeb) * (365 + leap));
+        out.tm_isdst = -1;
+        return out;
+    }
+
     /**
      * @brief Serializuje obiekt do strumienia binarnego.
      *
@@ -101,18 +266,31 @@ struct Measurement {
      * @brief Deserializuje obiekt ze strumienia binarnego.
      *
      * Wczytuje dane bezposrednio do pol struktury, odtwarzajac stan
-     * zapisany metoda serialize.
+     * zapisany metoda serialize, i wylicza czas liniowy pomiaru.
      *
      * @param ifs Strumien wejsciowy pliku (otwarty w trybie binarnym).
      */
     void deserialize(std::ifstream& ifs) {
         ifs.read(reinterpret_cast<char*>(&timestamp), sizeof(timestamp));
+        epoch = toEpoch(timestamp);
         ifs.read(reinterpret_cast<char*>(&autoconsumption), sizeof(autoconsumption));
         ifs.read(reinterpret_cast<char*>(&exportEnergy), sizeof(exportEnergy));
         ifs.read(reinterpret_cast<char*>(&importEnergy), sizeof(importEnergy));
         ifs.read(reinterpret_cast<char*>(&consumption), sizeof(consumption));
         ifs.read(reinterpret_cast<char*>(&production), sizeof(production));
     }
+
+private:
+    /**
+     * @brief Czas pomiaru w sekundach od epoki (zob. toEpoch) lub NO_EPOCH.
+     *
+     * Ustawiany tylko razem z data - przez setTimestamp, setEpoch
+     * i deserialize. Pomiar, ktorego pole timestamp wypelniono bezposrednio,
+     * ma NO_EPOCH i epochTime() wylicza czas z daty przy kazdym wywolaniu.
+     * Bezposrednia zmiana timestamp po ustawieniu czasu liniowego nie
+     * aktualizuje tego pola - epochTime() zwrocilby wtedy poprzedni czas.
+     */
+    time_t epoch;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+/**
+ * @file MeterStore.cpp
+ * @brief Implementacja magazynu wielu licznikow: rownolegle wczytywanie i zapytania floty.
+ */
+
+#include "MeterStore.h"
+#include "FileManager.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <iostream>
+#include <set>
+
+/**
+ * @brief Rejestruje licznik z plikiem CSV.
+ *
+ * @param id Identyfikator licznika.
+ * @param csvFile Sciezka do pliku CSV.
+ */
+void MeterStore::addMeter(const std::string& id, const std::string& csvFile) {
+    Shard& shard = shards[id];
+    shard.source = csvFile;
+    shard.tree.reset();
+}
+
+/**
+ * @brief Zwraca drzewo licznika, tworzac lub wczytujac je w razie potrzeby.
+ *
+ * @param id Identyfikator licznika.
+ * @return EnergyTree& Drzewo licznika.
+ */
+EnergyTree& MeterStore::tree(const std::string& id) {
+    Shard& shard = shards[id];
+    if (!shard.tree) load({ id });
+    if (!shard.tree) shard.tree = std::make_unique<EnergyTree>();
+    return *shard.tree;
+}
+
+/**
+ * @brief Wczytuje brakujace drzewa wskazanych licznikow.
+ *
+ * Liczniki sa rozdzielane na zadania puli (lub tymczasowej puli o liczbie
+ * watkow rownej liczbie rdzeni) - kazde zadanie wczytuje caly plik jednego
+ * licznika do jego wlasnego drzewa, wiec watki nie wspoldziela zadnych
+ * danych. Drzewa sa dolaczane do magazynu dopiero po zakonczeniu wszystkich zadan
+ * i tylko dla licznikow, ktorych pliki udalo sie otworzyc.
+ * Importy dzialaja bez komunikatow na konsoli (IngestLog::Options::quiet);
+ * wyniki wszystkich licznikow sa wypisywane na koncu, w kolejnosci ids.
+ *
+ * @param ids Identyfikatory licznikow.
+ * @return std::size_t Liczba wczytanych licznikow.
+ */
+std::size_t MeterStore::load(const std::vector<std::string>& ids) {
+    std::vector<Shard*> pending;
+    std::vector<std::string> names;
+    for (const std::string& id : ids) {
+        auto it = shards.find(id);
+        if (it == shards.end() || it->second.tree || it->second.source.empty()) continue;
+        if (std::find(pending.begin(), pending.end(), &it->second) != pending.end()) continue;
+        pending.push_back(&it->second);
+        names.push_back(id);
+    }
+    if (pending.empty()) return 0;
+
+    std::vector<std::unique_ptr<EnergyTree>> loaded(pending.size());
+    std::vector<IngestLog::Totals> results(pending.size());
+    auto options = [&](std::size_t i) {
+        IngestLog::Options o = log;
+        o.suffix += "_" + names[i];
+        o.quiet = true;
+        return o;
+    };
+    if (pending.size() == 1) {
+        loaded[0] = std::make_unique<EnergyTree>();
+        results[0] = FileManager::loadCSVParallel(*loaded[0], pending[0]->source, pool ? pool->size() : 0, options(0));
+    }
+    else {
+        std::unique_ptr<ThreadPool> local;
+        ThreadPool* workers = pool;
+        if (!workers) {
+            local = std::make_unique<ThreadPool>();
+            workers = local.get();
+        }
+        forEachPartition(pending.size(), workers, [&](std::size_t i) {
+            loaded[i] = std::make_unique<EnergyTree>();
+            results[i] = FileManager::loadCSV(*loaded[i], pending[i]->source, options(i));
+        });
+    }
+
+    if (!log.quiet) {
+        IngestLog::Totals total;
+        for (std::size_t i = 0; i < pending.size(); i++) {
+            const IngestLog::Totals& r = results[i];
+            if (!r.opened) {
+                std::cout << names[i] << ": Nie mozna otworzyc pliku: " << pending[i]->source << "\n";
+                continue;
+            }
+            std::cout << names[i] << ": Wczytano: " << r.valid << ", Blednych: " << r.invalid << "\n";
+            total.valid += r.valid;
+            total.invalid += r.invalid;
+        }
+        if (pending.size() > 1) std::cout << "Liczniki: " << pending.size() << ", Wczytano: " << total.valid << ", Blednych: " << total.invalid << "\n";
+    }
+
+    // Licznik, ktorego pliku nie udalo sie otworzyc, pozostaje niewczytany (kolejne zapytanie ponowi probe)
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < pending.size(); i++) {
+        if (!results[i].opened) continue;
+        pending[i]->tree = std::move(loaded[i]);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Wczytuje wszystkie zarejestrowane liczniki.
+ *
+ * @return std::size_t Liczba wczytanych licznikow.
+ */
+std::size_t MeterStore::loadAll() {
+    return load(meters());
+}
+
+/**
+ * @brief Zwalnia drzewo licznika (cala pamiec jego areny).
+ *
+ * Licznik bez pliku zrodlowego traci dane bezpowrotnie.
+ *
+ * @param id Identyfikator licznika.
+ */
+void MeterStore::unload(const std::string& id) {
+    auto it = shards.find(id);
+    if (it != shards.end()) it->second.tree.reset();
+}
+
+/**
+ * @brief Zwraca identyfikatory zarejestrowanych licznikow.
+ *
+ * @return std::vector<std::string> Identyfikatory w porzadku rosnacym.
+ */
+std::vector<std::string> MeterStore::meters() const {
+    std::vector<std::string> out;
+    out.reserve(shards.size());
+    for (const auto& entry : shards) out.push_back(entry.first);
+    return out;
+}
+
+/**
+ * @brief Zlicza liczniki z drzewem w pamieci.
+ *
+ * @return std::size_t Liczba wczytanych licznikow.
+ */
+std::size_t MeterStore::loadedCount() const {
+    std::size_t n = 0;
+    for (const auto& entry : shards) n += entry.second.tree ? 1 : 0;
+    return n;
+}
+
+/**
+ * @brief Sprawdza, czy licznik ma drzewo w pamieci.
+ *
+ * @param id Identyfikator licznika.
+ * @return bool True dla wczytanego licznika.
+ */
+bool MeterStore::isLoaded(const std::string& id) const {
+    auto it = shards.find(id);
+    return it != shards.end() && it->second.tree;
+}
+
+/**
+ * @brief Wybiera drzewa licznikow zapytania, wczytujac brakujace jednym wywolaniem load.
+ *
+ * Licznik zarejestrowany bez pliku i bez danych oraz licznik, ktorego pliku
+ * nie udalo sie otworzyc, nie ma drzewa i jest pomijany.
+ *
+ * @param ids Identyfikatory licznikow.
+ * @param names Opcjonalnie: identyfikatory licznikow zwroconych drzew.
+ * @return std::vector<const EnergyTree*> Drzewa w kolejnosci ids.
+ */
+std::vector<const EnergyTree*> MeterStore::select(const std::vector<std::string>& ids, std::vector<std::string>* names) {
+    load(ids);
+    std::vector<const EnergyTree*> out;
+    std::set<std::string> seen;
+    for (const std::string& id : ids) {
+        auto it = shards.find(id);
+        if (it == shards.end() || !it->second.tree || !seen.insert(id).second) continue;
+        out.push_back(it->second.tree.get());
+        if (names) names->push_back(id);
+    }
+    return out;
+}
+
+/**
+ * @brief Oblicza sumy floty - agregaty kazdego licznika laczone w kolejnosci listy.
+ *
+ * Agregaty licznikow sa liczone na zadaniach puli (kazdy licznik na jednym
+ * watku - pula nie jest przekazywana dalej do EnergyTree::aggregate, aby
+ * zadania nie czekaly na zadania tej samej puli).
+ *
+ * @param ids Identyfikatory licznikow.
+ * @param start Poczatek przedzialu (wlacznie).
+ * @param end Koniec przedzialu (wlacznie).
+ * @return NodeStats Laczne agregaty.
+ */
+NodeStats MeterStore::aggregate(const std::vector<std::string>& ids, time_t start, time_t end) {
+    std::vector<const EnergyTree*> trees = select(ids);
+    std::vector<NodeStats> partial(trees.size());
+    forEachPartition(trees.size(), pool, [&](std::size_t i) { partial[i] = trees[i]->aggregate(start, end); });
+
+    NodeStats out;
+    for (const NodeStats& p : partial) out.merge(p);
+    return out;
+}
+
+/**
+ * @brief Zestawienie metryk floty z lacznych agregatow.
+ *
+ * @param ids Identyfikatory licznikow.
+ * @param s Data poczatkowa (wlacznie).
+ * @param e Data koncowa (wlacznie).
+ * @return Analyzer::Summary Zestawienie metryk.
+ */
+Analyzer::Summary MeterStore::getSummary(const std::vector<std::string>& ids, std::tm s, std::tm e) {
+    return Analyzer::summarize(aggregate(ids, Measurement::toEpoch(s), Measurement::toEpoch(e)));
+}
+
+/**
+ * @brief Ranking instalacji wg sumy pola.
+ *
+ * Kazdy licznik wnosi jeden wynik (agregaty przedzialu), wiec pamiec
+ * i czas rankingu zaleza tylko od liczby wybranych licznikow. Przy
+ * ograniczeniu top wykonywane jest czesciowe sortowanie.
+ *
+ * @param ids Identyfikatory licznikow.
+ * @param s Data poczatkowa (wlacznie).
+ * @param e Data koncowa (wlacznie).
+ * @param type Pole rankingu.
+ * @param top Liczba pozycji; 0 = wszystkie.
+ * @return std::vector<MeterStore::SiteValue> Ranking malejaco wg sumy.
+ */
+std::vector<MeterStore::SiteValue> MeterStore::rank(const std::vector<std::string>& ids, std::tm s, std::tm e, DataType type, std::size_t top) {
+    std::vector<std::string> names;
+    std::vector<const EnergyTree*> trees = select(ids, &names);
+    time_t start = Measurement::toEpoch(s), end = Measurement::toEpoch(e);
+
+    std::vector<SiteValue> out(trees.size());
+    forEachPartition(trees.size(), pool, [&](std::size_t i) {
+        NodeStats stats = trees[i]->aggregate(start, end);
+        out[i].value = stats.field(type).sum;
+        out[i].count = stats.count;
+    });
+    for (std::size_t i = 0; i < out.size(); i++) out[i].meter = std::move(names[i]);
+
+    auto before = [](const SiteValue& a, const SiteValue& b) {
+        return a.value != b.value ? a.value > b.value : a.meter < b.meter;
+    };
+    if (top == 0 || top >= out.size()) std::sort(out.begin(), out.end(), before);
+    else {
+        std::partial_sort(out.begin(), out.begin() + top, out.end(), before);
+        out.resize(top);
+    }
+    return out;
+}
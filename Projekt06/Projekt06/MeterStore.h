@@ -0,0 +1,200 @@
+/**
+ * @file MeterStore.h
+ * @brief Definicja magazynu danych wielu licznikow (instalacji PV).
+ *
+ * Plik naglowkowy zawierajacy klase MeterStore, ktora przechowuje osobne
+ * drzewo EnergyTree (shard) dla kazdego identyfikatora licznika, wczytuje
+ * pliki licznikow rownolegle i wykonuje zapytania na wybranym zbiorze
+ * licznikow (sumy floty, ranking instalacji).
+ */
+
+#ifndef METERSTORE_H
+#define METERSTORE_H
+
+#include "Analyzer.h"
+#include "IngestLog.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+ /**
+  * @class MeterStore
+  * @brief Zbior drzew EnergyTree indeksowany identyfikatorem licznika.
+  *
+  * Licznik jest rejestrowany razem ze sciezka swojego pliku CSV (addMeter),
+  * ale drzewo powstaje dopiero przy pierwszym zapytaniu obejmujacym licznik
+  * (lub jawnym load). Niewczytany licznik to tylko wpis w mapie - pamiec
+  * i czas wczytywania zaleza wiec od liczby licznikow, o ktore pytano,
+  * a nie od wielkosci calej floty; unload zwalnia drzewo nieuzywanego licznika.
+  *
+  * Zapytania floty wykonuja to samo zapytanie na drzewie kazdego wybranego
+  * licznika (na watkach puli, jesli zostala podana) i lacza wyniki
+  * w kolejnosci listy licznikow, wiec wynik nie zalezy od liczby watkow.
+  * Liczniki nieznane (niezarejestrowane) i liczniki, ktorych pliku nie udalo
+  * sie otworzyc, sa pomijane, a powtorzone na liscie sa uwzgledniane raz.
+  *
+  * Obiekt nie jest bezpieczny dla wielu watkow - zapytania wczytuja brakujace
+  * drzewa; rownolegle sa wykonywane tylko operacje wewnatrz jednego wywolania.
+  */
+class MeterStore {
+    /**
+     * @struct Shard
+     * @brief Dane jednego licznika.
+     */
+    struct Shard {
+        std::string source;                     /**< Plik CSV licznika (pusty = dane dodawane przez tree()). */
+        std::unique_ptr<EnergyTree> tree;       /**< Drzewo licznika; nullptr, dopoki nie zostalo wczytane. */
+    };
+
+    std::map<std::string, Shard> shards;        /**< Liczniki wg identyfikatora. */
+
+    /**
+     * @brief Pula watkow dla wczytywania i zapytan (nullptr = pula tymczasowa przy wczytywaniu, zapytania na jednym watku).
+     *
+     * Pula nie jest wlasnoscia magazynu - musi istniec dluzej niz wywolania.
+     */
+    ThreadPool* pool = nullptr;
+
+    IngestLog::Options log;                     /**< Ustawienia dziennikow importu (rowniez dla wczytywania przy zapytaniu). */
+
+    /**
+     * @brief Zwraca drzewa wskazanych licznikow, wczytujac brakujace.
+     *
+     * @param ids Identyfikatory licznikow.
+     * @param names Opcjonalnie: identyfikatory licznikow zwroconych drzew.
+     * @return std::vector<const EnergyTree*> Drzewa w kolejnosci ids (bez licznikow nieznanych).
+     */
+    std::vector<const EnergyTree*> select(const std::vector<std::string>& ids, std::vector<std::string>* names = nullptr);
+
+public:
+    /**
+     * @struct SiteValue
+     * @brief Wynik jednego licznika w rankingu instalacji.
+     */
+    struct SiteValue {
+        std::string meter;          /**< Identyfikator licznika. */
+        double value = 0;           /**< Suma wybranego pola w przedziale. */
+        std::size_t count = 0;      /**< Liczba pomiarow licznika w przedziale. */
+    };
+
+    /**
+     * @brief Konstruktor pustego magazynu.
+     * @param p Opcjonalna pula watkow (zob. setThreadPool).
+     */
+    explicit MeterStore(ThreadPool* p = nullptr) : pool(p) {}
+
+    MeterStore(const MeterStore&) = delete;
+    MeterStore& operator=(const MeterStore&) = delete;
+
+    /**
+     * @brief Ustawia pule watkow dla wczytywania i zapytan floty.
+     * @param p Pula watkow lub nullptr.
+     */
+    void setThreadPool(ThreadPool* p) { pool = p; }
+
+    /**
+     * @brief Ustawia dzienniki importu wszystkich kolejnych wczytan licznikow.
+     * @param options Ustawienia dziennika (suffix jest uzupelniany identyfikatorem licznika).
+     */
+    void setLogOptions(const IngestLog::Options& options) { log = options; }
+
+    /**
+     * @brief Rejestruje licznik i plik CSV z jego danymi (bez wczytywania).
+     *
+     * Ponowna rejestracja licznika zmienia plik i usuwa wczytane drzewo.
+     *
+     * @param id Identyfikator licznika (instalacji).
+     * @param csvFile Sciezka do pliku w formacie Chart_Export.csv.
+     */
+    void addMeter(const std::string& id, const std::string& csvFile);
+
+    /**
+     * @brief Zwraca drzewo licznika do bezposredniego dodawania danych.
+     *
+     * Nieznany licznik jest rejestrowany bez pliku, a niewczytany - wczytywany.
+     *
+     * @param id Identyfikator licznika.
+     * @return EnergyTree& Drzewo licznika.
+     */
+    EnergyTree& tree(const std::string& id);
+
+    /**
+     * @brief Wczytuje pliki wskazanych licznikow, ktore nie sa jeszcze w pamieci.
+     *
+     * Kazdy licznik jest wczytywany (FileManager::loadCSV) do wlasnego drzewa
+     * na osobnym watku puli; pojedynczy licznik jest wczytywany
+     * FileManager::loadCSVParallel. Dzienniki importu dostaja w nazwie
+     * identyfikator licznika, aby jednoczesne importy nie pisaly do tych samych plikow.
+     * Wyniki importow (liczby linii poprawnych i odrzuconych) sa wypisywane
+     * po zakonczeniu wszystkich wczytan - po jednej linii na licznik.
+     *
+     * @param ids Identyfikatory licznikow (nieznane sa pomijane).
+     * @return std::size_t Liczba wczytanych licznikow (bez tych, ktorych pliku nie udalo sie otworzyc).
+     */
+    std::size_t load(const std::vector<std::string>& ids);
+
+    /**
+     * @brief Wczytuje wszystkie zarejestrowane liczniki.
+     * @return std::size_t Liczba wczytanych licznikow.
+     */
+    std::size_t loadAll();
+
+    /**
+     * @brief Zwalnia drzewo licznika (rejestracja zostaje - kolejne zapytanie wczyta plik ponownie).
+     * @param id Identyfikator licznika.
+     */
+    void unload(const std::string& id);
+
+    /** @brief Zwraca identyfikatory wszystkich zarejestrowanych licznikow (rosnaco). */
+    std::vector<std::string> meters() const;
+
+    /** @brief Zwraca liczbe zarejestrowanych licznikow. */
+    std::size_t size() const { return shards.size(); }
+
+    /** @brief Zwraca liczbe licznikow, ktorych drzewa sa w pamieci. */
+    std::size_t loadedCount() const;
+
+    /**
+     * @brief Sprawdza, czy drzewo licznika jest w pamieci.
+     * @param id Identyfikator licznika.
+     * @return bool True dla wczytanego licznika.
+     */
+    bool isLoaded(const std::string& id) const;
+
+    /**
+     * @brief Oblicza laczne agregaty wybranych licznikow w przedziale (sumy floty).
+     *
+     * @param ids Identyfikatory licznikow.
+     * @param start Poczatek przedzialu (wlacznie), sekundy od epoki.
+     * @param end Koniec przedzialu (wlacznie).
+     * @return NodeStats Agregaty wszystkich pomiarow wybranych licznikow.
+     */
+    NodeStats aggregate(const std::vector<std::string>& ids, time_t start, time_t end);
+
+    /**
+     * @brief Zestawienie metryk floty (jak Analyzer::getSummary dla polaczonych licznikow).
+     *
+     * @param ids Identyfikatory licznikow.
+     * @param s Data poczatkowa.
+     * @param e Data koncowa.
+     * @return Analyzer::Summary Zestawienie metryk wybranych licznikow.
+     */
+    Analyzer::Summary getSummary(const std::vector<std::string>& ids, std::tm s, std::tm e);
+
+    /**
+     * @brief Ranking instalacji wg sumy wybranego pola w przedziale (malejaco).
+     *
+     * Przy rownych sumach kolejnosc wyznacza identyfikator licznika.
+     *
+     * @param ids Identyfikatory licznikow.
+     * @param s Data poczatkowa.
+     * @param e Data koncowa.
+     * @param type Pole rankingu (np. PROD).
+     * @param top Liczba zwracanych pozycji; 0 = wszystkie.
+     * @return std::vector<SiteValue> Liczniki od najwiekszej sumy.
+     */
+    std::vector<SiteValue> rank(const std::vector<std::string>& ids, std::tm s, std::tm e, DataType type, std::size_t top = 0);
+};
+
+#endif
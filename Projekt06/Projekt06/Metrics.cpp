@@ -0,0 +1,213 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementacja odczytu, zerowania i eksportu statystyk (JSON, Prometheus).
+ */
+
+#include "Metrics.h"
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+    std::mutex rejectedMutex;                           /**< Ochrona rejectedLines. */
+    std::map<std::string, std::uint64_t> rejectedLines; /**< Linie odrzucone wg powodu. */
+
+    const char* const COUNTER_NAMES[] = {
+        "csv_lines_ok", "csv_lines_rejected", "measurements_added", "duplicates",
+        "bytes_read", "bytes_written", "queries", "blocks_scanned", "iterator_blocks"
+    };
+    const char* const HISTOGRAM_NAMES[] = { "add_ns", "bulk_load_ns", "query_ns" };
+
+    static_assert(std::size(COUNTER_NAMES) == static_cast<std::size_t>(Metrics::Counter::COUNT));
+    static_assert(std::size(HISTOGRAM_NAMES) == static_cast<std::size_t>(Metrics::Histogram::COUNT));
+
+    /** @brief Gorna granica (wlacznie) kubelka i histogramu; ostatni kubelek nie ma granicy. */
+    std::uint64_t bucketBound(int i) { return i == 0 ? 0 : (std::uint64_t{ 1 } << i) - 1; }
+
+    /** @brief Zamienia tekst na literal JSON / etykiete Prometheus (cudzyslowy i ukosniki). */
+    std::string quote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    std::string toJson(const Metrics::Snapshot& s) {
+        std::ostringstream os;
+        os << "{\n  \"counters\": {";
+        for (int i = 0; i < static_cast<int>(Metrics::Counter::COUNT); i++) {
+            os << (i ? "," : "") << "\n    \"" << COUNTER_NAMES[i] << "\": " << s.counters[i];
+        }
+        os << "\n  },\n  \"rejected\": {";
+        bool first = true;
+        for (const auto& [reason, n] : s.rejected) {
+            os << (first ? "" : ",") << "\n    " << quote(reason) << ": " << n;
+            first = false;
+        }
+        os << "\n  },\n  \"histograms\": {";
+        for (int i = 0; i < static_cast<int>(Metrics::Histogram::COUNT); i++) {
+            const Metrics::HistogramSnapshot& h = s.histograms[i];
+            os << (i ? "," : "") << "\n    \"" << HISTOGRAM_NAMES[i] << "\": { \"count\": " << h.count << ", \"sum\": " << h.sum
+                << ", \"p50\": " << h.quantile(0.5) << ", \"p99\": " << h.quantile(0.99) << ", \"buckets\": [";
+            for (int b = 0; b < Metrics::BUCKETS; b++) os << (b ? ", " : "") << h.buckets[b];
+            os << "] }";
+        }
+        os << "\n  }";
+        if (s.hasTree) {
+            const TreeShape& t = s.shape;
+            os << ",\n  \"tree\": { \"years\": " << t.years << ", \"months\": " << t.months << ", \"days\": " << t.days
+                << ", \"leaves\": " << t.leaves << ", \"measurements\": " << t.measurements << ", \"overflow\": " << t.overflow
+                << ", \"leaf_sizes\": [";
+            for (std::size_t n = 0; n < t.leafSizes.size(); n++) os << (n ? ", " : "") << t.leafSizes[n];
+            os << "] }";
+        }
+        os << "\n}\n";
+        return os.str();
+    }
+
+    std::string toPrometheus(const Metrics::Snapshot& s) {
+        std::ostringstream os;
+        for (int i = 0; i < static_cast<int>(Metrics::Counter::COUNT); i++) {
+            os << "# TYPE p06_" << COUNTER_NAMES[i] << "_total counter\n"
+                << "p06_" << COUNTER_NAMES[i] << "_total " << s.counters[i] << "\n";
+        }
+        os << "# TYPE p06_csv_lines_rejected_by_reason_total counter\n";
+        for (const auto& [reason, n] : s.rejected) os << "p06_csv_lines_rejected_by_reason_total{reason=" << quote(reason) << "} " << n << "\n";
+
+        for (int i = 0; i < static_cast<int>(Metrics::Histogram::COUNT); i++) {
+            const Metrics::HistogramSnapshot& h = s.histograms[i];
+            std::string name = std::string("p06_") + HISTOGRAM_NAMES[i];
+            os << "# TYPE " << name << " histogram\n";
+            std::uint64_t cumulative = 0;
+            for (int b = 0; b < Metrics::BUCKETS - 1; b++) {
+                cumulative += h.buckets[b];
+                os << name << "_bucket{le=\"" << bucketBound(b) << "\"} " << cumulative << "\n";
+            }
+            os << name << "_bucket{le=\"+Inf\"} " << h.count << "\n"
+                << name << "_sum " << h.sum << "\n"
+                << name << "_count " << h.count << "\n";
+        }
+
+        if (s.hasTree) {
+            const TreeShape& t = s.shape;
+            os << "# TYPE p06_tree_nodes gauge\n"
+                << "p06_tree_nodes{level=\"year\"} " << t.years << "\n"
+                << "p06_tree_nodes{level=\"month\"} " << t.months << "\n"
+                << "p06_tree_nodes{level=\"day\"} " << t.days << "\n"
+                << "p06_tree_nodes{level=\"block\"} " << t.leaves << "\n"
+                << "# TYPE p06_tree_measurements gauge\n"
+                << "p06_tree_measurements " << t.measurements << "\n"
+                << "# TYPE p06_tree_overflow_measurements gauge\n"
+                << "p06_tree_overflow_measurements " << t.overflow << "\n"
+                << "# TYPE p06_tree_blocks_by_size gauge\n";
+            for (std::size_t n = 0; n < t.leafSizes.size(); n++) {
+                if (t.leafSizes[n]) os << "p06_tree_blocks_by_size{measurements=\"" << n << "\"} " << t.leafSizes[n] << "\n";
+            }
+        }
+        return os.str();
+    }
+}
+
+/**
+ * @brief Zwraca przyblizony kwantyl - gorna granice kubelka zawierajacego obserwacje o randze q*count.
+ *
+ * @param q Kwantyl z przedzialu [0, 1].
+ * @return std::uint64_t Gorna granica kubelka.
+ */
+std::uint64_t Metrics::HistogramSnapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return bucketBound(b);
+    }
+    return bucketBound(BUCKETS - 1);
+}
+
+/**
+ * @brief Dolicza linie odrzucone z podanego powodu (wywolywane raz na import).
+ *
+ * @param reason Kategoria bledu.
+ * @param n Liczba linii.
+ */
+void Metrics::reject(const std::string& reason, std::uint64_t n) {
+    if constexpr (ENABLED) {
+        std::lock_guard<std::mutex> lock(rejectedMutex);
+        rejectedLines[reason] += n;
+    }
+}
+
+/**
+ * @brief Kopiuje liczniki i histogramy.
+ *
+ * Kazda wartosc jest odczytywana atomowo, ale zdarzenia rejestrowane
+ * w trakcie kopiowania moga byc uwzglednione tylko w czesci wartosci.
+ *
+ * @param tree Opcjonalne drzewo, ktorego ksztalt jest dolaczany.
+ * @return Metrics::Snapshot Stan statystyk.
+ */
+Metrics::Snapshot Metrics::stats(const EnergyTree* tree) {
+    Snapshot s;
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) s.counters[i] = counters[i].load(std::memory_order_relaxed);
+    for (int h = 0; h < static_cast<int>(Histogram::COUNT); h++) {
+        s.histograms[h].sum = histSums[h].load(std::memory_order_relaxed);
+        for (int b = 0; b < BUCKETS; b++) {
+            s.histograms[h].buckets[b] = histCounts[h][b].load(std::memory_order_relaxed);
+            s.histograms[h].count += s.histograms[h].buckets[b];
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(rejectedMutex);
+        s.rejected = rejectedLines;
+    }
+    if (tree) {
+        s.hasTree = true;
+        s.shape = tree->shape();
+    }
+    return s;
+}
+
+/**
+ * @brief Zeruje liczniki, histogramy i liczniki odrzuconych linii.
+ */
+void Metrics::reset() {
+    for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    for (auto& hist : histCounts) {
+        for (auto& b : hist) b.store(0, std::memory_order_relaxed);
+    }
+    for (auto& sum : histSums) sum.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(rejectedMutex);
+    rejectedLines.clear();
+}
+
+/**
+ * @brief Zamienia statystyki na tekst JSON lub Prometheus.
+ *
+ * Histogramy w formacie Prometheus sa skumulowane (le = gorna granica
+ * kubelka, wlacznie), zgodnie z typem histogram.
+ *
+ * @param s Statystyki.
+ * @param format Format wyjsciowy.
+ * @return std::string Tekst statystyk.
+ */
+std::string Metrics::format(const Snapshot& s, Format format) {
+    return format == Format::JSON ? toJson(s) : toPrometheus(s);
+}
+
+/**
+ * @brief Zapisuje biezace statystyki do pliku.
+ *
+ * @param filename Sciezka do pliku.
+ * @param format Format zapisu.
+ * @param tree Opcjonalne drzewo.
+ * @return bool True, jesli zapis sie powiodl.
+ */
+bool Metrics::dump(const std::string& filename, Format format, const EnergyTree* tree) {
+    std::ofstream ofs(filename, std::ios::trunc);
+    if (!ofs) return false;
+    ofs << Metrics::format(stats(tree), format);
+    return static_cast<bool>(ofs);
+}
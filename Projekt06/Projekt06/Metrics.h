@@ -0,0 +1,226 @@
+/**
+ * @file Metrics.h
+ * @brief Definicja licznikow i histogramow czasu dzialania (instrumentacja).
+ *
+ * Plik naglowkowy zawierajacy klase Metrics - zestaw globalnych licznikow
+ * zdarzen (linie CSV, dodane pomiary, bajty wczytane i zapisane, zapytania)
+ * oraz histogramow czasu, aktualizowanych na goracych sciezkach programu.
+ * Instrumentacje mozna wylaczyc w czasie kompilacji, definiujac
+ * P06_NO_METRICS - wszystkie wywolania staja sie wtedy pustymi funkcjami
+ * inline, ktore kompilator usuwa.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "EnergyTree.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#ifdef P06_NO_METRICS
+#define P06_METRICS_ENABLED false
+#else
+#define P06_METRICS_ENABLED true
+#endif
+
+ /**
+  * @class Metrics
+  * @brief Klasa statyczna z licznikami i histogramami wspolnymi dla calego programu.
+  *
+  * Liczniki sa zmiennymi atomowymi aktualizowanymi bez synchronizacji
+  * (memory_order_relaxed), wiec moga byc zwiekszane z wielu watkow.
+  * Histogramy maja kubelki potegi dwojki: kubelek i zawiera wartosci
+  * z przedzialu [2^(i-1), 2^i). Czas addMeasurement jest mierzony dla co
+  * SAMPLE_EVERY-tego wywolania na watek, aby pomiar nie wydluzal wstawiania.
+  * Licznosci linii odrzuconych wg powodu sa przekazywane raz na import
+  * (IngestLog::finish), a nie dla kazdej linii.
+  */
+class Metrics {
+public:
+    /** @brief Czy instrumentacja jest wkompilowana (false po zdefiniowaniu P06_NO_METRICS). */
+    static constexpr bool ENABLED = P06_METRICS_ENABLED;
+    /** @brief Liczba kubelkow histogramu (ostatni obejmuje wartosci >= 2^(BUCKETS-2)). */
+    static constexpr int BUCKETS = 40;
+    /** @brief Co ktore wywolanie addMeasurement (na watek) jest mierzone. */
+    static constexpr unsigned SAMPLE_EVERY = 64;
+
+    /**
+     * @brief Liczniki zdarzen.
+     */
+    enum class Counter {
+        CSV_LINES_OK,           /**< Linie CSV zaimportowane poprawnie. */
+        CSV_LINES_REJECTED,     /**< Linie CSV odrzucone (wszystkie powody). */
+        MEASUREMENTS_ADDED,     /**< Pomiary dodane do drzewa (addMeasurement i bulkLoad). */
+        DUPLICATES,             /**< Pomiary odrzucone jako duplikaty. */
+        BYTES_READ,             /**< Bajty plikow wczytanych przez FileManager. */
+        BYTES_WRITTEN,          /**< Bajty plikow zapisanych przez FileManager. */
+        QUERIES,                /**< Zapytania EnergyTree (aggregate, find, series). */
+        BLOCKS_SCANNED,         /**< Bloki (QuarterNode) przegladane pomiar po pomiarze przez zapytania. */
+        ITERATOR_BLOCKS,        /**< Bloki odwiedzone przez iteratory EnergyTree. */
+        COUNT                   /**< Liczba licznikow. */
+    };
+
+    /**
+     * @brief Histogramy wartosci (czasy w nanosekundach).
+     */
+    enum class Histogram {
+        ADD_NS,                 /**< Czas pojedynczego addMeasurement (probkowany). */
+        BULK_LOAD_NS,           /**< Czas wywolania bulkLoad. */
+        QUERY_NS,               /**< Czas zapytania EnergyTree. */
+        COUNT                   /**< Liczba histogramow. */
+    };
+
+    /**
+     * @struct HistogramSnapshot
+     * @brief Stan histogramu w chwili wykonania stats().
+     */
+    struct HistogramSnapshot {
+        std::uint64_t count = 0;                /**< Liczba obserwacji. */
+        std::uint64_t sum = 0;                  /**< Suma obserwowanych wartosci. */
+        std::uint64_t buckets[BUCKETS] = {};    /**< Liczba obserwacji w kubelkach. */
+
+        /**
+         * @brief Zwraca gorna granice kubelka, w ktorym lezy kwantyl q (przyblizenie z dokladnoscia do 2x).
+         * @param q Kwantyl z przedzialu [0, 1].
+         * @return std::uint64_t Gorna granica kubelka (0 dla pustego histogramu).
+         */
+        std::uint64_t quantile(double q) const;
+    };
+
+    /**
+     * @struct Snapshot
+     * @brief Spojna kopia wszystkich licznikow i histogramow (wynik stats()).
+     */
+    struct Snapshot {
+        std::uint64_t counters[static_cast<int>(Counter::COUNT)] = {};       /**< Wartosci licznikow, indeks = (int)Counter. */
+        HistogramSnapshot histograms[static_cast<int>(Histogram::COUNT)];    /**< Histogramy, indeks = (int)Histogram. */
+        std::map<std::string, std::uint64_t> rejected;                      /**< Linie odrzucone wg powodu (kategorii IngestLog). */
+        bool hasTree = false;                                               /**< Czy shape zawiera dane drzewa. */
+        TreeShape shape;                                                    /**< Ksztalt drzewa (liczby wezlow, rozmiary blokow). */
+
+        /** @brief Zwraca wartosc licznika. */
+        std::uint64_t counter(Counter c) const { return counters[static_cast<int>(c)]; }
+
+        /** @brief Zwraca histogram. */
+        const HistogramSnapshot& histogram(Histogram h) const { return histograms[static_cast<int>(h)]; }
+    };
+
+    /**
+     * @brief Format zapisu statystyk.
+     */
+    enum class Format {
+        JSON,       /**< Obiekt JSON. */
+        PROMETHEUS  /**< Format tekstowy Prometheus (np. dla node_exporter textfile collector). */
+    };
+
+    /**
+     * @brief Zwieksza licznik.
+     * @param c Licznik.
+     * @param n Wartosc dodawana.
+     */
+    static void add(Counter c, std::uint64_t n = 1) {
+        if constexpr (ENABLED) counters[static_cast<int>(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Dodaje obserwacje do histogramu.
+     * @param h Histogram.
+     * @param value Wartosc (np. czas w nanosekundach).
+     */
+    static void observe(Histogram h, std::uint64_t value) {
+        if constexpr (ENABLED) {
+            int b = std::min(static_cast<int>(std::bit_width(value)), BUCKETS - 1);
+            histCounts[static_cast<int>(h)][b].fetch_add(1, std::memory_order_relaxed);
+            histSums[static_cast<int>(h)].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Dolicza linie odrzucone z podanego powodu.
+     * @param reason Kategoria bledu.
+     * @param n Liczba linii.
+     */
+    static void reject(const std::string& reason, std::uint64_t n);
+
+    /**
+     * @brief Decyduje, czy biezace wywolanie ma byc mierzone (co SAMPLE_EVERY-te na watek).
+     * @return bool True dla mierzonego wywolania.
+     */
+    static bool sample() {
+        if constexpr (ENABLED) {
+            thread_local unsigned tick = 0;
+            return ++tick % SAMPLE_EVERY == 0;
+        }
+        else return false;
+    }
+
+    /**
+     * @class ScopedTimer
+     * @brief Mierzy czas od utworzenia do zniszczenia obiektu i dodaje go do histogramu.
+     */
+    class ScopedTimer {
+        Histogram hist;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    public:
+        /**
+         * @brief Rozpoczyna pomiar.
+         * @param h Histogram, do ktorego trafi czas.
+         * @param measure False pomija pomiar (np. wywolanie nieprobkowane).
+         */
+        explicit ScopedTimer(Histogram h, bool measure = true) : hist(h), active(ENABLED && measure) {
+            if (active) start = std::chrono::steady_clock::now();
+        }
+
+        /** @brief Konczy pomiar i zapisuje czas w nanosekundach. */
+        ~ScopedTimer() {
+            if (active) observe(hist, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+
+    /**
+     * @brief Zwraca kopie licznikow i histogramow.
+     *
+     * @param tree Opcjonalnie: drzewo, ktorego ksztalt (EnergyTree::shape) ma zostac dolaczony.
+     * @return Snapshot Stan statystyk.
+     */
+    static Snapshot stats(const EnergyTree* tree = nullptr);
+
+    /**
+     * @brief Zeruje wszystkie liczniki i histogramy.
+     */
+    static void reset();
+
+    /**
+     * @brief Zamienia statystyki na tekst w wybranym formacie.
+     * @param s Statystyki.
+     * @param format Format wyjsciowy.
+     * @return std::string Tekst statystyk.
+     */
+    static std::string format(const Snapshot& s, Format format);
+
+    /**
+     * @brief Zapisuje biezace statystyki do pliku.
+     *
+     * @param filename Sciezka do pliku docelowego.
+     * @param format Format zapisu.
+     * @param tree Opcjonalnie: drzewo, ktorego ksztalt ma zostac dolaczony.
+     * @return bool True, jesli zapis sie powiodl.
+     */
+    static bool dump(const std::string& filename, Format format, const EnergyTree* tree = nullptr);
+
+private:
+    static inline std::atomic<std::uint64_t> counters[static_cast<int>(Counter::COUNT)] = {};
+    static inline std::atomic<std::uint64_t> histCounts[static_cast<int>(Histogram::COUNT)][BUCKETS] = {};
+    static inline std::atomic<std::uint64_t> histSums[static_cast<int>(Histogram::COUNT)] = {};
+};
+
+#endif
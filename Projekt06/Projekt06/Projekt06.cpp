@@ -11,6 +11,8 @@
 #include <iostream>
 #include "FileManager.h"
 #include "Analyzer.h"
+#include "CsvFollower.h"
+#include "Metrics.h"
 
  /**
   * @brief Pobiera od uzytkownika date i czas w formacie numerycznym.
@@ -37,11 +39,14 @@ std::tm inputTime() {
  * Uruchamia petle do-while, ktora wyswietla menu i oczekuje na wybor opcji
  * przez uzytkownika. Obsluguje nastepujace funkcjonalnosci:
  * - 1: Wczytanie danych z pliku CSV.
+ * - 8: Wczytanie danych z pliku CSV z parsowaniem wielowatkowym.
  * - 2: Zapis danych do pliku binarnego.
  * - 3: Odczyt danych z pliku binarnego.
  * - 4: Obliczenie sumy wartosci dla danego typu i przedzialu czasu.
  * - 5: Obliczenie sredniej wartosci dla danego typu i przedzialu czasu.
  * - 7: Wyszukiwanie rekordow o zadanej wartosci z okreslona tolerancja.
+ * - 10: Doczytanie linii dopisanych do pliku CSV od poprzedniego doczytania.
+ * - 12: Percentyle P50/P95/P99 dla danego typu i przedzialu czasu.
  * - 0: Wyjscie z programu.
  *
  * @return int Kod wyjscia (0 oznacza poprawne zakonczenie).
@@ -49,34 +54,78 @@ std::tm inputTime() {
 int main() {
     EnergyTree tree;
     Analyzer analyzer(tree);
+    CsvFollower follower("Chart_Export.csv");
     int choice;
     do {
-        std::cout << "\n1. CSV 2. Zapis Bin 3. Odczyt Bin 4. Suma 5. Srednia 6. Porownaj 7. Szukaj 0. Wyjscie\nWybor: ";
+        std::cout << "\n1. CSV 2. Zapis Bin 3. Odczyt Bin 4. Suma 5. Srednia 6. Porownaj 7. Szukaj 8. CSV (wielowatkowo) 9. Zapis Bin (kompresja) 10. Doczytaj CSV 11. Statystyki 12. Percentyle 0. Wyjscie\nWybor: ";
         std::cin >> choice;
 
-        // Obsluga wczytywania pliku CSV
-        if (choice == 1) FileManager::loadCSV(tree, "Chart_Export.csv");
+        // Obsluga wczytywania pliku CSV (doczytywanie rusza od konca wczytanych danych)
+        if (choice == 1) {
+            IngestLog::Totals loaded = FileManager::loadCSV(tree, "Chart_Export.csv");
+            if (loaded.opened) follower.seek(loaded.consumed, loaded.separator);
+        }
+
+        // Obsluga wczytywania pliku CSV na wielu watkach
+        if (choice == 8) {
+            IngestLog::Totals loaded = FileManager::loadCSVParallel(tree, "Chart_Export.csv");
+            if (loaded.opened) follower.seek(loaded.consumed, loaded.separator);
+        }
+
+        // Obsluga doczytywania nowych linii pliku CSV (tylko dopisane od ostatniego razu)
+        if (choice == 10) {
+            std::size_t added = follower.poll(tree);
+            std::cout << "Doczytano: " << added << ", Blednych: " << follower.invalidCount() << ", Duplikatow: " << follower.duplicateCount() << "\n";
+        }
+
+        // Zapis statystyk programu (JSON i format Prometheus)
+        if (choice == 11) {
+            bool ok = Metrics::dump("stats.json", Metrics::Format::JSON, &tree) && Metrics::dump("stats.prom", Metrics::Format::PROMETHEUS, &tree);
+            std::cout << (ok ? "Zapisano stats.json i stats.prom\n" : "Nie mozna zapisac statystyk\n");
+        }
 
         // Obsluga zapisu do pliku binarnego
         if (choice == 2) FileManager::saveBinary(tree, "data.bin");
 
+        // Obsluga zapisu do skompresowanego pliku binarnego
+        if (choice == 9) FileManager::saveBinary(tree, "data.bin", true);
+
         // Obsluga odczytu z pliku binarnego
-        if (choice == 3) FileManager::loadBinary(tree, "data.bin");
+        if (choice == 3) {
+            FileManager::loadBinary(tree, "data.bin");
+            follower.reset(); // Drzewo wczytane od nowa - doczytywanie od poczatku pliku CSV
+        }
 
         // Obsluga operacji analitycznych: Suma (4) i Srednia (5)
         if (choice == 4 || choice == 5) {
             std::tm s = inputTime(), e = inputTime();
             int type; std::cout << "Typ (0-4): "; std::cin >> type;
-            if (choice == 4) std::cout << "Suma: " << analyzer.getSum(s, e, (DataType)type) << "\n";
+            if (type < 0 || type >= FIELD_COUNT) std::cout << "Nieprawidlowy typ danych\n";
+            else if (choice == 4) std::cout << "Suma: " << analyzer.getSum(s, e, (DataType)type) << "\n";
             else std::cout << "Srednia: " << analyzer.getAvg(s, e, (DataType)type) << "\n";
         }
 
+        // Percentyle wartosci (ze szkicow kwantyli drzewa)
+        if (choice == 12) {
+            std::tm s = inputTime(), e = inputTime();
+            int type; std::cout << "Typ (0-4): "; std::cin >> type;
+            if (type < 0 || type >= FIELD_COUNT) std::cout << "Nieprawidlowy typ danych\n";
+            else {
+                std::vector<double> p = analyzer.getPercentiles(s, e, (DataType)type, { 0.5, 0.95, 0.99 });
+                std::cout << "P50: " << p[0] << " W, P95: " << p[1] << " W, P99: " << p[2] << " W\n";
+            }
+        }
+
         // Obsluga wyszukiwania wartosci z tolerancja
         if (choice == 7) {
             std::tm s = inputTime(), e = inputTime();
             double v, t; std::cout << "Wartosc i tolerancja: "; std::cin >> v >> t;
             // Domyslnie szuka dla typu IMPORT (mozna zmienic w kodzie w razie potrzeby)
-            analyzer.search(DataType::IMPORT, v, t, s, e);
+            std::vector<Measurement> found = analyzer.search(DataType::IMPORT, v, t, s, e);
+            for (const Measurement& m : found) {
+                std::cout << "Znaleziono: " << m.importEnergy << " W przy dacie " << m.timestamp.tm_mday << "." << m.timestamp.tm_mon + 1 << "\n";
+            }
+            std::cout << "Liczba znalezionych: " << found.size() << "\n";
         }
     } while (choice != 0);
     return 0;
@@ -0,0 +1,200 @@
+/**
+ * @file QuantileSketch.cpp
+ * @brief Implementacja szkicu kwantyli: klucze kubelkow, wstawianie, scalanie i odczyt.
+ */
+
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+    /** @brief Iloraz granic kolejnych kubelkow. */
+    const double GAMMA = (1 + QuantileSketch::RELATIVE_ERROR) / (1 - QuantileSketch::RELATIVE_ERROR);
+
+    /** @brief Najwiekszy klucz (modul) - wartosci wieksze trafiaja do ostatniego kubelka. */
+    constexpr std::int32_t MAX_KEY = 4096;
+
+    /** @brief Gorne granice kubelkow: BOUNDS[k] = MIN_MAGNITUDE * GAMMA^(k-1), k = 0..MAX_KEY. */
+    const std::vector<double> BOUNDS = [] {
+        std::vector<double> b(MAX_KEY + 1);
+        for (std::int32_t k = 0; k <= MAX_KEY; k++) b[k] = QuantileSketch::MIN_MAGNITUDE * std::pow(GAMMA, k - 1);
+        return b;
+    }();
+
+    /** @brief Liczba kubelkow na podwojenie wartosci: 1 / log2(GAMMA). */
+    const double KEYS_PER_OCTAVE = std::log(2.0) / std::log(GAMMA);
+
+    /** @brief Liczba najstarszych bitow mantysy uzywanych do szacowania klucza. */
+    constexpr int MANTISSA_BITS = 10;
+
+    /** @brief Logarytm log2(1 + i / 2^MANTISSA_BITS) - przyblizenie logarytmu mantysy. */
+    const std::vector<double> LOG2_MANTISSA = [] {
+        std::vector<double> t(1 << MANTISSA_BITS);
+        for (int i = 0; i < (1 << MANTISSA_BITS); i++) t[i] = std::log2(1 + i / double(1 << MANTISSA_BITS));
+        return t;
+    }();
+}
+
+/**
+ * @brief Wyznacza klucz kubelka.
+ *
+ * Dla |v| >= MIN_MAGNITUDE klucz k >= 1 oznacza kubelek
+ * (BOUNDS[k - 1], BOUNDS[k]], a dla wartosci ujemnych uzywany jest klucz -k,
+ * dzieki czemu porzadek kluczy odpowiada porzadkowi wartosci. Zamiast
+ * logarytmu klucz jest szacowany z wykladnika i najstarszych bitow mantysy
+ * (zwykle trafnie, najwyzej o jeden kubelek za nisko), a nastepnie
+ * korygowany porownaniem z tablica granic - wynik jest dokladny.
+ *
+ * @param v Wartosc.
+ * @return std::int32_t Klucz kubelka.
+ */
+std::int32_t QuantileSketch::key(double v) {
+    double a = std::fabs(v);
+    if (!(a >= MIN_MAGNITUDE)) return 0; // Takze NaN
+    std::int32_t k = MAX_KEY;
+    if (a <= BOUNDS[MAX_KEY - 1]) {
+        std::uint64_t bits = std::bit_cast<std::uint64_t>(a * (1 / MIN_MAGNITUDE));
+        int exponent = static_cast<int>(bits >> 52) - 1023;
+        double log2 = exponent + LOG2_MANTISSA[(bits >> (52 - MANTISSA_BITS)) & ((1u << MANTISSA_BITS) - 1)];
+        k = std::clamp(static_cast<std::int32_t>(log2 * KEYS_PER_OCTAVE) + 2, 1, MAX_KEY - 1);
+        while (a > BOUNDS[k]) k++;
+        while (k > 1 && a <= BOUNDS[k - 1]) k--;
+    }
+    return v < 0 ? -k : k;
+}
+
+/**
+ * @brief Zwraca wartosc reprezentujaca kubelek.
+ *
+ * Wartosc 2 * g / (GAMMA + 1), gdzie g to gorna granica kubelka, lezy
+ * w odleglosci wzglednej co najwyzej RELATIVE_ERROR od kazdej wartosci
+ * kubelka.
+ *
+ * @param key Klucz kubelka.
+ * @return double Wartosc reprezentatywna (0 dla kubelka zerowego).
+ */
+double QuantileSketch::value(std::int32_t key) {
+    if (key == 0) return 0;
+    double v = 2 * BOUNDS[std::abs(key)] / (GAMMA + 1);
+    return key < 0 ? -v : v;
+}
+
+/**
+ * @brief Dodaje wartosc do kubelka o podanym kluczu.
+ *
+ * @param v Dodawana wartosc.
+ * @param k Klucz kubelka.
+ */
+void QuantileSketch::add(double v, std::int32_t k) {
+    addCount(k, 1);
+    total++;
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+}
+
+/**
+ * @brief Zwieksza licznik kubelka.
+ *
+ * Zakres tablicy jest w razie potrzeby poszerzany o brakujace klucze
+ * z przodu lub z tylu, a licznik indeksowany wprost. Poszerzenie z przodu
+ * wymaga przesuniecia tablicy, dlatego dodawany jest zapas (polowa
+ * biezacego rozmiaru) - kolejne nowe minima zwykle juz sie w nim mieszcza.
+ *
+ * @param k Klucz kubelka.
+ * @param n Dodawana liczba wartosci.
+ */
+void QuantileSketch::addCount(std::int32_t k, std::uint32_t n) {
+    if (k == 0) {
+        zeros += n;
+        return;
+    }
+    if (counts.empty()) base = k;
+    if (k < base) {
+        std::int32_t from = std::max(k - static_cast<std::int32_t>(counts.size() / 2), -MAX_KEY);
+        counts.insert(counts.begin(), static_cast<std::size_t>(base - from), 0);
+        base = from;
+    }
+    std::size_t i = static_cast<std::size_t>(k - base);
+    if (i >= counts.size()) counts.resize(i + 1, 0);
+    counts[i] += n;
+}
+
+/**
+ * @brief Dolacza inny szkic.
+ *
+ * Zakres tablicy jest poszerzany raz (o skrajne niepuste klucze drugiego
+ * szkicu), a liczniki sa dodawane w jednej petli po tablicy drugiego szkicu.
+ *
+ * @param other Szkic do dolaczenia.
+ */
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.total == 0) return;
+    zeros += other.zeros;
+    std::size_t from = 0, to = other.counts.size();
+    while (from < to && other.counts[from] == 0) from++;
+    while (to > from && other.counts[to - 1] == 0) to--;
+    if (from < to) {
+        std::int32_t first = other.base + static_cast<std::int32_t>(from);
+        addCount(first, 0);
+        addCount(other.base + static_cast<std::int32_t>(to) - 1, 0);
+        std::uint32_t* dst = counts.data() + (first - base);
+        for (std::size_t i = from; i < to; i++) dst[i - from] += other.counts[i];
+    }
+    total += other.total;
+    lo = std::min(lo, other.lo);
+    hi = std::max(hi, other.hi);
+}
+
+/**
+ * @brief Oproznia szkic.
+ *
+ * Liczniki sa zerowane, ale zakres kluczy zostaje - szkic uzywany ponownie
+ * (np. roboczy szkic miesiaca w EnergyTree::bulkLoad) nie musi go odbudowywac.
+ */
+void QuantileSketch::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    zeros = 0;
+    total = 0;
+    lo = std::numeric_limits<double>::infinity();
+    hi = -std::numeric_limits<double>::infinity();
+}
+
+/**
+ * @brief Liczy niepuste kubelki.
+ * @return std::size_t Liczba niepustych kubelkow.
+ */
+std::size_t QuantileSketch::size() const {
+    std::size_t n = 0;
+    forEach([&n](std::int32_t, std::uint32_t) { n++; });
+    return n;
+}
+
+/**
+ * @brief Odczytuje kwantyl z licznikow kubelkow.
+ *
+ * Kubelki sa przegladane rosnaco do chwili, gdy skumulowana liczba wartosci
+ * przekroczy range q * (count() - 1). Wynik jest ograniczany do [min, max],
+ * wiec nigdy nie wychodzi poza zakres danych.
+ *
+ * @param q Rzad kwantyla.
+ * @return double Wartosc kwantyla.
+ */
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0;
+    if (q <= 0) return lo;
+    if (q >= 1) return hi;
+    double rank = q * static_cast<double>(total - 1);
+    std::size_t seen = 0;
+    double result = hi;
+    bool found = false;
+    forEach([&](std::int32_t k, std::uint32_t n) {
+        if (found) return;
+        seen += n;
+        if (static_cast<double>(seen) > rank) {
+            result = std::clamp(value(k), lo, hi);
+            found = true;
+        }
+    });
+    return result;
+}
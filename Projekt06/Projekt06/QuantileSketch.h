@@ -0,0 +1,193 @@
+/**
+ * @file QuantileSketch.h
+ * @brief Definicja laczliwego szkicu kwantyli o ograniczonym bledzie wzglednym.
+ *
+ * Plik naglowkowy zawierajacy klase QuantileSketch (histogram o kubelkach
+ * rosnacych geometrycznie) oraz NodeSketches - komplet szkicow wszystkich
+ * pol pomiaru przechowywany w wezlach miesiaca i roku drzewa.
+ */
+
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include "Measurement.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+ /**
+  * @class QuantileSketch
+  * @brief Szkic rozkladu wartosci jednego pola (kubelki logarytmiczne, jak w DDSketch).
+  *
+  * Wartosc v o module co najmniej MIN_MAGNITUDE trafia do kubelka o kluczu
+  * wyznaczonym przez ceil(log_gamma(|v| / MIN_MAGNITUDE)), gdzie
+  * gamma = (1 + RELATIVE_ERROR) / (1 - RELATIVE_ERROR); mniejsze wartosci
+  * trafiaja do kubelka zerowego. Kwantyl jest odczytywany jako srodek kubelka
+  * zawierajacego pomiar o danej randze, wiec rozni sie od dokladnego
+  * co najwyzej o RELATIVE_ERROR wzglednie (lub o MIN_MAGNITUDE bezwzglednie
+  * dla wartosci bliskich zeru).
+  *
+  * Liczniki kubelkow sa przechowywane w tablicy dla ciaglego zakresu kluczy
+  * niezerowych [base, base + counts.size()), a kubelek zerowy osobno - zakres
+  * obejmuje wiec tylko rzeczywisty rozrzut wartosci (np. dla produkcji z jednego
+  * dnia kilkaset kubelkow), a dodanie wartosci i laczenie szkicow to
+  * indeksowanie i dodawanie tablic. Laczenie nie traci dokladnosci - wynik
+  * nie zalezy od kolejnosci wstawiania ani laczenia, a szkic przedzialu
+  * zlozony ze szkicow wezlow jest identyczny ze szkicem zbudowanym
+  * z pojedynczych pomiarow.
+  */
+class QuantileSketch {
+public:
+    /** @brief Gwarantowany blad wzgledny odczytanego kwantyla. */
+    static constexpr double RELATIVE_ERROR = 0.01;
+
+    /** @brief Najmniejszy modul wartosci rozrozniany od zera. */
+    static constexpr double MIN_MAGNITUDE = 1e-3;
+
+    /** @brief Alokator licznikow (konstrukcja z alokatorem w wezlach drzewa). */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /**
+     * @brief Konstruktor pustego szkicu.
+     * @param alloc Alokator licznikow (domyslnie std::pmr::get_default_resource()).
+     */
+    explicit QuantileSketch(const allocator_type& alloc = {}) : counts(alloc) {}
+
+    /**
+     * @brief Wyznacza klucz kubelka dla wartosci (rosnacy wraz z wartoscia).
+     * @param v Wartosc.
+     * @return std::int32_t Klucz kubelka.
+     */
+    static std::int32_t key(double v);
+
+    /**
+     * @brief Zwraca wartosc reprezentujaca kubelek (srodek jego zakresu w sensie bledu wzglednego).
+     * @param key Klucz kubelka.
+     * @return double Wartosc reprezentatywna.
+     */
+    static double value(std::int32_t key);
+
+    /**
+     * @brief Dodaje wartosc do szkicu.
+     * @param v Dodawana wartosc (NaN jest pomijany).
+     */
+    void add(double v) { if (v == v) add(v, key(v)); }
+
+    /**
+     * @brief Dodaje wartosc z kluczem wyliczonym wczesniej (np. raz dla kilku poziomow drzewa).
+     * @param v Dodawana wartosc.
+     * @param k Klucz kubelka: key(v).
+     */
+    void add(double v, std::int32_t k);
+
+    /**
+     * @brief Dolacza zawartosc innego szkicu bez utraty dokladnosci.
+     *
+     * Scalanie odbywa sie w miejscu - nowa pamiec jest potrzebna tylko wtedy,
+     * gdy przybywa kubelkow ponad pojemnosc licznikow.
+     *
+     * @param other Szkic do dolaczenia.
+     */
+    void merge(const QuantileSketch& other);
+
+    /**
+     * @brief Oproznia szkic (zakres i pamiec licznikow zostaja zachowane).
+     */
+    void clear();
+
+    /**
+     * @brief Zwraca przyblizony kwantyl rzedu q.
+     *
+     * Ranga pomiaru to q * (count() - 1), jak przy wyborze elementu
+     * z posortowanej tablicy. Dla q <= 0 i q >= 1 zwracane sa dokladne
+     * minimum i maksimum.
+     *
+     * @param q Rzad kwantyla z przedzialu [0, 1] (np. 0.95).
+     * @return double Wartosc kwantyla; 0 dla pustego szkicu.
+     */
+    double quantile(double q) const;
+
+    /** @brief Zwraca liczbe wartosci w szkicu. */
+    std::size_t count() const { return total; }
+
+    /** @brief Zwraca liczbe niepustych kubelkow. */
+    std::size_t size() const;
+
+    /** @brief Zwraca najmniejsza dodana wartosc. */
+    double min() const { return lo; }
+
+    /** @brief Zwraca najwieksza dodana wartosc. */
+    double max() const { return hi; }
+
+private:
+    /**
+     * @brief Dodaje n wartosci do kubelka o kluczu k (bez zmiany count, min i max).
+     */
+    void addCount(std::int32_t k, std::uint32_t n);
+
+    /**
+     * @brief Wywoluje fn(klucz, licznik) dla niepustych kubelkow, rosnaco wg klucza.
+     */
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        bool zeroDone = zeros == 0;
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            std::int32_t k = base + static_cast<std::int32_t>(i);
+            if (!zeroDone && k > 0) {
+                fn(0, zeros);
+                zeroDone = true;
+            }
+            if (counts[i]) fn(k, counts[i]);
+        }
+        if (!zeroDone) fn(0, zeros);
+    }
+
+    std::pmr::vector<std::uint32_t> counts;                 /**< Liczniki kolejnych kluczy od base (licznik klucza 0 nieuzywany). */
+    std::int32_t base = 0;                                  /**< Klucz kubelka counts[0]. */
+    std::uint32_t zeros = 0;                                /**< Licznik kubelka zerowego. */
+    std::size_t total = 0;                                  /**< Liczba wartosci. */
+    double lo = std::numeric_limits<double>::infinity();    /**< Minimum wartosci. */
+    double hi = -std::numeric_limits<double>::infinity();   /**< Maksimum wartosci. */
+};
+
+/**
+ * @struct NodeSketches
+ * @brief Szkice kwantyli wszystkich pol pomiaru w poddrzewie wezla.
+ */
+struct NodeSketches {
+    QuantileSketch fields[FIELD_COUNT]; /**< Szkice pol, indeks = (int)DataType. */
+
+    /** @brief Alokator kubelkow wszystkich szkicow. */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /**
+     * @brief Konstruktor pustych szkicow.
+     * @param alloc Alokator licznikow.
+     */
+    explicit NodeSketches(const allocator_type& alloc = {})
+        : fields{ QuantileSketch(alloc), QuantileSketch(alloc), QuantileSketch(alloc), QuantileSketch(alloc), QuantileSketch(alloc) } {
+        static_assert(FIELD_COUNT == 5, "Lista inicjalizacji fields musi miec FIELD_COUNT elementow");
+    }
+
+    /**
+     * @brief Dodaje wartosci pol pomiaru z wyliczonymi wczesniej kluczami.
+     * @param row Wartosci pol w kolejnosci DataType.
+     * @param keys Klucze kubelkow wartosci (QuantileSketch::key).
+     */
+    void add(const double (&row)[FIELD_COUNT], const std::int32_t (&keys)[FIELD_COUNT]) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            if (row[f] == row[f]) fields[f].add(row[f], keys[f]);
+        }
+    }
+
+    /**
+     * @brief Zwraca szkic wskazanego pola.
+     * @param type Typ danych.
+     * @return const QuantileSketch& Szkic pola.
+     */
+    const QuantileSketch& field(DataType type) const { return fields[static_cast<int>(type)]; }
+};
+
+#endif
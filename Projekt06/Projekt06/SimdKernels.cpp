@@ -0,0 +1,385 @@
+/**
+ * @file SimdKernels.cpp
+ * @brief Implementacja petli SIMD oraz wyboru ich wersji w czasie wykonania.
+ *
+ * Kazda petla wystepuje w trzech wersjach (AVX2, SSE2, skalarnej) o tym
+ * samym przydziale elementow do akumulatorow. Wersje wektorowe przetwarzaja
+ * pelne czworki elementow, a koncowke kolumny dokancza kod skalarny na
+ * akumulatorach zrzuconych z rejestrow. Funkcje AVX2 sa kompilowane
+ * z atrybutem docelowego zestawu instrukcji, wiec nie wymagaja zmiany
+ * opcji kompilatora dla calego projektu.
+ */
+
+#include "SimdKernels.h"
+#include <atomic>
+#include <bit>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_SSE2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+namespace {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    constexpr int LANES = SimdKernels::LANES;
+
+    /**
+     * @brief Akumulatory petli w postaci tablic (wspolne dla wszystkich wersji).
+     */
+    struct Lanes {
+        double sum[LANES] = { 0, 0, 0, 0 };
+        double min[LANES] = { INF, INF, INF, INF };
+        double max[LANES] = { -INF, -INF, -INF, -INF };
+
+        /** @brief Uwzglednia wartosc w akumulatorze k (semantyka FieldStats::add). */
+        void add(int k, double v) {
+            sum[k] += v;
+            if (v < min[k]) min[k] = v;
+            if (v > max[k]) max[k] = v;
+        }
+
+        /** @brief Laczy akumulatory w ustalonej kolejnosci i dolacza wynik do statystyk. */
+        void finish(FieldStats& out) const {
+            out.sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+            for (int k = 0; k < LANES; k++) {
+                if (min[k] < out.min) out.min = min[k];
+                if (max[k] > out.max) out.max = max[k];
+            }
+        }
+    };
+
+    /** @brief Obcina maske do pierwszych n pozycji. */
+    std::uint32_t clip(std::uint32_t mask, int n) {
+        return n >= 32 ? mask : mask & ((1u << n) - 1);
+    }
+
+    // --- Wersje skalarne (rowniez koncowki wersji wektorowych) ---
+
+    void statsTail(Lanes& l, const double* v, std::size_t from, std::size_t n) {
+        for (std::size_t i = from; i < n; i++) l.add(static_cast<int>(i % LANES), v[i]);
+    }
+
+    void maskedStatsTail(Lanes& l, const double* v, std::uint32_t bits) {
+        for (; bits; bits &= bits - 1) {
+            int i = std::countr_zero(bits);
+            l.add(i % LANES, v[i]);
+        }
+    }
+
+    std::uint32_t maskedMatchTail(const double* v, std::uint32_t bits, double lo, double hi) {
+        std::uint32_t hit = 0;
+        for (; bits; bits &= bits - 1) {
+            int i = std::countr_zero(bits);
+            if (v[i] >= lo && v[i] <= hi) hit |= 1u << i;
+        }
+        return hit;
+    }
+
+    void matchTail(const double* v, std::size_t from, std::size_t n, double lo, double hi, std::vector<std::size_t>& out) {
+        for (std::size_t i = from; i < n; i++) {
+            if (v[i] >= lo && v[i] <= hi) out.push_back(i);
+        }
+    }
+
+    void statsScalar(const double* v, std::size_t n, FieldStats& out) {
+        Lanes l;
+        statsTail(l, v, 0, n);
+        l.finish(out);
+    }
+
+    void maskedStatsScalar(const double* v, int n, std::uint32_t mask, FieldStats& out) {
+        Lanes l;
+        maskedStatsTail(l, v, clip(mask, n));
+        l.finish(out);
+    }
+
+    std::uint32_t maskedMatchScalar(const double* v, int n, std::uint32_t mask, double lo, double hi) {
+        return maskedMatchTail(v, clip(mask, n), lo, hi);
+    }
+
+    void matchScalar(const double* v, std::size_t n, double lo, double hi, std::vector<std::size_t>& out) {
+        matchTail(v, 0, n, lo, hi, out);
+    }
+
+#ifdef SIMD_X86
+    // --- SSE2: dwa rejestry po dwie liczby (akumulatory 0-1 i 2-3) ---
+
+    /** @brief Maska dwoch sasiednich pozycji (bity 0-1 argumentu). */
+    SIMD_TARGET_SSE2 __m128d pairMask(std::uint32_t two) {
+        return _mm_castsi128_pd(_mm_set_epi64x(-static_cast<long long>((two >> 1) & 1), -static_cast<long long>(two & 1)));
+    }
+
+    /** @brief Wybiera x tam, gdzie maska jest ustawiona, a fill w pozostalych pozycjach. */
+    SIMD_TARGET_SSE2 __m128d select(__m128d m, __m128d x, __m128d fill) {
+        return _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, fill));
+    }
+
+    struct Sse2Acc {
+        __m128d sum[2], min[2], max[2];
+
+        SIMD_TARGET_SSE2 Sse2Acc() {
+            for (int h = 0; h < 2; h++) {
+                sum[h] = _mm_setzero_pd(); min[h] = _mm_set1_pd(INF); max[h] = _mm_set1_pd(-INF);
+            }
+        }
+
+        SIMD_TARGET_SSE2 void spill(Lanes& l) const {
+            for (int h = 0; h < 2; h++) {
+                _mm_storeu_pd(l.sum + 2 * h, sum[h]);
+                _mm_storeu_pd(l.min + 2 * h, min[h]);
+                _mm_storeu_pd(l.max + 2 * h, max[h]);
+            }
+        }
+    };
+
+    SIMD_TARGET_SSE2 void statsSse2(const double* v, std::size_t n, FieldStats& out) {
+        Sse2Acc a;
+        std::size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            for (int h = 0; h < 2; h++) {
+                __m128d x = _mm_loadu_pd(v + i + 2 * h);
+                a.sum[h] = _mm_add_pd(a.sum[h], x);
+                a.min[h] = _mm_min_pd(x, a.min[h]);
+                a.max[h] = _mm_max_pd(x, a.max[h]);
+            }
+        }
+        Lanes l;
+        a.spill(l);
+        statsTail(l, v, i, n);
+        l.finish(out);
+    }
+
+    SIMD_TARGET_SSE2 void maskedStatsSse2(const double* v, int n, std::uint32_t mask, FieldStats& out) {
+        mask = clip(mask, n);
+        Sse2Acc a;
+        const __m128d inf = _mm_set1_pd(INF), ninf = _mm_set1_pd(-INF);
+        int i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            std::uint32_t quad = (mask >> i) & 0xF;
+            if (!quad) continue;
+            for (int h = 0; h < 2; h++) {
+                __m128d m = pairMask(quad >> (2 * h));
+                __m128d x = _mm_loadu_pd(v + i + 2 * h);
+                a.sum[h] = _mm_add_pd(a.sum[h], _mm_and_pd(m, x));
+                a.min[h] = _mm_min_pd(select(m, x, inf), a.min[h]);
+                a.max[h] = _mm_max_pd(select(m, x, ninf), a.max[h]);
+            }
+        }
+        Lanes l;
+        a.spill(l);
+        if (i < 32) maskedStatsTail(l, v, mask & (~0u << i));
+        l.finish(out);
+    }
+
+    SIMD_TARGET_SSE2 std::uint32_t maskedMatchSse2(const double* v, int n, std::uint32_t mask, double lo, double hi) {
+        mask = clip(mask, n);
+        const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+        std::uint32_t hit = 0;
+        int i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(v + i);
+            __m128d in = _mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi));
+            hit |= static_cast<std::uint32_t>(_mm_movemask_pd(in)) << i;
+        }
+        hit &= mask;
+        if (i < 32) hit |= maskedMatchTail(v, mask & (~0u << i), lo, hi);
+        return hit;
+    }
+
+    SIMD_TARGET_SSE2 void matchSse2(const double* v, std::size_t n, double lo, double hi, std::vector<std::size_t>& out) {
+        const __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+        std::size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(v + i);
+            int bits = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi)));
+            if (bits & 1) out.push_back(i);
+            if (bits & 2) out.push_back(i + 1);
+        }
+        matchTail(v, i, n, lo, hi, out);
+    }
+
+    // --- AVX2: jeden rejestr z czterema akumulatorami ---
+
+    /** @brief Maska czterech sasiednich pozycji (bity 0-3 argumentu). */
+    SIMD_TARGET_AVX2 __m256d quadMask(std::uint32_t quad) {
+        const __m256i sel = _mm256_set_epi64x(8, 4, 2, 1);
+        __m256i q = _mm256_and_si256(_mm256_set1_epi64x(quad), sel);
+        return _mm256_castsi256_pd(_mm256_cmpeq_epi64(q, sel));
+    }
+
+    SIMD_TARGET_AVX2 void spillAvx2(Lanes& l, __m256d sum, __m256d min, __m256d max) {
+        _mm256_storeu_pd(l.sum, sum);
+        _mm256_storeu_pd(l.min, min);
+        _mm256_storeu_pd(l.max, max);
+    }
+
+    SIMD_TARGET_AVX2 void statsAvx2(const double* v, std::size_t n, FieldStats& out) {
+        __m256d sum = _mm256_setzero_pd(), min = _mm256_set1_pd(INF), max = _mm256_set1_pd(-INF);
+        std::size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            sum = _mm256_add_pd(sum, x);
+            min = _mm256_min_pd(x, min);
+            max = _mm256_max_pd(x, max);
+        }
+        Lanes l;
+        spillAvx2(l, sum, min, max);
+        statsTail(l, v, i, n);
+        l.finish(out);
+    }
+
+    SIMD_TARGET_AVX2 void maskedStatsAvx2(const double* v, int n, std::uint32_t mask, FieldStats& out) {
+        mask = clip(mask, n);
+        __m256d sum = _mm256_setzero_pd(), min = _mm256_set1_pd(INF), max = _mm256_set1_pd(-INF);
+        const __m256d inf = _mm256_set1_pd(INF), ninf = _mm256_set1_pd(-INF);
+        int i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            std::uint32_t quad = (mask >> i) & 0xF;
+            if (!quad) continue;
+            __m256d m = quadMask(quad);
+            __m256d x = _mm256_loadu_pd(v + i);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(m, x));
+            min = _mm256_min_pd(_mm256_blendv_pd(inf, x, m), min);
+            max = _mm256_max_pd(_mm256_blendv_pd(ninf, x, m), max);
+        }
+        Lanes l;
+        spillAvx2(l, sum, min, max);
+        if (i < 32) maskedStatsTail(l, v, mask & (~0u << i));
+        l.finish(out);
+    }
+
+    SIMD_TARGET_AVX2 std::uint32_t maskedMatchAvx2(const double* v, int n, std::uint32_t mask, double lo, double hi) {
+        mask = clip(mask, n);
+        const __m256d vlo = _mm256_set1_pd(lo), vhi = _mm256_set1_pd(hi);
+        std::uint32_t hit = 0;
+        int i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            __m256d in = _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ), _mm256_cmp_pd(x, vhi, _CMP_LE_OQ));
+            hit |= static_cast<std::uint32_t>(_mm256_movemask_pd(in)) << i;
+        }
+        hit &= mask;
+        if (i < 32) hit |= maskedMatchTail(v, mask & (~0u << i), lo, hi);
+        return hit;
+    }
+
+    SIMD_TARGET_AVX2 void matchAvx2(const double* v, std::size_t n, double lo, double hi, std::vector<std::size_t>& out) {
+        const __m256d vlo = _mm256_set1_pd(lo), vhi = _mm256_set1_pd(hi);
+        std::size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            __m256d in = _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ), _mm256_cmp_pd(x, vhi, _CMP_LE_OQ));
+            for (unsigned bits = static_cast<unsigned>(_mm256_movemask_pd(in)); bits; bits &= bits - 1) {
+                out.push_back(i + std::countr_zero(bits));
+            }
+        }
+        matchTail(v, i, n, lo, hi, out);
+    }
+#endif
+
+    /**
+     * @brief Zestaw wersji petli dla jednego poziomu instrukcji.
+     */
+    struct Table {
+        SimdKernels::Level level;
+        void (*stats)(const double*, std::size_t, FieldStats&);
+        void (*maskedStats)(const double*, int, std::uint32_t, FieldStats&);
+        std::uint32_t (*maskedMatch)(const double*, int, std::uint32_t, double, double);
+        void (*match)(const double*, std::size_t, double, double, std::vector<std::size_t>&);
+    };
+
+    const Table SCALAR_TABLE = { SimdKernels::Level::SCALAR, statsScalar, maskedStatsScalar, maskedMatchScalar, matchScalar };
+#ifdef SIMD_X86
+    const Table SSE2_TABLE = { SimdKernels::Level::SSE2, statsSse2, maskedStatsSse2, maskedMatchSse2, matchSse2 };
+    const Table AVX2_TABLE = { SimdKernels::Level::AVX2, statsAvx2, maskedStatsAvx2, maskedMatchAvx2, matchAvx2 };
+#endif
+
+    const Table* tableFor(SimdKernels::Level l) {
+#ifdef SIMD_X86
+        if (l == SimdKernels::Level::AVX2) return &AVX2_TABLE;
+        if (l == SimdKernels::Level::SSE2) return &SSE2_TABLE;
+#endif
+        return &SCALAR_TABLE;
+    }
+
+    /** @brief Aktualnie uzywany zestaw petli (nullptr = jeszcze nie wybrany). */
+    std::atomic<const Table*> active{ nullptr };
+
+    const Table& table() {
+        const Table* t = active.load(std::memory_order_acquire);
+        if (!t) {
+            t = tableFor(SimdKernels::detect());
+            active.store(t, std::memory_order_release);
+        }
+        return *t;
+    }
+}
+
+/**
+ * @brief Wykrywa zestaw instrukcji procesora.
+ *
+ * Na x86 AVX2 wymaga wsparcia zarowno procesora (CPUID), jak i systemu
+ * operacyjnego (zapis rejestrow YMM - XGETBV). SSE2 jest dostepne na kazdym
+ * procesorze x86-64. Na innych architekturach zwraca Level::SCALAR.
+ *
+ * @return SimdKernels::Level Wykryty poziom.
+ */
+SimdKernels::Level SimdKernels::detect() {
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return Level::AVX2;
+    }
+    return sse2 ? Level::SSE2 : Level::SCALAR;
+#elif defined(SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Level::SSE2;
+    return Level::SCALAR;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+SimdKernels::Level SimdKernels::level() {
+    return table().level;
+}
+
+SimdKernels::Level SimdKernels::setLevel(Level l) {
+    if (static_cast<int>(l) > static_cast<int>(detect())) l = detect();
+    const Table* t = tableFor(l);
+    active.store(t, std::memory_order_release);
+    return t->level;
+}
+
+void SimdKernels::stats(const double* values, std::size_t n, FieldStats& out) {
+    table().stats(values, n, out);
+}
+
+void SimdKernels::maskedStats(const double* values, int n, std::uint32_t mask, FieldStats& out) {
+    table().maskedStats(values, n, mask, out);
+}
+
+std::uint32_t SimdKernels::maskedMatch(const double* values, int n, std::uint32_t mask, double lo, double hi) {
+    return table().maskedMatch(values, n, mask, lo, hi);
+}
+
+void SimdKernels::match(const double* values, std::size_t n, double lo, double hi, std::vector<std::size_t>& out) {
+    table().match(values, n, lo, hi, out);
+}
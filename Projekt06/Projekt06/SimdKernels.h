@@ -0,0 +1,113 @@
+/**
+ * @file SimdKernels.h
+ * @brief Definicja wektorowych (SIMD) petli agregujacych i filtrujacych kolumny wartosci.
+ *
+ * Plik naglowkowy zawierajacy klase SimdKernels - zestaw funkcji liczacych
+ * sume, minimum i maksimum oraz wyszukujacych wartosci z zadanego przedzialu
+ * w kolumnach double (sloty liscia QuarterNode, listy nadmiarowe, bloki
+ * BinaryArchive). Kazda funkcja ma wersje AVX2, SSE2 i skalarna; wersja
+ * jest wybierana raz, przy pierwszym uzyciu, na podstawie mozliwosci procesora.
+ */
+
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include "TreeStructure.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+ /**
+  * @class SimdKernels
+  * @brief Klasa statyczna z petlami agregujacymi kolumny wartosci.
+  *
+  * Wszystkie wersje sumuja w tym samym porzadku: element i trafia do
+  * akumulatora (i % LANES), a na koncu akumulatory sa laczone jako
+  * (a0 + a1) + (a2 + a3). Wynik jest wiec identyczny (co do bitu) niezaleznie
+  * od wybranej wersji, a rozni sie od sumowania sekwencyjnego jedynie
+  * bledem zaokraglen. Wartosci NaN sa pomijane przy minimum i maksimum
+  * (tak jak w FieldStats::add).
+  */
+class SimdKernels {
+public:
+    /** @brief Liczba niezaleznych akumulatorow (szerokosc rejestru AVX2 w liczbach double). */
+    static constexpr int LANES = 4;
+
+    /**
+     * @brief Zestaw instrukcji uzywany przez petle.
+     */
+    enum class Level {
+        SCALAR, /**< Zwykly kod C++ (dowolny procesor). */
+        SSE2,   /**< Rejestry 128-bitowe (kazdy procesor x86-64). */
+        AVX2    /**< Rejestry 256-bitowe. */
+    };
+
+    /**
+     * @brief Zwraca najlepszy zestaw instrukcji obslugiwany przez procesor.
+     * @return Level Wykryty poziom.
+     */
+    static Level detect();
+
+    /**
+     * @brief Zwraca aktualnie uzywany zestaw instrukcji.
+     * @return Level Biezacy poziom (domyslnie detect()).
+     */
+    static Level level();
+
+    /**
+     * @brief Wymusza zestaw instrukcji (np. w testach lub pomiarach wydajnosci).
+     *
+     * Poziom wyzszy niz obslugiwany przez procesor jest obnizany do detect().
+     *
+     * @param l Zadany poziom.
+     * @return Level Poziom faktycznie ustawiony.
+     */
+    static Level setLevel(Level l);
+
+    /**
+     * @brief Dolacza do statystyk wszystkie wartosci kolumny.
+     *
+     * @param values Poczatek kolumny.
+     * @param n Liczba wartosci.
+     * @param out Statystyki, do ktorych dolaczany jest wynik (suma, minimum, maksimum).
+     */
+    static void stats(const double* values, std::size_t n, FieldStats& out);
+
+    /**
+     * @brief Dolacza do statystyk wartosci wskazane maska bitowa.
+     *
+     * Przeznaczona dla slotow liscia QuarterNode: bit i maski oznacza,
+     * ze values[i] nalezy uwzglednic.
+     *
+     * @param values Poczatek kolumny (co najmniej n wartosci).
+     * @param n Dlugosc kolumny (najwyzej 32).
+     * @param mask Maska wybranych pozycji (bity >= n sa ignorowane).
+     * @param out Statystyki, do ktorych dolaczany jest wynik.
+     */
+    static void maskedStats(const double* values, int n, std::uint32_t mask, FieldStats& out);
+
+    /**
+     * @brief Wybiera pozycje maski, na ktorych wartosc miesci sie w przedziale [lo, hi].
+     *
+     * @param values Poczatek kolumny (co najmniej n wartosci).
+     * @param n Dlugosc kolumny (najwyzej 32).
+     * @param mask Maska sprawdzanych pozycji.
+     * @param lo Dolna granica (wlacznie).
+     * @param hi Gorna granica (wlacznie).
+     * @return std::uint32_t Maska pozycji spelniajacych warunek (podzbior mask).
+     */
+    static std::uint32_t maskedMatch(const double* values, int n, std::uint32_t mask, double lo, double hi);
+
+    /**
+     * @brief Dopisuje indeksy wartosci kolumny mieszczacych sie w przedziale [lo, hi].
+     *
+     * @param values Poczatek kolumny.
+     * @param n Liczba wartosci.
+     * @param lo Dolna granica (wlacznie).
+     * @param hi Gorna granica (wlacznie).
+     * @param out Wektor, na koniec ktorego dopisywane sa indeksy (rosnaco).
+     */
+    static void match(const double* values, std::size_t n, double lo, double hi, std::vector<std::size_t>& out);
+};
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file SnapshotTree.cpp
+ * @brief Implementacja migawek i publikacji drzewa (przelaczanie dwoch replik).
+ */
+
+#include "SnapshotTree.h"
+
+/**
+ * @brief Zwraca migawke opublikowanej repliki.
+ *
+ * Licznik migawek jest zwiekszany pod tym samym mutexem, pod ktorym
+ * publish() przelacza indeks front - po przelaczeniu zadna nowa migawka
+ * nie trafi juz do poprzedniej repliki. Zwolnienie migawki zmniejsza
+ * licznik z semantyka release, co w parze z odczytem acquire w publish()
+ * gwarantuje, ze odczyty czytelnika koncza sie przed zapisami pisarza.
+ *
+ * @return std::shared_ptr<const EnergyTree> Drzewo opublikowanej repliki.
+ */
+std::shared_ptr<const EnergyTree> SnapshotTree::snapshot() const {
+    const Replica* replica;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        replica = &replicas[front];
+        replica->readers.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::shared_ptr<const EnergyTree>(&replica->tree, [replica](const EnergyTree*) {
+        replica->readers.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+/**
+ * @brief Wstawia kolejke do nieopublikowanej repliki i publikuje ja.
+ *
+ * Replika jest wolna, gdy nie ma zadnej migawki. Najpierw nadrabia pomiary
+ * poprzedniej publikacji (behind), a potem dostaje kolejke; oba kroki ida
+ * przez bulkLoad, ktory dla danych dopisywanych na koncu buduje wezly bez
+ * wyszukiwania w mapach.
+ *
+ * @return bool True, jesli dane zostaly opublikowane.
+ */
+bool SnapshotTree::publish() {
+    if (queued.empty()) return true;
+    int back = 1 - front;
+    if (replicas[back].readers.load(std::memory_order_acquire) > 0) return false;
+
+    EnergyTree& tree = replicas[back].tree;
+    tree.bulkLoad(behind);
+    tree.bulkLoad(queued);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        front = back;
+    }
+
+    // Poprzednio opublikowana replika nie ma jeszcze pomiarow z kolejki
+    behind.swap(queued);
+    queued.clear();
+    return true;
+}
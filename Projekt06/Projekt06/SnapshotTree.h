@@ -0,0 +1,110 @@
+/**
+ * @file SnapshotTree.h
+ * @brief Definicja drzewa z niezmiennymi migawkami dla odczytow rownoleglych z wczytywaniem.
+ *
+ * Plik naglowkowy zawierajacy klase SnapshotTree, ktora pozwala jednemu
+ * watkowi dopisywac pomiary, podczas gdy inne watki wykonuja zapytania
+ * (Analyzer) na spojnych, niezmiennych migawkach danych - bez blokad
+ * po stronie czytelnikow.
+ */
+
+#ifndef SNAPSHOTTREE_H
+#define SNAPSHOTTREE_H
+
+#include "EnergyTree.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+ /**
+  * @class SnapshotTree
+  * @brief Dwie repliki EnergyTree przelaczane przy publikacji (schemat left-right).
+  *
+  * Czytelnik pobiera migawke (snapshot) - wskaznik do repliki opublikowanej
+  * w danej chwili - i moze na niej wykonywac dowolne zapytania tylko do
+  * odczytu (np. Analyzer). Kazda replika ma licznik otwartych migawek;
+  * replika nie zmienia sie, dopoki licznik jest niezerowy, wiec iteratory
+  * i wyniki pozostaja spojne. Pobranie migawki to odczyt indeksu repliki
+  * i zwiekszenie licznika pod mutexem, ktory pisarz trzyma tylko na czas
+  * przelaczenia indeksu (nigdy podczas wstawiania) - zapytania nie czekaja
+  * na wczytywanie, a ich czas nie zalezy od jego tempa.
+  *
+  * Pisarz dodaje pomiary do kolejki (add), a publish() wstawia je do drugiej,
+  * nieopublikowanej repliki (razem z pomiarami poprzedniej publikacji, ktorych
+  * ta replika jeszcze nie ma) i przelacza na nia czytelnikow. Jesli druga replika jest
+  * jeszcze czytana przez starsze migawki, publish() nie czeka - pomiary
+  * zostaja w kolejce do kolejnego wywolania. Kazdy pomiar jest wiec wstawiany
+  * dwa razy (raz do kazdej repliki), a pamiec drzewa jest podwojona.
+  * Liczniki Metrics obejmuja wstawienia do obu replik.
+  *
+  * Pisac (add, publish) moze tylko jeden watek naraz; snapshot() moze byc
+  * wywolywany z dowolnej liczby watkow. Migawki nalezy zwalniac po
+  * zakonczeniu zapytania - migawka trzymana bez konca wstrzymuje publikacje -
+  * i nie moga one przezyc obiektu SnapshotTree.
+  */
+class SnapshotTree {
+    /**
+     * @struct Replica
+     * @brief Kopia drzewa z licznikiem otwartych migawek.
+     */
+    struct Replica {
+        EnergyTree tree;                            /**< Dane repliki. */
+        mutable std::atomic<int> readers{ 0 };      /**< Liczba istniejacych migawek tej repliki. */
+    };
+
+    Replica replicas[2];                            /**< Repliki drzewa. */
+    mutable std::mutex mtx;                         /**< Ochrona indeksu front przy pobieraniu migawki. */
+    int front = 0;                                  /**< Indeks opublikowanej repliki. */
+    std::vector<Measurement> behind;                /**< Pomiary opublikowane, ktorych nie ma jeszcze druga replika. */
+    std::vector<Measurement> queued;                /**< Pomiary dodane, jeszcze nieopublikowane. */
+
+public:
+    /**
+     * @brief Tworzy dwie puste repliki; czytelnicy od poczatku widza pierwsza.
+     */
+    SnapshotTree() = default;
+
+    SnapshotTree(const SnapshotTree&) = delete;
+    SnapshotTree& operator=(const SnapshotTree&) = delete;
+
+    /**
+     * @brief Zwraca migawke ostatnio opublikowanych danych.
+     *
+     * Bezpieczne dla wielu watkow i rownolegle z add/publish. Zniszczenie
+     * ostatniej kopii zwroconego wskaznika zwalnia migawke.
+     *
+     * @return std::shared_ptr<const EnergyTree> Niezmienne drzewo (do zwolnienia po zapytaniu).
+     */
+    std::shared_ptr<const EnergyTree> snapshot() const;
+
+    /**
+     * @brief Dodaje pomiar do kolejki (widoczny w migawkach po publish()).
+     * @param m Dodawany pomiar.
+     */
+    void add(const Measurement& m) { queued.push_back(m); }
+
+    /**
+     * @brief Dodaje paczke pomiarow do kolejki (najlepiej posortowana rosnaco wg czasu).
+     * @param batch Dodawane pomiary.
+     */
+    void add(const std::vector<Measurement>& batch) { queued.insert(queued.end(), batch.begin(), batch.end()); }
+
+    /**
+     * @brief Publikuje pomiary z kolejki, jesli nieopublikowana replika nie jest czytana.
+     *
+     * Nigdy nie czeka na czytelnikow.
+     *
+     * @return bool True, jesli kolejka zostala opublikowana (lub byla pusta); false, gdy
+     * druga replika ma jeszcze migawki - pomiary pozostaja w kolejce.
+     */
+    bool publish();
+
+    /**
+     * @brief Zwraca liczbe pomiarow czekajacych na publikacje.
+     * @return std::size_t Rozmiar kolejki.
+     */
+    std::size_t pending() const { return queued.size(); }
+};
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Implementacja puli watkow roboczych.
+ *
+ * Plik zawiera tworzenie i zamykanie watkow oraz petle pobierajaca zadania
+ * ze wspolnej kolejki.
+ */
+
+#include "ThreadPool.h"
+
+/**
+ * @brief Tworzy pule i uruchamia watki robocze.
+ *
+ * @param threads Liczba watkow; 0 oznacza liczbe rdzeni (co najmniej 1).
+ */
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) workers.emplace_back([this]() { workerLoop(); });
+}
+
+/**
+ * @brief Zamyka pule po wykonaniu wszystkich oczekujacych zadan.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+/**
+ * @brief Petla watku roboczego.
+ *
+ * Czeka na zadanie w kolejce i wykonuje je poza sekcja krytyczna.
+ * Konczy sie, gdy pula jest zamykana, a kolejka jest pusta.
+ */
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * @file ThreadPool.h
+ * @brief Definicja prostej puli watkow roboczych.
+ *
+ * Plik naglowkowy zawierajacy klase ThreadPool, ktora utrzymuje stala liczbe
+ * watkow i wykonuje na nich zlecone zadania. Wyniki zadan sa zwracane przez
+ * std::future, dzieki czemu wywolujacy moze odbierac je w wybranej kolejnosci.
+ * Funkcja forEachPartition rozdziela na watki puli petle po indeksach.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+ /**
+  * @class ThreadPool
+  * @brief Pula watkow z jedna wspolna kolejka zadan (FIFO).
+  *
+  * Watki sa tworzone w konstruktorze i czekaja na zadania. Destruktor konczy
+  * prace puli dopiero po wykonaniu wszystkich zleconych zadan.
+  */
+class ThreadPool {
+    std::vector<std::thread> workers;           /**< Watki robocze. */
+    std::deque<std::function<void()>> tasks;    /**< Kolejka oczekujacych zadan. */
+    std::mutex mtx;                             /**< Ochrona kolejki zadan. */
+    std::condition_variable cv;                 /**< Powiadamianie watkow o nowych zadaniach. */
+    bool stopping = false;                      /**< Flaga zamykania puli. */
+
+    /**
+     * @brief Petla watku roboczego - pobiera i wykonuje zadania az do zamkniecia puli.
+     */
+    void workerLoop();
+
+public:
+    /**
+     * @brief Tworzy pule watkow.
+     * @param threads Liczba watkow; 0 oznacza liczbe rdzeni (std::thread::hardware_concurrency).
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Czeka na wykonanie wszystkich zadan i konczy watki.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Zwraca liczbe watkow puli.
+     * @return unsigned Liczba watkow.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    /**
+     * @brief Zleca wykonanie zadania.
+     *
+     * @param f Funkcja bez argumentow do wykonania na jednym z watkow.
+     * @return std::future Wynik zadania (lub wyjatek, ktory zadanie zglosilo).
+     */
+    template <typename F>
+    auto submit(F&& f) -> std::future<decltype(f())> {
+        using Result = decltype(f());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.emplace_back([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+};
+
+/**
+ * @brief Wywoluje fn(i) dla i = 0..n-1, opcjonalnie na watkach puli.
+ *
+ * Wywolujacy watek i pomocnicze zadania puli pobieraja kolejne indeksy
+ * ze wspolnego licznika, wiec watek, ktory skonczy wczesniej, od razu
+ * bierze nastepny indeks (rownowazenie obciazenia bez podzialu z gory).
+ * Wyniki zapisywane przez fn pod indeksem i nie zaleza od tego, ktory
+ * watek je policzyl. Bez puli (lub dla jednego indeksu) wywolania sa
+ * wykonywane po kolei na watku wywolujacym. Funkcja wraca po przetworzeniu
+ * wszystkich indeksow; wyjatek z fn jest przekazywany dalej.
+ *
+ * @param n Liczba indeksow.
+ * @param pool Pula watkow lub nullptr (nie moze to byc pula, na ktorej wykonuje sie wywolanie).
+ * @param fn Funkcja wywolywana z indeksem.
+ */
+template <typename Fn>
+void forEachPartition(std::size_t n, ThreadPool* pool, Fn fn) {
+    if (!pool || n < 2) {
+        for (std::size_t i = 0; i < n; i++) fn(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next{ 0 };
+    auto worker = [&]() {
+        for (std::size_t i; (i = next.fetch_add(1)) < n;) fn(i);
+    };
+    std::vector<std::future<void>> helpers;
+    std::size_t extra = std::min<std::size_t>(pool->size(), n - 1);
+    for (std::size_t k = 0; k < extra; k++) helpers.push_back(pool->submit(worker));
+
+    std::exception_ptr error;
+    try { worker(); }
+    catch (...) { error = std::current_exception(); next = n; }
+    for (auto& h : helpers) h.wait();
+    for (auto& h : helpers) {
+        try { h.get(); }
+        catch (...) { if (!error) error = std::current_exception(); }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * @file TimeSeriesCodec.cpp
+ * @brief Implementacja strumienia bitow oraz kodowania blokow pomiarow.
+ *
+ * Plik zawiera zapis i odczyt bitow z buforowaniem w slowie 64-bitowym,
+ * kodowanie czasow metoda delta-of-delta oraz kodowanie wartosci double
+ * przez XOR z poprzednia wartoscia kolumny.
+ */
+
+#include "TimeSeriesCodec.h"
+#include <bit>
+#include <cstring>
+
+/**
+ * @brief Zapisuje n najmlodszych bitow wartosci.
+ *
+ * Wartosci dluzsze niz 32 bity sa dzielone na dwie czesci, dzieki czemu
+ * bufor (co najwyzej 7 oczekujacych bitow + 32 nowe) zawsze miesci sie
+ * w slowie 64-bitowym.
+ *
+ * @param bits Wartosc.
+ * @param n Liczba bitow (0-64).
+ */
+void BitWriter::write(std::uint64_t bits, int n) {
+    if (n > 32) {
+        write(bits >> 32, n - 32);
+        write(bits & 0xFFFFFFFFULL, 32);
+        return;
+    }
+    if (n == 0) return;
+    acc = (acc << n) | (bits & ((1ULL << n) - 1));
+    pending += n;
+    while (pending >= 8) {
+        pending -= 8;
+        out.push_back(static_cast<std::uint8_t>(acc >> pending));
+    }
+}
+
+/**
+ * @brief Zapisuje pozostale bity, dopelniajac ostatni bajt zerami.
+ */
+void BitWriter::flush() {
+    if (pending > 0) out.push_back(static_cast<std::uint8_t>(acc << (8 - pending)));
+    pending = 0;
+    acc = 0;
+}
+
+namespace {
+    /**
+     * @brief Zwraca reprezentacje bitowa liczby double.
+     */
+    std::uint64_t toBits(double v) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+
+    /**
+     * @brief Zwraca liczbe double o podanej reprezentacji bitowej.
+     */
+    double fromBits(std::uint64_t bits) {
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    /**
+     * @brief Zakresy roznicy roznic czasu: prefiks, liczba bitow prefiksu i wartosci.
+     *
+     * Wartosc zapisywana jest z przesunieciem (dod + bias), aby byla nieujemna.
+     * Roznice spoza ostatniego zakresu zapisywane sa w calosci (64 bity).
+     */
+    struct DodBucket {
+        std::uint64_t prefix;
+        int prefixBits;
+        int valueBits;
+        std::int64_t bias;
+    };
+
+    constexpr DodBucket DOD_BUCKETS[] = {
+        { 0b10, 2, 7, 63 },
+        { 0b110, 3, 9, 255 },
+        { 0b1110, 4, 12, 2047 },
+    };
+}
+
+/**
+ * @brief Koduje blok pomiarow.
+ *
+ * Najpierw zapisywane sa wszystkie czasy, a nastepnie kolejno kolumny
+ * wartosci w kolejnosci DataType. Strumien konczy sie na granicy bajtu.
+ *
+ * @param times Czasy pomiarow.
+ * @param values Kolumny wartosci.
+ * @param count Liczba pomiarow.
+ * @param out Bufor wyjsciowy.
+ */
+void TimeSeriesCodec::encode(const std::int64_t* times, const double* const* values, std::size_t count, std::vector<std::uint8_t>& out) {
+    if (count == 0) return;
+    BitWriter w(out);
+
+    // Czasy: delta-of-delta (arytmetyka bez znaku - przepelnienie jest zdefiniowane)
+    w.write(static_cast<std::uint64_t>(times[0]), 64);
+    std::uint64_t prevDelta = 0;
+    for (std::size_t i = 1; i < count; i++) {
+        std::uint64_t delta = static_cast<std::uint64_t>(times[i]) - static_cast<std::uint64_t>(times[i - 1]);
+        std::int64_t dod = static_cast<std::int64_t>(delta - prevDelta);
+        prevDelta = delta;
+        if (dod == 0) { w.write(0, 1); continue; }
+
+        bool written = false;
+        for (const DodBucket& b : DOD_BUCKETS) {
+            std::int64_t limit = b.bias + 1;
+            if (dod >= -b.bias && dod <= limit) {
+                w.write(b.prefix, b.prefixBits);
+                w.write(static_cast<std::uint64_t>(dod + b.bias), b.valueBits);
+                written = true;
+                break;
+            }
+        }
+        if (!written) {
+            w.write(0b1111, 4);
+            w.write(static_cast<std::uint64_t>(dod), 64);
+        }
+    }
+
+    // Wartosci: XOR z poprzednia wartoscia kolumny
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        const double* col = values[f];
+        std::uint64_t prev = toBits(col[0]);
+        w.write(prev, 64);
+        int prevLead = -1, prevTrail = 0; // -1: brak okna bitow znaczacych
+        for (std::size_t i = 1; i < count; i++) {
+            std::uint64_t bits = toBits(col[i]);
+            std::uint64_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0) { w.write(0, 1); continue; }
+
+            int lead = std::countl_zero(x);
+            int trail = std::countr_zero(x);
+            if (lead > 31) lead = 31; // 5 bitow na liczbe zer wiodacych
+            if (prevLead >= 0 && lead >= prevLead && trail >= prevTrail) {
+                // Bity znaczace mieszcza sie w poprzednim oknie
+                w.write(0b10, 2);
+                w.write(x >> prevTrail, 64 - prevLead - prevTrail);
+            }
+            else {
+                int significant = 64 - lead - trail;
+                w.write(0b11, 2);
+                w.write(static_cast<std::uint64_t>(lead), 5);
+                w.write(static_cast<std::uint64_t>(significant - 1), 6);
+                w.write(x >> trail, significant);
+                prevLead = lead;
+                prevTrail = trail;
+            }
+        }
+    }
+    w.flush();
+}
+
+/**
+ * @brief Dekoduje blok pomiarow zapisany przez encode.
+ *
+ * @param data Zakodowane dane.
+ * @param size Rozmiar danych w bajtach.
+ * @param count Liczba pomiarow.
+ * @param times Tablica wynikowa czasow.
+ * @param values Tablice wynikowe kolumn.
+ * @return bool False dla danych uszkodzonych.
+ */
+bool TimeSeriesCodec::decode(const std::uint8_t* data, std::size_t size, std::size_t count, std::int64_t* times, double* const* values) {
+    if (count == 0) return true;
+    BitReader r(data, size);
+
+    std::uint64_t t = r.read(64);
+    times[0] = static_cast<std::int64_t>(t);
+    std::uint64_t delta = 0;
+    for (std::size_t i = 1; i < count; i++) {
+        std::int64_t dod = 0;
+        if (r.readBit()) {
+            int bucket = 0;
+            while (bucket < 3 && r.readBit()) bucket++;
+            if (bucket < 3) {
+                const DodBucket& b = DOD_BUCKETS[bucket];
+                dod = static_cast<std::int64_t>(r.read(b.valueBits)) - b.bias;
+            }
+            else dod = static_cast<std::int64_t>(r.read(64));
+        }
+        delta += static_cast<std::uint64_t>(dod);
+        t += delta;
+        times[i] = static_cast<std::int64_t>(t);
+    }
+
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        double* col = values[f];
+        std::uint64_t prev = r.read(64);
+        col[0] = fromBits(prev);
+        int prevLead = 0, prevTrail = 0;
+        for (std::size_t i = 1; i < count; i++) {
+            if (r.readBit()) {
+                if (r.readBit()) {
+                    prevLead = static_cast<int>(r.read(5));
+                    int significant = static_cast<int>(r.read(6)) + 1;
+                    prevTrail = 64 - prevLead - significant;
+                    if (prevTrail < 0) return false;
+                }
+                prev ^= r.read(64 - prevLead - prevTrail) << prevTrail;
+            }
+            col[i] = fromBits(prev);
+        }
+        if (r.overrun()) return false;
+    }
+    return !r.overrun();
+}
@@ -0,0 +1,152 @@
+/**
+ * @file TimeSeriesCodec.h
+ * @brief Definicja kodeka kompresji szeregow czasowych (w stylu Gorilla).
+ *
+ * Plik naglowkowy zawierajacy klasy BitWriter i BitReader (zapis i odczyt
+ * strumienia bitow) oraz klase TimeSeriesCodec, ktora koduje blok pomiarow:
+ * czasy metoda delta-of-delta, a wartosci double przez XOR z poprzednia
+ * wartoscia. Kazdy blok jest kodowany niezaleznie od pozostalych.
+ */
+
+#ifndef TIMESERIESCODEC_H
+#define TIMESERIESCODEC_H
+
+#include "Measurement.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+ /**
+  * @class BitWriter
+  * @brief Zapis strumienia bitow (od najstarszego bitu) do bufora bajtow.
+  */
+class BitWriter {
+    std::vector<std::uint8_t>& out; /**< Bufor wyjsciowy. */
+    std::uint64_t acc = 0;          /**< Bity oczekujace na zapis. */
+    int pending = 0;                /**< Liczba bitow w acc. */
+
+public:
+    /**
+     * @brief Tworzy zapis dopisujacy bajty na koniec bufora.
+     * @param buffer Bufor wyjsciowy.
+     */
+    explicit BitWriter(std::vector<std::uint8_t>& buffer) : out(buffer) {}
+
+    /**
+     * @brief Zapisuje n najmlodszych bitow wartosci.
+     * @param bits Wartosc.
+     * @param n Liczba bitow (0-64).
+     */
+    void write(std::uint64_t bits, int n);
+
+    /**
+     * @brief Zapisuje pozostale bity, dopelniajac ostatni bajt zerami.
+     */
+    void flush();
+};
+
+ /**
+  * @class BitReader
+  * @brief Odczyt strumienia bitow zapisanego przez BitWriter.
+  *
+  * Odczyt poza koncem bufora zwraca zera i ustawia flage overrun(), dzieki
+  * czemu uszkodzone dane nie powoduja wyjscia poza pamiec.
+  */
+class BitReader {
+    const std::uint8_t* data;   /**< Poczatek bufora. */
+    std::size_t size;           /**< Rozmiar bufora w bajtach. */
+    std::size_t pos = 0;        /**< Nastepny bajt do pobrania. */
+    std::uint64_t acc = 0;      /**< Pobrane bity; nieodczytane sa najmlodszymi 'available' bitami. */
+    int available = 0;          /**< Liczba bitow w acc. */
+    bool over = false;          /**< Czy nastapil odczyt poza koncem bufora. */
+
+public:
+    /**
+     * @brief Tworzy odczyt z bufora.
+     * @param bytes Poczatek bufora.
+     * @param length Rozmiar bufora w bajtach.
+     */
+    BitReader(const std::uint8_t* bytes, std::size_t length) : data(bytes), size(length) {}
+
+    /**
+     * @brief Odczytuje n bitow.
+     *
+     * Bufor jest uzupelniany cale bajty naraz, az do 56 bitow. Brakujace bity
+     * na koncu danych sa traktowane jako zera (z ustawieniem flagi overrun).
+     * Funkcja jest zdefiniowana w naglowku, poniewaz dekoder wywoluje ja
+     * dla kazdego pomiaru wielokrotnie.
+     *
+     * @param n Liczba bitow (0-64).
+     * @return std::uint64_t Odczytana wartosc (w najmlodszych bitach).
+     */
+    std::uint64_t read(int n) {
+        if (n > 32) {
+            std::uint64_t high = read(n - 32);
+            return (high << 32) | read(32);
+        }
+        if (n == 0) return 0;
+        if (available < n) {
+            while (available <= 56 && pos < size) {
+                acc = (acc << 8) | data[pos++];
+                available += 8;
+            }
+            if (available < n) {
+                over = true;
+                acc <<= (n - available);
+                available = n;
+            }
+        }
+        available -= n;
+        return (acc >> available) & ((1ULL << n) - 1);
+    }
+
+    /**
+     * @brief Odczytuje pojedynczy bit.
+     * @return bool Wartosc bitu.
+     */
+    bool readBit() { return read(1) != 0; }
+
+    /**
+     * @brief Sprawdza, czy nastapil odczyt poza koncem bufora.
+     * @return bool True dla uszkodzonego lub zbyt krotkiego strumienia.
+     */
+    bool overrun() const { return over; }
+};
+
+ /**
+  * @class TimeSeriesCodec
+  * @brief Klasa statyczna kodujaca bloki pomiarow (czasy i piec kolumn wartosci).
+  *
+  * Czasy: pierwszy zapisany w calosci, kolejne jako roznica roznic
+  * (delta-of-delta) o zmiennej dlugosci - dla regularnego kroku 15 minut
+  * kazdy pomiar zajmuje 1 bit. Wartosci: kazda kolumna osobno, pierwsza
+  * wartosc w calosci, kolejne jako XOR z poprzednia - wartosc niezmieniona
+  * zajmuje 1 bit, a zmieniona tylko bity znaczace XOR-a (bez zer na
+  * poczatku i koncu).
+  */
+class TimeSeriesCodec {
+public:
+    /**
+     * @brief Koduje blok pomiarow.
+     *
+     * @param times Czasy pomiarow (rosnaco).
+     * @param values Kolumny wartosci, indeks = (int)DataType.
+     * @param count Liczba pomiarow.
+     * @param out Bufor, na ktorego koniec dopisywane sa zakodowane dane.
+     */
+    static void encode(const std::int64_t* times, const double* const* values, std::size_t count, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Dekoduje blok pomiarow.
+     *
+     * @param data Zakodowane dane.
+     * @param size Rozmiar danych w bajtach.
+     * @param count Liczba pomiarow w bloku.
+     * @param times Tablica wynikowa czasow (count elementow).
+     * @param values Tablice wynikowe kolumn (count elementow kazda).
+     * @return bool False, jesli dane sa uszkodzone (za krotkie).
+     */
+    static bool decode(const std::uint8_t* data, std::size_t size, std::size_t count, std::int64_t* times, double* const* values);
+};
+
+#endif
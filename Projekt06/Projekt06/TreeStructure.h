@@ -4,91 +4,422 @@
  *
  * Plik ten definiuje bloki budulcowe dla klasy EnergyTree. Struktura danych
  * oparta jest na zagniezdzeonych mapach: Rok -> Miesiac -> Dzien -> Kwadrans.
- * Ostatni poziom (QuarterNode) przechowuje faktyczne dane w wektorze.
+ * Ostatni poziom (QuarterNode) przechowuje faktyczne dane w ukladzie
+ * kolumnowym: w stalej siatce 15-minutowych slotow oraz w posortowanej
+ * liscie nadmiarowej dla pomiarow spoza siatki.
+ * Kazdy wezel utrzymuje dodatkowo agregaty (NodeStats) wszystkich pomiarow
+ * lezacych w jego poddrzewie, co pozwala odpowiadac na zapytania zakresowe
+ * bez schodzenia do lisci calkowicie pokrytych przez zakres. Wezly miesiaca
+ * i roku maja ponadto szkice kwantyli (NodeSketches) wszystkich pol.
+ * Wezly potomne sa przechowywane w mapach bezposrednio (jako wartosci),
+ * a mapy i kolumny korzystaja z alokatora std::pmr - w EnergyTree cala
+ * pamiec drzewa pochodzi z jednej areny.
  */
 
 #ifndef TREESTRUCTURE_H
 #define TREESTRUCTURE_H
 
 #include <map>
+#include <memory_resource>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <limits>
+#include <bit>
+#include <cstdint>
 #include "Measurement.h"
+#include "QuantileSketch.h"
+
+ /**
+  * @struct FieldStats
+  * @brief Biezace statystyki jednego pola energetycznego (suma, minimum, maksimum).
+  *
+  * Liczba pomiarow jest wspolna dla wszystkich pol, dlatego przechowywana
+  * jest w NodeStats, a nie tutaj.
+  */
+struct FieldStats {
+    double sum = 0.0;                                       /**< Suma wartosci. */
+    double min = std::numeric_limits<double>::infinity();   /**< Najmniejsza wartosc. */
+    double max = -std::numeric_limits<double>::infinity();  /**< Najwieksza wartosc. */
+
+    /**
+     * @brief Uwzglednia pojedyncza wartosc w statystykach.
+     * @param v Dodawana wartosc.
+     */
+    void add(double v) {
+        sum += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    /**
+     * @brief Laczy statystyki z innym zbiorem (np. z wezla potomnego).
+     * @param other Statystyki do dolaczenia.
+     */
+    void merge(const FieldStats& other) {
+        sum += other.sum;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+};
+
+/**
+ * @struct NodeStats
+ * @brief Agregaty wszystkich pomiarow zawartych w poddrzewie wezla.
+ *
+ * Przechowuje liczbe pomiarow, zakres czasu [first, last] oraz statystyki
+ * dla kazdego z pieciu pol (indeksowane wartoscia DataType). Zakres czasu
+ * pozwala stwierdzic, czy wezel jest w calosci pokryty przez zapytanie,
+ * czy tez trzeba zejsc nizej.
+ */
+struct NodeStats {
+    std::size_t count = 0;          /**< Liczba pomiarow w poddrzewie. */
+    time_t first = 0;               /**< Czas najwczesniejszego pomiaru. */
+    time_t last = 0;                /**< Czas najpozniejszego pomiaru. */
+    FieldStats fields[FIELD_COUNT]; /**< Statystyki pol, indeks = (int)DataType. */
+
+    /**
+     * @brief Uwzglednia pojedynczy pomiar w agregatach.
+     *
+     * @param m Dodawany pomiar.
+     * @param t Czas pomiaru w formacie liniowym (wyliczony raz przez wywolujacego).
+     */
+    void add(const Measurement& m, time_t t) {
+        addTime(t);
+        fields[static_cast<int>(DataType::AUTO)].add(m.autoconsumption);
+        fields[static_cast<int>(DataType::EXPORT)].add(m.exportEnergy);
+        fields[static_cast<int>(DataType::IMPORT)].add(m.importEnergy);
+        fields[static_cast<int>(DataType::CONS)].add(m.consumption);
+        fields[static_cast<int>(DataType::PROD)].add(m.production);
+    }
+
+    /**
+     * @brief Uwzglednia czas kolejnego pomiaru (licznik i zakres czasu).
+     *
+     * Wartosci pol wywolujacy dodaje osobno przez fields[i].add - pozwala to
+     * agregowac dane bezposrednio z kolumn liscia bez budowania Measurement.
+     *
+     * @param t Czas pomiaru.
+     */
+    void addTime(time_t t) {
+        if (count == 0 || t < first) first = t;
+        if (count == 0 || t > last) last = t;
+        count++;
+    }
+
+    /**
+     * @brief Uwzglednia czasy grupy n pomiarow z przedzialu [lo, hi].
+     *
+     * Odpowiednik n wywolan addTime dla pomiarow, z ktorych najwczesniejszy
+     * ma czas lo, a najpozniejszy hi (np. zajete sloty jednego bloku).
+     *
+     * @param lo Czas najwczesniejszego pomiaru grupy.
+     * @param hi Czas najpozniejszego pomiaru grupy.
+     * @param n Liczba pomiarow (n > 0).
+     */
+    void addTimes(time_t lo, time_t hi, std::size_t n) {
+        if (count == 0 || lo < first) first = lo;
+        if (count == 0 || hi > last) last = hi;
+        count += n;
+    }
+
+    /**
+     * @brief Laczy agregaty z innym wezlem.
+     * @param other Agregaty do dolaczenia.
+     */
+    void merge(const NodeStats& other) {
+        if (other.count == 0) return;
+        if (count == 0 || other.first < first) first = other.first;
+        if (count == 0 || other.last > last) last = other.last;
+        count += other.count;
+        for (int i = 0; i < FIELD_COUNT; i++) fields[i].merge(other.fields[i]);
+    }
+
+    /**
+     * @brief Zwraca statystyki wskazanego pola.
+     *
+     * Dla wartosci spoza DataType (np. rzutowanej z liczby podanej przez
+     * uzytkownika) zwracane sa puste statystyki - suma 0, jak w selektorze
+     * Analyzer::getSelector dla nieznanego typu.
+     *
+     * @param type Typ danych.
+     * @return const FieldStats& Statystyki pola.
+     */
+    const FieldStats& field(DataType type) const {
+        static const FieldStats empty;
+        int i = static_cast<int>(type);
+        return i >= 0 && i < FIELD_COUNT ? fields[i] : empty;
+    }
+};
 
  /**
   * @struct QuarterNode
   * @brief Wezel liscia w strukturze drzewa (najniszy poziom podziau czasu).
   *
   * Reprezentuje blok czasowy (w logice EnergyTree.cpp jest to cwiartka doby,
-  * czyli blok 6-godzinny), ktory przechowuje liste pomiarow.
-  * Odpowiada za utrzymanie posortowanej kolejnosci pomiarow oraz zapobieganie duplikatom.
+  * czyli blok 6-godzinny). Licznik zapisuje pomiary w stalej siatce co 15 minut,
+  * wiec blok ma dokladnie SLOT_COUNT miejsc (slotow): wartosci pomiaru z siatki
+  * trafiaja wprost do slotu o indeksie (czas - poczatek bloku) / 15 min, a jego
+  * zajetosc jest zaznaczana w masce bitowej. Wstawianie i wykrywanie duplikatow
+  * to wtedy O(1), a czas pomiaru nie musi byc w ogole przechowywany.
+  * Pomiary spoza siatki (np. z sekundami) trafiaja do posortowanej listy
+  * nadmiarowej w ukladzie kolumnowym (osobna tablica czasow i kazdego pola).
+  * Iteracja laczy oba zrodla w porzadku chronologicznym.
   */
 struct QuarterNode {
+    static constexpr int BLOCK_SECONDS = 6 * 3600;                    /**< Dlugosc bloku w sekundach. */
+    static constexpr int SLOT_SECONDS = 15 * 60;                      /**< Odstep siatki pomiarow w sekundach. */
+    static constexpr int SLOT_COUNT = BLOCK_SECONDS / SLOT_SECONDS;   /**< Liczba slotow w bloku (24). */
+
     /**
-     * @brief Wektor przechowywujacy unikalne wskazniki do pomiarow.
-     * Uzycie std::unique_ptr zapewnia automatyczne zarzadzanie pamiecia.
+     * @struct Position
+     * @brief Pozycja pomiaru w lisciu (kursor po slotach i liscie nadmiarowej).
      */
-    std::vector<std::unique_ptr<Measurement>> measurements;
+    struct Position {
+        int slot = SLOT_COUNT;  /**< Najblizszy zajety slot (SLOT_COUNT = brak). */
+        std::size_t off = 0;    /**< Indeks w liscie nadmiarowej. */
+    };
+
+    /** @brief Poczatek bloku w sekundach od epoki (wielokrotnosc BLOCK_SECONDS). */
+    time_t base = 0;
+
+    /** @brief Maska zajetosci slotow - bit i oznacza pomiar o czasie base + i * SLOT_SECONDS. */
+    std::uint32_t occupied = 0;
+
+    /** @brief Wartosci pomiarow z siatki, indeks = [(int)DataType][slot]. */
+    double slots[FIELD_COUNT][SLOT_COUNT] = {};
+
+    /** @brief Posortowane rosnaco czasy pomiarow spoza siatki. */
+    std::pmr::vector<time_t> times;
+
+    /** @brief Kolumny wartosci pomiarow spoza siatki, indeks tablicy = (int)DataType. */
+    std::pmr::vector<double> values[FIELD_COUNT];
+
+    /** @brief Agregaty pomiarow w tym bloku. */
+    NodeStats stats;
+
+    /** @brief Alokator kolumn nadmiarowych (konstrukcja z alokatorem przez std::pmr::map). */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
 
     /**
-     * @brief Dodaje nowy pomiar do wektora.
+     * @brief Konstruktor bloku.
+     * @param blockStart Poczatek bloku w sekundach od epoki.
+     * @param alloc Alokator kolumn nadmiarowych (domyslnie std::pmr::get_default_resource()).
+     */
+    explicit QuarterNode(time_t blockStart, const allocator_type& alloc = {})
+        : base(blockStart), times(alloc), values{ std::pmr::vector<double>(alloc), std::pmr::vector<double>(alloc),
+            std::pmr::vector<double>(alloc), std::pmr::vector<double>(alloc), std::pmr::vector<double>(alloc) } {
+        static_assert(FIELD_COUNT == 5, "Lista inicjalizacji values musi miec FIELD_COUNT elementow");
+    }
+
+    /**
+     * @brief Zwraca poczatek bloku zawierajacego wskazany czas.
+     * @param t Czas w sekundach od epoki.
+     * @return time_t Poczatek bloku.
+     */
+    static time_t blockStart(time_t t) {
+        time_t b = t / BLOCK_SECONDS * BLOCK_SECONDS;
+        return b > t ? b - BLOCK_SECONDS : b;
+    }
+
+    /**
+     * @brief Zwraca liczbe pomiarow w bloku.
+     * @return std::size_t Liczba pomiarow.
+     */
+    std::size_t size() const { return std::popcount(occupied) + times.size(); }
+
+    /**
+     * @brief Zwraca czas slotu o podanym indeksie.
+     * @param slot Indeks slotu.
+     * @return time_t Czas w sekundach od epoki.
+     */
+    time_t slotTime(int slot) const { return base + static_cast<time_t>(slot) * SLOT_SECONDS; }
+
+    /**
+     * @brief Zwraca indeks pierwszego zajetego slotu nie mniejszego niz from.
+     * @param from Indeks poczatkowy.
+     * @return int Indeks slotu lub SLOT_COUNT, jesli nie ma zajetych slotow.
+     */
+    int nextSlot(int from) const {
+        if (from >= SLOT_COUNT) return SLOT_COUNT;
+        std::uint32_t rest = occupied & (~0u << from);
+        return rest ? std::countr_zero(rest) : SLOT_COUNT;
+    }
+
+    /** @brief Zwraca pozycje pierwszego (najwczesniejszego) pomiaru w bloku. */
+    Position first() const { return Position{ nextSlot(0), 0 }; }
+
+    /** @brief Sprawdza, czy pozycja wskazuje na pomiar (a nie za koniec bloku). */
+    bool valid(const Position& p) const { return p.slot < SLOT_COUNT || p.off < times.size(); }
+
+    /** @brief Sprawdza, czy pomiar na pozycji pochodzi ze slotu siatki (a nie z listy nadmiarowej). */
+    bool onGrid(const Position& p) const {
+        return p.slot < SLOT_COUNT && (p.off >= times.size() || slotTime(p.slot) < times[p.off]);
+    }
+
+    /** @brief Przesuwa pozycje na nastepny pomiar w porzadku chronologicznym. */
+    void next(Position& p) const {
+        if (onGrid(p)) p.slot = nextSlot(p.slot + 1);
+        else p.off++;
+    }
+
+    /** @brief Zwraca czas pomiaru na pozycji. */
+    time_t time(const Position& p) const { return onGrid(p) ? slotTime(p.slot) : times[p.off]; }
+
+    /**
+     * @brief Zwraca wartosc wskazanego pola dla pomiaru na pozycji.
+     * @param p Pozycja pomiaru w bloku.
+     * @param type Typ danych.
+     * @return double Wartosc pola.
+     */
+    double value(const Position& p, DataType type) const {
+        int f = static_cast<int>(type);
+        return onGrid(p) ? slots[f][p.slot] : values[f][p.off];
+    }
+
+    /**
+     * @brief Odtwarza pelny obiekt Measurement dla pomiaru na pozycji.
+     * @param p Pozycja pomiaru w bloku.
+     * @return Measurement Kopia pomiaru (z data wyliczona z czasu liniowego).
+     */
+    Measurement at(const Position& p) const {
+        Measurement m;
+        m.setEpoch(time(p));
+        m.autoconsumption = value(p, DataType::AUTO);
+        m.exportEnergy = value(p, DataType::EXPORT);
+        m.importEnergy = value(p, DataType::IMPORT);
+        m.consumption = value(p, DataType::CONS);
+        m.production = value(p, DataType::PROD);
+        return m;
+    }
+
+    /**
+     * @brief Dodaje nowy pomiar do bloku.
      *
-     * Metoda wykonuje trzy kroki:
-     * 1. Sprawdza, czy w wektorze istnieje juz pomiar o identycznym czasie (zapobieganie duplikatom).
-     * 2. Jesli nie ma duplikatu, dodaje nowy pomiar na koniec wektora.
-     * 3. Sortuje wektor chronologicznie, aby ulatwic pozniejsze przeszukiwanie i iteracje.
+     * Pomiar z siatki 15-minutowej trafia do swojego slotu - duplikat to po
+     * prostu ustawiony juz bit w masce zajetosci (O(1), bez sortowania).
+     * Pomiar spoza siatki jest wstawiany do posortowanej listy nadmiarowej
+     * (wyszukiwanie binarne pozycji i duplikatu).
      *
-     * @param m Unikalny wskaznik do nowego pomiaru (przejmuje wlasnosc).
+     * @param m Dodawany pomiar (wartosci sa kopiowane).
+     * @param t Czas pomiaru w sekundach od epoki (musi nalezec do bloku).
      * @return bool Zwraca true, jesli dodano pomiar. Zwraca false, jesli wykryto duplikat.
      */
-    bool add(std::unique_ptr<Measurement> m) {
-        // Sprawdzenie unikalnosci
-        for (const auto& existing : measurements) {
-            if (*existing == *m) return false; // Duplikat znaleziony
+    bool add(const Measurement& m, time_t t) {
+        // Kolejnosc zgodna z wartosciami DataType
+        const double row[FIELD_COUNT] = { m.autoconsumption, m.exportEnergy, m.importEnergy, m.consumption, m.production };
+
+        time_t offset = t - base;
+        if (offset % SLOT_SECONDS == 0) {
+            int slot = static_cast<int>(offset / SLOT_SECONDS);
+            std::uint32_t bit = 1u << slot;
+            if (occupied & bit) return false; // Duplikat znaleziony
+            occupied |= bit;
+            for (int f = 0; f < FIELD_COUNT; f++) slots[f][slot] = row[f];
+            return true;
         }
 
-        // Dodanie i sortowanie
-        measurements.push_back(std::move(m));
-        std::sort(measurements.begin(), measurements.end(),
-            [](const std::unique_ptr<Measurement>& a, const std::unique_ptr<Measurement>& b) {
-                return *a < *b;
-            });
+        auto pos = std::lower_bound(times.begin(), times.end(), t);
+        if (pos != times.end() && *pos == t) return false; // Duplikat znaleziony
+
+        auto i = pos - times.begin();
+        times.insert(pos, t);
+        for (int f = 0; f < FIELD_COUNT; f++) values[f].insert(values[f].begin() + i, row[f]);
         return true;
     }
 };
 
+/** @brief Mapa blokow dnia: numer bloku (0-3) -> wezel QuarterNode. */
+using QuarterMap = std::pmr::map<int, QuarterNode>;
+
 /**
  * @struct DayNode
  * @brief Wezel reprezentujacy jeden dzien.
  *
  * Przechowuje mape, gdzie kluczem jest numer kwadransa/bloku dnia (int),
- * a wartoscia unikalny wskaznik do wezla QuarterNode.
+ * a wartoscia wezel QuarterNode (w tym samym wezle mapy).
  */
 struct DayNode {
-    std::map<int, std::unique_ptr<QuarterNode>> quarters;
+    QuarterMap quarters;
+
+    /** @brief Agregaty wszystkich pomiarow w poddrzewie. */
+    NodeStats stats;
+
+    /** @brief Alokator przekazywany mapie i dalej wezlom potomnym. */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /**
+     * @brief Konstruktor pustego dnia.
+     * @param alloc Alokator mapy blokow.
+     */
+    explicit DayNode(const allocator_type& alloc = {}) : quarters(alloc) {}
 };
 
+/** @brief Mapa dni miesiaca: numer dnia -> wezel DayNode. */
+using DayMap = std::pmr::map<int, DayNode>;
+
 /**
  * @struct MonthNode
  * @brief Wezel reprezentujacy jeden miesiac.
  *
  * Przechowuje mape, gdzie kluczem jest numer dnia miesiaca (int),
- * a wartoscia unikalny wskaznik do wezla DayNode.
+ * a wartoscia wezel DayNode.
  */
 struct MonthNode {
-    std::map<int, std::unique_ptr<DayNode>> days;
+    DayMap days;
+
+    /** @brief Agregaty wszystkich pomiarow w poddrzewie. */
+    NodeStats stats;
+
+    /** @brief Szkice kwantyli pol wszystkich pomiarow w poddrzewie. */
+    NodeSketches sketches;
+
+    /** @brief Numer zapisu drzewa (EnergyTree::epoch), w ktorym ostatnio zmieniono poddrzewo. */
+    std::uint64_t epoch = 0;
+
+    /** @brief Alokator przekazywany mapie i dalej wezlom potomnym. */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /**
+     * @brief Konstruktor pustego miesiaca.
+     * @param alloc Alokator mapy dni i szkicow.
+     */
+    explicit MonthNode(const allocator_type& alloc = {}) : days(alloc), sketches(alloc) {}
 };
 
+/** @brief Mapa miesiecy roku: numer miesiaca (1-12) -> wezel MonthNode. */
+using MonthMap = std::pmr::map<int, MonthNode>;
+
 /**
  * @struct YearNode
  * @brief Wezel reprezentujacy jeden rok.
  *
  * Przechowuje mape, gdzie kluczem jest numer miesiaca (1-12),
- * a wartoscia unikalny wskaznik do wezla MonthNode.
+ * a wartoscia wezel MonthNode.
  */
 struct YearNode {
-    std::map<int, std::unique_ptr<MonthNode>> months;
+    MonthMap months;
+
+    /** @brief Agregaty wszystkich pomiarow w poddrzewie. */
+    NodeStats stats;
+
+    /** @brief Szkice kwantyli pol wszystkich pomiarow w poddrzewie. */
+    NodeSketches sketches;
+
+    /** @brief Numer zapisu drzewa (EnergyTree::epoch), w ktorym ostatnio zmieniono poddrzewo. */
+    std::uint64_t epoch = 0;
+
+    /** @brief Alokator przekazywany mapie i dalej wezlom potomnym. */
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    /**
+     * @brief Konstruktor pustego roku.
+     * @param alloc Alokator mapy miesiecy i szkicow.
+     */
+    explicit YearNode(const allocator_type& alloc = {}) : months(alloc), sketches(alloc) {}
 };
 
+/** @brief Mapa lat (korzen drzewa): rok -> wezel YearNode. */
+using YearMap = std::pmr::map<int, YearNode>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**
+ * @file DataGenerator.cpp
+ * @brief Implementacja generatora syntetycznych danych fotowoltaicznych.
+ */
+
+#include "DataGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+}
+
+/**
+ * @brief Generuje pomiary jednego licznika.
+ *
+ * Moc szczytowa instalacji (3-10 kWp) i ziarno generatora zaleza od numeru
+ * licznika, dzieki czemu kolejne liczniki maja rozne, ale powtarzalne dane.
+ *
+ * @param meter Numer licznika.
+ * @param opt Parametry danych.
+ * @return std::vector<Measurement> Pomiary posortowane wg czasu.
+ */
+std::vector<Measurement> DataGenerator::generate(int meter, const Options& opt) {
+    std::mt19937 rng(opt.seed + 7919u * static_cast<std::uint32_t>(meter));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    double peakPower = 3000.0 + 7000.0 * unit(rng);
+    double baseLoad = 200.0 + 250.0 * unit(rng);
+
+    std::tm first = {};
+    first.tm_year = opt.startYear - 1900;
+    first.tm_mday = 1;
+    std::tm last = first;
+    last.tm_year += opt.years;
+    time_t start = Measurement::toEpoch(first), end = Measurement::toEpoch(last);
+
+    std::vector<Measurement> out;
+    out.reserve(static_cast<std::size_t>((end - start) / 900));
+    double clouds = 1.0;
+    for (time_t t = start; t < end; t += 900) {
+        std::tm n = Measurement::fromEpoch(t);
+        double hour = n.tm_hour + n.tm_min / 60.0;
+        if (hour == 0.0) clouds = 0.15 + 0.85 * unit(rng); // Zachmurzenie losowane raz na dobe
+
+        // Pora roku: 1 w przesilenie letnie, -1 w zimowe
+        double season = std::sin(2.0 * PI * (n.tm_yday - 80) / 365.0);
+        double dayLength = 12.0 + 4.5 * season;
+        double sunrise = 12.5 - dayLength / 2.0;
+        double production = 0.0;
+        if (hour > sunrise && hour < sunrise + dayLength) {
+            double elevation = std::pow(std::sin(PI * (hour - sunrise) / dayLength), 1.5);
+            double noise = clouds < 0.7 ? 0.6 + 0.4 * unit(rng) : 0.92 + 0.08 * unit(rng);
+            production = peakPower * (0.55 + 0.45 * season) * elevation * clouds * noise;
+        }
+
+        double consumption = baseLoad * (1.0 + 0.3 * (1.0 - season) / 2.0) * (0.9 + 0.2 * unit(rng));
+        if (hour >= 6.5 && hour < 8.5) consumption += 500.0 * unit(rng);
+        if (hour >= 17.0 && hour < 22.0) consumption += (700.0 + 400.0 * (1.0 - season) / 2.0) * unit(rng);
+        if (unit(rng) < 0.03) consumption += 1500.0 + 1500.0 * unit(rng); // Czajnik, piekarnik, pralka
+
+        Measurement m;
+        m.setTimestamp(n);
+        m.production = production;
+        m.consumption = consumption;
+        m.autoconsumption = std::min(production, consumption);
+        m.exportEnergy = production - m.autoconsumption;
+        m.importEnergy = consumption - m.autoconsumption;
+        out.push_back(m);
+    }
+    return out;
+}
+
+/**
+ * @brief Zapisuje pomiary w formacie eksportu falownika.
+ *
+ * @param data Zapisywane pomiary.
+ * @param filename Sciezka do pliku docelowego.
+ * @return bool True, jesli zapis sie powiodl.
+ */
+bool DataGenerator::writeCsv(const std::vector<Measurement>& data, const std::string& filename) {
+    std::FILE* f = std::fopen(filename.c_str(), "wb");
+    if (!f) return false;
+    std::fputs("Time,Autokonsumpcja (W),Eksport (W),Import (W),Pob\xC3\xB3r (W),Produkcja (W)\n", f);
+    for (const Measurement& m : data) {
+        const std::tm& t = m.timestamp;
+        std::fprintf(f, "%02d.%02d.%04d %d:%02d,\"%.4f\",\"%.4f\",\"%.4f\",\"%.4f\",\"%.4f\"\n",
+            t.tm_mday, t.tm_mon + 1, t.tm_year + 1900, t.tm_hour, t.tm_min,
+            m.autoconsumption, m.exportEnergy, m.importEnergy, m.consumption, m.production);
+    }
+    return std::fclose(f) == 0;
+}
+
+/**
+ * @brief Generuje i zapisuje pliki wszystkich licznikow.
+ *
+ * @param opt Parametry danych.
+ * @param prefix Poczatek nazw plikow.
+ * @return std::vector<std::string> Sciezki utworzonych plikow.
+ */
+std::vector<std::string> DataGenerator::writeMeters(const Options& opt, const std::string& prefix) {
+    std::vector<std::string> files;
+    for (int k = 0; k < opt.meters; k++) {
+        std::string name = prefix + std::to_string(k) + ".csv";
+        if (!writeCsv(generate(k, opt), name)) return {};
+        files.push_back(name);
+    }
+    return files;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file DataGenerator.h
+ * @brief Definicja generatora syntetycznych danych fotowoltaicznych.
+ *
+ * Plik naglowkowy zawierajacy klase DataGenerator, ktora tworzy wieloletnie
+ * szeregi pomiarow 15-minutowych dla wielu licznikow (instalacji PV)
+ * i zapisuje je w formacie eksportu Chart_Export.csv.
+ */
+
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include "./../../Projekt06/Measurement.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+ /**
+  * @class DataGenerator
+  * @brief Klasa statyczna generujaca realistyczne dane instalacji PV.
+  *
+  * Produkcja to krzywa dzienna (polowa sinusoidy miedzy wschodem a zachodem
+  * slonca), ktorej dlugosc i wysokosc zaleza od pory roku, przemnozona przez
+  * losowe zachmurzenie dnia i szum chwilowy. Zuzycie to obciazenie bazowe
+  * z porannym i wieczornym szczytem (wyzszym zima) oraz losowymi wlaczeniami
+  * urzadzen. Autokonsumpcja, eksport i import wynikaja z bilansu produkcji
+  * i zuzycia. Dane sa deterministyczne dla danego ziarna i numeru licznika.
+  */
+class DataGenerator {
+public:
+    /**
+     * @struct Options
+     * @brief Parametry generowanych danych.
+     */
+    struct Options {
+        int years = 1;                  /**< Liczba pelnych lat danych. */
+        int meters = 1;                 /**< Liczba licznikow (osobnych plikow). */
+        int startYear = 2021;           /**< Rok pierwszego pomiaru (od 1 stycznia). */
+        std::uint32_t seed = 2024;      /**< Ziarno generatora liczb losowych. */
+    };
+
+    /**
+     * @brief Generuje pomiary jednego licznika, posortowane rosnaco wg czasu.
+     *
+     * @param meter Numer licznika (0 .. meters-1) - wyznacza moc instalacji i ziarno.
+     * @param opt Parametry danych.
+     * @return std::vector<Measurement> Pomiary co 15 minut przez opt.years lat.
+     */
+    static std::vector<Measurement> generate(int meter, const Options& opt);
+
+    /**
+     * @brief Zapisuje pomiary w formacie Chart_Export.csv (naglowek, daty "dd.mm.rrrr g:mm", wartosci w cudzyslowach).
+     *
+     * @param data Zapisywane pomiary.
+     * @param filename Sciezka do pliku docelowego.
+     * @return bool True, jesli zapis sie powiodl.
+     */
+    static bool writeCsv(const std::vector<Measurement>& data, const std::string& filename);
+
+    /**
+     * @brief Generuje i zapisuje pliki CSV wszystkich licznikow.
+     *
+     * @param opt Parametry danych.
+     * @param prefix Poczatek nazw plikow (plik licznika k: prefix + k + ".csv").
+     * @return std::vector<std::string> Sciezki utworzonych plikow (puste, jesli zapis sie nie powiodl).
+     */
+    static std::vector<std::string> writeMeters(const Options& opt, const std::string& prefix);
+};
+
+#endif
@@ -0,0 +1,424 @@
+/**
+ * @file benchmark.cpp
+ * @brief Pomiary wydajnosci wczytywania, zapisu, wstawiania, iteracji i zapytan.
+ *
+ * Program generuje syntetyczne dane (DataGenerator) dla zadanej liczby lat
+ * i licznikow, zapisuje je w formacie Chart_Export.csv, a nastepnie mierzy
+ * czas operacji FileManager, EnergyTree i Analyzer. Wyniki trafiaja na
+ * standardowe wyjscie bledow w postaci tabeli oraz (do pliku --out lub na
+ * standardowe wyjscie) w formacie JSON zgodnym z Google Benchmark
+ * (--benchmark_format=json), dzieki czemu dwa przebiegi mozna porownac
+ * narzedziem compare.py z Google Benchmark.
+ *
+ * Uzycie: benchmark-Projektu06 [--years N] [--meters M] [--min-time S]
+ *         [--filter TEKST] [--out PLIK.json] [--keep]
+ */
+
+#include "DataGenerator.h"
+#include "./../../Projekt06/Analyzer.h"
+#include "./../../Projekt06/FileManager.h"
+#include "./../../Projekt06/MeterStore.h"
+#include "./../../Projekt06/SimdKernels.h"
+#include "./../../Projekt06/SnapshotTree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /** @brief Zapobiega usunieciu przez kompilator wynikow mierzonych wywolan. */
+    volatile double sink = 0;
+
+    /**
+     * @struct Result
+     * @brief Wynik pomiaru jednej operacji.
+     */
+    struct Result {
+        std::string name;           /**< Nazwa pomiaru (grupa/operacja/parametr). */
+        std::size_t iterations;     /**< Liczba wykonan operacji. */
+        double realNs;              /**< Sredni czas rzeczywisty jednego wykonania [ns]. */
+        double cpuNs;               /**< Sredni czas procesora jednego wykonania [ns] (std::clock; w MSVC rowny czasowi rzeczywistemu). */
+        double items;               /**< Liczba elementow (np. pomiarow) przetwarzanych w jednym wykonaniu. */
+    };
+
+    /**
+     * @brief Bufor strumienia odrzucajacy dane - wylacza komunikaty std::cout na czas pomiarow.
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    /**
+     * @class Runner
+     * @brief Wykonuje operacje tyle razy, aby laczny czas pomiaru przekroczyl minTime.
+     *
+     * Liczba wykonan jest dobierana tak jak w Google Benchmark: zaczynajac
+     * od 1, jest zwiekszana na podstawie czasu poprzedniej proby, az czas
+     * pomiaru przekroczy minTime. Operacja z funkcja przygotowujaca (setup)
+     * jest mierzona pojedynczo, a czas setup nie jest wliczany.
+     */
+    class Runner {
+        double minTime;
+        std::string filter;
+        std::vector<Result> results;
+
+    public:
+        Runner(double minSeconds, std::string match) : minTime(minSeconds), filter(std::move(match)) {}
+
+        /**
+         * @brief Mierzy operacje (o ile jej nazwa zawiera tekst filtra).
+         *
+         * @param name Nazwa pomiaru.
+         * @param items Liczba elementow przetwarzanych w jednym wykonaniu (do items_per_second).
+         * @param op Mierzona operacja.
+         * @param setup Opcjonalne przygotowanie wykonywane przed kazdym wykonaniem (bez pomiaru).
+         */
+        void run(const std::string& name, double items, const std::function<void()>& op, const std::function<void()>& setup = {}) {
+            if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+            double real = 0, cpu = 0;
+            std::size_t n = 1;
+            for (;;) {
+                real = cpu = 0;
+                if (setup) {
+                    for (std::size_t i = 0; i < n; i++) {
+                        setup();
+                        measure(op, 1, real, cpu);
+                    }
+                }
+                else measure(op, n, real, cpu);
+                if (real >= minTime || n >= 1000000000) break;
+                double perOp = std::max(real / n, 1e-9);
+                std::size_t next = static_cast<std::size_t>(minTime * 1.4 / perOp);
+                n = std::clamp<std::size_t>(next, n + 1, n * 100);
+            }
+
+            Result r{ name, n, real * 1e9 / n, cpu * 1e9 / n, items };
+            results.push_back(r);
+            std::cerr << std::left << std::setw(44) << r.name << std::right << std::setw(16) << std::fixed << std::setprecision(0) << r.realNs << " ns"
+                << std::setw(12) << r.iterations;
+            if (items > 0) std::cerr << std::setw(16) << std::setprecision(3) << items * 1e9 / r.realNs / 1e6 << " M/s";
+            std::cerr << "\n";
+        }
+
+        /** @brief Zwraca wyniki w kolejnosci wykonania. */
+        const std::vector<Result>& all() const { return results; }
+
+    private:
+        static void measure(const std::function<void()>& op, std::size_t n, double& real, double& cpu) {
+            std::clock_t c0 = std::clock();
+            auto t0 = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < n; i++) op();
+            auto t1 = std::chrono::steady_clock::now();
+            std::clock_t c1 = std::clock();
+            real += std::chrono::duration<double>(t1 - t0).count();
+            cpu += static_cast<double>(c1 - c0) / CLOCKS_PER_SEC;
+        }
+    };
+
+    /** @brief Zamienia tekst na literal JSON (cudzyslowy i znaki sterujace). */
+    std::string quote(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+            else out += c;
+        }
+        return out + "\"";
+    }
+
+    /** @brief Zwraca nazwe poziomu SimdKernels. */
+    const char* simdName(SimdKernels::Level l) {
+        switch (l) {
+        case SimdKernels::Level::AVX2: return "AVX2";
+        case SimdKernels::Level::SSE2: return "SSE2";
+        default: return "SCALAR";
+        }
+    }
+
+    /**
+     * @brief Zapisuje wyniki w formacie JSON Google Benchmark (sekcje context i benchmarks).
+     */
+    void writeJson(std::ostream& os, const std::vector<Result>& results, const DataGenerator::Options& opt, std::size_t records, const char* exe) {
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        // Konfiguracja Release (NDEBUG) lub kompilacja z optymalizacja bez NDEBUG (np. g++ -O2)
+#if defined(NDEBUG) || (defined(__OPTIMIZE__) && !defined(_DEBUG))
+        const char* build = "release";
+#else
+        const char* build = "debug";
+#endif
+        os << std::setprecision(17);
+        os << "{\n  \"context\": {\n"
+            << "    \"date\": " << quote(date) << ",\n"
+            << "    \"executable\": " << quote(exe) << ",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+            << "    \"library_build_type\": " << quote(build) << ",\n"
+            << "    \"simd_level\": " << quote(simdName(SimdKernels::level())) << ",\n"
+            << "    \"years\": " << opt.years << ",\n"
+            << "    \"meters\": " << opt.meters << ",\n"
+            << "    \"records\": " << records << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            os << (i ? ",\n" : "\n") << "    {\n"
+                << "      \"name\": " << quote(r.name) << ",\n"
+                << "      \"run_name\": " << quote(r.name) << ",\n"
+                << "      \"run_type\": \"iteration\",\n"
+                << "      \"iterations\": " << r.iterations << ",\n"
+                << "      \"real_time\": " << r.realNs << ",\n"
+                << "      \"cpu_time\": " << r.cpuNs << ",\n"
+                << "      \"time_unit\": \"ns\"";
+            if (r.items > 0) os << ",\n      \"items_per_second\": " << r.items * 1e9 / r.realNs;
+            os << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    /** @brief Zwraca date odpowiadajaca czasowi t (sekundy od epoki). */
+    std::tm at(time_t t) { return Measurement::fromEpoch(t); }
+}
+
+/**
+ * @brief Punkt wejscia programu pomiarowego.
+ *
+ * @param argc Liczba argumentow.
+ * @param argv Argumenty (zob. opis pliku).
+ * @return int 0 po wykonaniu pomiarow, 1 przy blednych argumentach lub bledzie zapisu danych.
+ */
+int main(int argc, char** argv) {
+    DataGenerator::Options opt;
+    opt.years = 3;
+    opt.meters = 4;
+    double minTime = 0.5;
+    std::string filter, outFile;
+    bool keep = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--years" && hasValue) opt.years = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--meters" && hasValue) opt.meters = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue) minTime = std::atof(argv[++i]);
+        else if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--out" && hasValue) outFile = argv[++i];
+        else if (arg == "--keep") keep = true;
+        else {
+            std::cerr << "Uzycie: " << argv[0] << " [--years N] [--meters M] [--min-time S] [--filter TEKST] [--out PLIK.json] [--keep]\n";
+            return 1;
+        }
+    }
+
+    // --- Dane ---
+    std::cerr << "Generowanie danych: " << opt.years << " lat x " << opt.meters << " licznikow...\n";
+    std::vector<Measurement> data = DataGenerator::generate(0, opt);
+    std::vector<std::string> files = DataGenerator::writeMeters(opt, "bench_meter_");
+    if (files.empty()) {
+        std::cerr << "Nie mozna zapisac plikow CSV\n";
+        return 1;
+    }
+    double meterRecords = static_cast<double>(data.size());
+    double allRecords = meterRecords * opt.meters;
+
+    NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer); // Komunikaty FileManager i Analyzer
+    Runner runner(minTime, filter);
+    IngestLog::Options quiet{ IngestLog::Level::OFF };
+
+    // --- Wczytywanie CSV (wszystkie liczniki) ---
+    std::vector<EnergyTree> trees;
+    auto freshTrees = [&]() { trees.clear(); trees.resize(files.size()); };
+    runner.run("FileManager/loadCSV", allRecords, [&]() {
+        for (std::size_t k = 0; k < files.size(); k++) FileManager::loadCSV(trees[k], files[k], quiet);
+    }, freshTrees);
+    runner.run("FileManager/loadCSVParallel", allRecords, [&]() {
+        for (std::size_t k = 0; k < files.size(); k++) FileManager::loadCSVParallel(trees[k], files[k], 0, quiet);
+    }, freshTrees);
+    trees.clear();
+
+    // --- Magazyn licznikow: wczytywanie rownolegle po licznikach i zapytania floty ---
+    {
+        std::vector<std::string> ids;
+        MeterStore fleet;
+        fleet.setLogOptions(quiet);
+        auto registerMeters = [&]() {
+            ids.clear();
+            for (std::size_t k = 0; k < files.size(); k++) {
+                ids.push_back("meter" + std::to_string(k));
+                fleet.addMeter(ids.back(), files[k]);
+            }
+        };
+        registerMeters();
+        runner.run("MeterStore/loadAll", allRecords, [&]() { fleet.loadAll(); }, registerMeters);
+        fleet.loadAll();
+
+        time_t s = data.front().epochTime(), e = std::min<time_t>(s + 365 * 86400LL - 1, data.back().epochTime());
+        std::tm ts = at(s), te = at(e);
+        double n = static_cast<double>(fleet.aggregate(ids, s, e).count);
+        runner.run("MeterStore/aggregate/year", n, [&]() { sink = fleet.aggregate(ids, s, e).field(DataType::PROD).sum; });
+        runner.run("MeterStore/rank/year", n, [&]() { sink = fleet.rank(ids, ts, te, DataType::PROD).front().value; });
+    }
+
+    // --- Wstawianie pomiarow (jeden licznik) ---
+    EnergyTree scratch;
+    std::vector<Measurement> reversed(data.rbegin(), data.rend());
+    std::vector<Measurement> shuffled = data;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(opt.seed));
+    auto clearScratch = [&]() { scratch.clear(); };
+    runner.run("EnergyTree/addMeasurement/inOrder", meterRecords, [&]() { for (const Measurement& m : data) scratch.addMeasurement(m); }, clearScratch);
+    runner.run("EnergyTree/addMeasurement/reverse", meterRecords, [&]() { for (const Measurement& m : reversed) scratch.addMeasurement(m); }, clearScratch);
+    runner.run("EnergyTree/addMeasurement/random", meterRecords, [&]() { for (const Measurement& m : shuffled) scratch.addMeasurement(m); }, clearScratch);
+    runner.run("EnergyTree/addMeasurement/uniquePtr", meterRecords, [&]() {
+        for (const Measurement& m : data) scratch.addMeasurement(std::make_unique<Measurement>(m));
+    }, clearScratch);
+    runner.run("EnergyTree/bulkLoad", meterRecords, [&]() { scratch.bulkLoad(data); }, clearScratch);
+    runner.run("EnergyTree/clear", meterRecords, [&]() { scratch.clear(); }, [&]() { scratch.clear(); scratch.bulkLoad(data); });
+
+    // --- Zapis i odczyt binarny ---
+    EnergyTree tree;
+    tree.bulkLoad(data);
+    runner.run("FileManager/saveBinary/raw", meterRecords, [&]() { FileManager::saveBinary(tree, "bench_raw.bin"); });
+    runner.run("FileManager/saveBinary/compressed", meterRecords, [&]() { FileManager::saveBinary(tree, "bench_gorilla.bin", true); });
+    FileManager::saveBinary(tree, "bench_raw.bin");
+    FileManager::saveBinary(tree, "bench_gorilla.bin", true);
+    runner.run("FileManager/loadBinary/raw", meterRecords, [&]() { FileManager::loadBinary(scratch, "bench_raw.bin"); }, clearScratch);
+    runner.run("FileManager/loadBinary/compressed", meterRecords, [&]() { FileManager::loadBinary(scratch, "bench_gorilla.bin"); }, clearScratch);
+    scratch.clear();
+
+    // --- Iteracja ---
+    runner.run("EnergyTree/iterate/columns", meterRecords, [&]() {
+        double sum = 0;
+        for (auto it = tree.begin(); it != tree.end(); ++it) sum += it.value(DataType::PROD);
+        sink = sum;
+    });
+    runner.run("EnergyTree/iterate/measurements", meterRecords, [&]() {
+        double sum = 0;
+        for (const Measurement& m : tree) sum += m.production;
+        sink = sum;
+    });
+
+    // --- Zapytania Analyzer dla przedzialow roznej szerokosci ---
+    // Poczatek w srodku danych i poza granica bloku, aby obejmowac wezly brzegowe
+    Analyzer analyzer(tree);
+    analyzer.setCacheCapacity(0);
+    time_t first = data.front().epochTime(), last = data.back().epochTime();
+    time_t from = std::min<time_t>(first + 100 * 86400LL + 7 * 3600 + 15 * 60, last);
+    struct Width { const char* name; time_t seconds; };
+    const Width widths[] = {
+        { "day", 86400 }, { "week", 7 * 86400 }, { "month", 30 * 86400 }, { "year", 365 * 86400 }, { "all", last - first + 1 }
+    };
+    for (const Width& w : widths) {
+        time_t s = w.seconds > last - first ? first : from;
+        time_t e = std::min(s + w.seconds - 1, last);
+        std::tm ts = at(s), te = at(e);
+        double n = static_cast<double>(tree.aggregate(s, e).count);
+        std::string suffix = std::string("/") + w.name;
+
+        runner.run("EnergyTree/range" + suffix, n, [&]() {
+            double sum = 0;
+            for (const Measurement& m : tree.range(ts, te)) sum += m.production;
+            sink = sum;
+        });
+        runner.run("Analyzer/getSum" + suffix, n, [&]() { sink = analyzer.getSum(ts, te, DataType::PROD); });
+        runner.run("Analyzer/getAvg" + suffix, n, [&]() { sink = analyzer.getAvg(ts, te, DataType::CONS); });
+        runner.run("Analyzer/getSummary" + suffix, n, [&]() { sink = analyzer.getSummary(ts, te).selfSufficiency; });
+        runner.run("Analyzer/getPercentile" + suffix, n, [&]() { sink = analyzer.getPercentile(ts, te, DataType::IMPORT, 0.95); });
+        runner.run("Analyzer/search" + suffix, n, [&]() { sink = static_cast<double>(analyzer.search(DataType::PROD, 1500.0, 50.0, ts, te).size()); });
+        runner.run("Analyzer/pickResolution" + suffix, n, [&]() { sink = static_cast<double>(analyzer.pickResolution(ts, te, 500)); });
+        runner.run("Analyzer/getSeries500" + suffix, n, [&]() { sink = static_cast<double>(analyzer.getSeries(ts, te, std::size_t{ 500 }).size()); });
+        runner.run("Analyzer/printRange" + suffix, n, [&]() { analyzer.printRange(ts, te); });
+
+        // Ten sam przedzial rok wczesniej (lub przesuniety o szerokosc, gdy danych jest malo)
+        time_t shift = s - 365 * 86400LL >= first ? 365 * 86400LL : std::max<time_t>(e - s + 1, 1);
+        std::tm ps = at(s - shift), pe = at(e - shift);
+        runner.run("Analyzer/compare" + suffix, 2 * n, [&]() { analyzer.compare(ts, te, ps, pe, DataType::IMPORT); });
+
+        analyzer.setCacheCapacity(Analyzer::DEFAULT_CACHE_CAPACITY);
+        runner.run("Analyzer/getSum/cached" + suffix, n, [&]() { sink = analyzer.getSum(ts, te, DataType::PROD); });
+        analyzer.setCacheCapacity(0);
+    }
+
+    // Raport rok do roku (12 miesiecy x 5 pol): osobne getSum kontra jedno przejscie
+    {
+        std::vector<Analyzer::Comparison> items = Analyzer::yearOverYear(at(last).tm_year + 1900);
+        runner.run("Analyzer/yearOverYear/getSum", static_cast<double>(items.size()), [&]() {
+            double sum = 0;
+            for (const Analyzer::Comparison& c : items) sum += analyzer.getSum(c.start, c.end, c.type) - analyzer.getSum(c.baseStart, c.baseEnd, c.type);
+            sink = sum;
+        });
+        runner.run("Analyzer/yearOverYear/compareMany", static_cast<double>(items.size()), [&]() {
+            double sum = 0;
+            for (const Analyzer::ComparisonResult& r : analyzer.compareMany(items)) sum += r.difference;
+            sink = sum;
+        });
+    }
+
+    // --- Zapytania na migawkach bez wczytywania i w trakcie wczytywania (SnapshotTree) ---
+    {
+        SnapshotTree store;
+        store.add(data);
+        store.publish();
+        time_t s = from, e = std::min<time_t>(from + 30 * 86400LL - 1, last);
+        std::tm ts = at(s), te = at(e);
+        double n = static_cast<double>(tree.aggregate(s, e).count);
+        auto query = [&]() {
+            std::shared_ptr<const EnergyTree> snap = store.snapshot();
+            Analyzer reader(*snap);
+            reader.setCacheCapacity(0);
+            sink = reader.getSum(ts, te, DataType::PROD);
+        };
+        runner.run("SnapshotTree/getSum/month/idle", n, query);
+
+        // Pisarz dopisuje kolejne doby danych przesunietych za koniec zbioru
+        std::atomic<bool> stop{ false };
+        std::atomic<std::size_t> ingested{ 0 };
+        std::thread writer([&]() {
+            time_t span = last - first + 86400;
+            std::vector<Measurement> batch;
+            for (int pass = 1; !stop.load(); pass++) {
+                for (std::size_t i = 0; i < data.size() && !stop.load(); i++) {
+                    Measurement m = data[i];
+                    m.setTimestamp(at(m.epochTime() + pass * span));
+                    batch.push_back(m);
+                    if (batch.size() == 96) {
+                        store.add(batch);
+                        store.publish();
+                        ingested += batch.size();
+                        batch.clear();
+                    }
+                }
+            }
+        });
+        auto t0 = std::chrono::steady_clock::now();
+        runner.run("SnapshotTree/getSum/month/ingesting", n, query);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        stop = true;
+        writer.join();
+        std::cerr << "  (wczytywanie w tle: " << std::fixed << std::setprecision(3) << ingested.load() / seconds / 1e6 << " M/s)\n";
+    }
+    std::cout.rdbuf(coutBuffer);
+
+    // --- Wyniki ---
+    if (outFile.empty()) writeJson(std::cout, runner.all(), opt, static_cast<std::size_t>(allRecords), argv[0]);
+    else {
+        std::ofstream out(outFile);
+        writeJson(out, runner.all(), opt, static_cast<std::size_t>(allRecords), argv[0]);
+    }
+
+    if (!keep) {
+        for (const std::string& f : files) std::remove(f.c_str());
+        for (const char* f : { "bench_raw.bin", "bench_gorilla.bin" }) std::remove(f);
+    }
+    return 0;
+}
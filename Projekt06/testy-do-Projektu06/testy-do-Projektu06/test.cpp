@@ -1,7 +1,19 @@
 #include <gtest/gtest.h>
+#include <cmath>
 #include <memory>
+#include <memory_resource>
 #include "./../../Projekt06/EnergyTree.h"
 #include "./../../Projekt06/Analyzer.h"
+#include "./../../Projekt06/CsvParser.h"
+#include "./../../Projekt06/ThreadPool.h"
+#include "./../../Projekt06/FileManager.h"
+#include "./../../Projekt06/BinaryArchive.h"
+#include "./../../Projekt06/SimdKernels.h"
+#include "./../../Projekt06/CsvFollower.h"
+#include "./../../Projekt06/Metrics.h"
+#include "./../../Projekt06/SnapshotTree.h"
+#include "./../../Projekt06/QuantileSketch.h"
+#include "./../../Projekt06/MeterStore.h"
 
 // --- TESTY ENERGY TREE ---
 
@@ -136,4 +148,1386 @@ TEST(MeasurementTest, TimeConversion) {
 
     time_t expected = mktime(&m.timestamp);
     EXPECT_EQ(m.tmToTime(), expected);
-}
\ No newline at end of file
+}
+
+// 11. Test agregatow wezlow (suma roczna, min, max, zakres czesciowy)
+TEST(EnergyTreeTest, NodeAggregates) {
+    EnergyTree tree;
+    for (int day = 1; day <= 3; day++) {
+        for (int hour = 0; hour < 24; hour += 5) {
+            auto m = std::make_unique<Measurement>();
+            m->timestamp.tm_year = 121; m->timestamp.tm_mon = 2; m->timestamp.tm_mday = day;
+            m->timestamp.tm_hour = hour; m->timestamp.tm_isdst = -1;
+            m->production = day * 10.0 + hour;
+            tree.addMeasurement(std::move(m));
+        }
+    }
+
+    std::tm s = {}, e = {};
+    s.tm_year = 121; s.tm_mon = 0; s.tm_mday = 1; s.tm_isdst = -1;
+    e.tm_year = 121; e.tm_mon = 11; e.tm_mday = 31; e.tm_hour = 23; e.tm_isdst = -1;
+    NodeStats all = tree.aggregate(Measurement::toEpoch(s), Measurement::toEpoch(e));
+    EXPECT_EQ(all.count, 15u);
+    EXPECT_DOUBLE_EQ(all.field(DataType::PROD).sum, 3 * (0 + 5 + 10 + 15 + 20) + 5 * (10 + 20 + 30));
+    EXPECT_DOUBLE_EQ(all.field(DataType::PROD).min, 10.0);
+    EXPECT_DOUBLE_EQ(all.field(DataType::PROD).max, 50.0);
+
+    // Od 2 marca 10:00 do 3 marca 05:00 - przedzial przecina bloki brzegowe
+    s = {}; s.tm_year = 121; s.tm_mon = 2; s.tm_mday = 2; s.tm_hour = 10; s.tm_isdst = -1;
+    e = {}; e.tm_year = 121; e.tm_mon = 2; e.tm_mday = 3; e.tm_hour = 5; e.tm_isdst = -1;
+    Analyzer an(tree);
+    EXPECT_DOUBLE_EQ(an.getSum(s, e, DataType::PROD), (30 + 35 + 40) + (30 + 35));
+    EXPECT_DOUBLE_EQ(an.getAvg(s, e, DataType::PROD), 170.0 / 5);
+}
+
+
+// 12. Test widoku zakresowego (pozycjonowanie na poczatku i zatrzymanie za koncem)
+TEST(EnergyTreeTest, RangeView) {
+    EnergyTree tree;
+    for (int year = 120; year <= 122; year++) {
+        for (int month = 0; month < 12; month += 4) {
+            for (int hour = 0; hour < 24; hour += 3) {
+                auto m = std::make_unique<Measurement>();
+                m->timestamp.tm_year = year; m->timestamp.tm_mon = month; m->timestamp.tm_mday = 15;
+                m->timestamp.tm_hour = hour; m->timestamp.tm_isdst = -1;
+                m->importEnergy = 1.0;
+                tree.addMeasurement(std::move(m));
+            }
+        }
+    }
+
+    // Od 15.05.2021 07:00 do 15.01.2022 06:00
+    std::tm s = {}, e = {};
+    s.tm_year = 121; s.tm_mon = 4; s.tm_mday = 15; s.tm_hour = 7; s.tm_isdst = -1;
+    e.tm_year = 122; e.tm_mon = 0; e.tm_mday = 15; e.tm_hour = 6; e.tm_isdst = -1;
+
+    int count = 0;
+    std::tm first = {}, last = {};
+    for (const Measurement& m : tree.range(s, e)) {
+        if (count == 0) first = m.timestamp;
+        last = m.timestamp;
+        count++;
+    }
+    // Maj 2021: 9,12,15,18,21 (5), wrzesien 2021: 8, styczen 2022: 0,3,6 (3)
+    EXPECT_EQ(count, 16);
+    EXPECT_EQ(first.tm_mon, 4);
+    EXPECT_EQ(first.tm_hour, 9);
+    EXPECT_EQ(last.tm_year, 122);
+    EXPECT_EQ(last.tm_hour, 6);
+
+    // Przedzial bez danych
+    s = {}; s.tm_year = 123; s.tm_mon = 0; s.tm_mday = 1; s.tm_isdst = -1;
+    e = s; e.tm_mon = 5;
+    auto empty = tree.range(s, e);
+    EXPECT_FALSE(empty.begin() != empty.end());
+}
+
+
+// 13. Test konwersji daty na sekundy od epoki i z powrotem (bez strefy czasowej)
+TEST(MeasurementTest, EpochRoundTrip) {
+    std::tm t = {};
+    t.tm_year = 124; t.tm_mon = 1; t.tm_mday = 29; t.tm_hour = 23; t.tm_min = 45; // 29.02.2024
+    time_t epoch = Measurement::toEpoch(t);
+    EXPECT_EQ(epoch, 1709250300);
+
+    std::tm back = Measurement::fromEpoch(epoch);
+    EXPECT_EQ(back.tm_year, 124);
+    EXPECT_EQ(back.tm_mon, 1);
+    EXPECT_EQ(back.tm_mday, 29);
+    EXPECT_EQ(back.tm_hour, 23);
+    EXPECT_EQ(back.tm_min, 45);
+    EXPECT_EQ(back.tm_wday, 4); // czwartek
+    EXPECT_EQ(back.tm_yday, 59);
+
+    // Normalizacja: dzien 0 to ostatni dzien poprzedniego miesiaca, takze przed 1970
+    std::tm zero = {};
+    zero.tm_hour = 3;
+    std::tm norm = Measurement::fromEpoch(Measurement::toEpoch(zero));
+    EXPECT_EQ(norm.tm_year, -1);
+    EXPECT_EQ(norm.tm_mon, 11);
+    EXPECT_EQ(norm.tm_mday, 31);
+    EXPECT_EQ(norm.tm_hour, 3);
+}
+
+// 14. Test odtwarzania pomiaru z kolumn liscia przez iterator
+TEST(EnergyTreeTest, ColumnarLeafView) {
+    EnergyTree tree;
+    for (int min = 45; min >= 0; min -= 15) {
+        Measurement m;
+        m.timestamp.tm_year = 122; m.timestamp.tm_mon = 6; m.timestamp.tm_mday = 1; m.timestamp.tm_hour = 13; m.timestamp.tm_min = min;
+        m.autoconsumption = min + 1; m.exportEnergy = min + 2; m.importEnergy = min + 3; m.consumption = min + 4; m.production = min + 5;
+        EXPECT_TRUE(tree.addMeasurement(m));
+    }
+
+    int expectedMin = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        EXPECT_EQ(it->timestamp.tm_min, expectedMin);
+        EXPECT_EQ(it->timestamp.tm_hour, 13);
+        EXPECT_DOUBLE_EQ(it->autoconsumption, expectedMin + 1);
+        EXPECT_DOUBLE_EQ(it.value(DataType::CONS), expectedMin + 4);
+        EXPECT_DOUBLE_EQ((*it).production, expectedMin + 5);
+        expectedMin += 15;
+    }
+    EXPECT_EQ(expectedMin, 60);
+}
+
+
+// 15. Test slotow siatki 15-minutowej i pomiarow spoza siatki w jednym bloku
+TEST(EnergyTreeTest, SlotLeafWithOverflow) {
+    EnergyTree tree;
+    auto make = [](int hour, int min, int sec, double value) {
+        Measurement m;
+        m.timestamp.tm_year = 123; m.timestamp.tm_mon = 3; m.timestamp.tm_mday = 2;
+        m.timestamp.tm_hour = hour; m.timestamp.tm_min = min; m.timestamp.tm_sec = sec;
+        m.importEnergy = value;
+        return m;
+    };
+
+    EXPECT_TRUE(tree.addMeasurement(make(7, 30, 0, 2.0)));
+    EXPECT_TRUE(tree.addMeasurement(make(6, 0, 0, 1.0)));
+    EXPECT_TRUE(tree.addMeasurement(make(7, 31, 10, 3.0)));  // spoza siatki
+    EXPECT_TRUE(tree.addMeasurement(make(6, 0, 5, 1.5)));    // spoza siatki
+    EXPECT_TRUE(tree.addMeasurement(make(11, 45, 0, 4.0)));  // ostatni slot bloku
+    EXPECT_FALSE(tree.addMeasurement(make(7, 30, 0, 9.0)));  // duplikat slotu
+    EXPECT_FALSE(tree.addMeasurement(make(6, 0, 5, 9.0)));   // duplikat spoza siatki
+
+    std::vector<double> order;
+    for (auto it = tree.begin(); it != tree.end(); ++it) order.push_back(it.value(DataType::IMPORT));
+    EXPECT_EQ(order, (std::vector<double>{ 1.0, 1.5, 2.0, 3.0, 4.0 }));
+
+    // Zakres 06:00:01 - 07:31:10 obejmuje czesc slotow i czesc listy nadmiarowej
+    std::tm s = make(6, 0, 1, 0).timestamp, e = make(7, 31, 10, 0).timestamp;
+    NodeStats st = tree.aggregate(Measurement::toEpoch(s), Measurement::toEpoch(e));
+    EXPECT_EQ(st.count, 3u);
+    EXPECT_DOUBLE_EQ(st.field(DataType::IMPORT).sum, 6.5);
+}
+
+
+// 16. Test zgodnosci konwersji bez rozgalezien na szerokim zakresie dat
+TEST(MeasurementTest, EpochArithmeticConsistency) {
+    // Co 7 godzin i 13 minut od 1600 do 2400 roku: konwersja w obie strony i monotonicznosc
+    time_t from = -11676096000LL, to = 13569465600LL;
+    time_t prev = from - 1;
+    for (time_t t = from; t < to; t += 7 * 3600 + 13 * 60) {
+        std::tm d = Measurement::fromEpoch(t);
+        ASSERT_EQ(Measurement::toEpoch(d), t);
+        ASSERT_GT(t, prev);
+        ASSERT_GE(d.tm_yday, 0);
+        ASSERT_LE(d.tm_yday, 365);
+        prev = t;
+    }
+
+    // Przeliczenie wyznaczone raz przy ustawianiu daty jest uzywane w porownaniach
+    Measurement a, b;
+    std::tm t = {};
+    t.tm_year = 125; t.tm_mon = 9; t.tm_mday = 26; t.tm_hour = 2; t.tm_min = 30;
+    a.setTimestamp(t);
+    b.timestamp = t;
+    EXPECT_TRUE(a.hasEpoch());
+    EXPECT_EQ(a.epochTime(), Measurement::toEpoch(t));
+    EXPECT_FALSE(b.hasEpoch());
+    EXPECT_TRUE(a == b);
+    b.timestamp.tm_min = 45;
+    EXPECT_TRUE(a < b);
+
+    // Kopia z nowa data ustawiona przez setTimestamp nie zachowuje starego czasu
+    Measurement c = a;
+    t.tm_min = 45;
+    c.setTimestamp(t);
+    EXPECT_TRUE(c == b);
+    Measurement d;
+    d.setEpoch(a.epochTime());
+    EXPECT_TRUE(d == a);
+    EXPECT_EQ(d.timestamp.tm_min, 30);
+}
+
+
+// --- TESTY CSV PARSER ---
+
+// 17. Test parsowania linii w formacie Chart_Export.csv (przecinki, cudzyslowy)
+TEST(CsvParserTest, ChartExportLine) {
+    Measurement m;
+    EXPECT_EQ(CsvParser::parseLine("01.10.2020 7:45,\"12.5\",\"0\",\"406.8323\",\"419.3323\",\"12.5\"", ',', m), nullptr);
+    EXPECT_EQ(m.timestamp.tm_year, 120);
+    EXPECT_EQ(m.timestamp.tm_mon, 9);
+    EXPECT_EQ(m.timestamp.tm_mday, 1);
+    EXPECT_EQ(m.timestamp.tm_hour, 7);
+    EXPECT_EQ(m.timestamp.tm_min, 45);
+    EXPECT_TRUE(m.hasEpoch());
+    EXPECT_EQ(m.epochTime(), Measurement::toEpoch(m.timestamp));
+    EXPECT_DOUBLE_EQ(m.autoconsumption, 12.5);
+    EXPECT_DOUBLE_EQ(m.importEnergy, 406.8323);
+    EXPECT_DOUBLE_EQ(m.consumption, 419.3323);
+
+    // Format ze srednikami i przecinkiem dziesietnym
+    EXPECT_EQ(CsvParser::detectSeparator("Time;Autokonsumpcja (W);Eksport (W)"), ';');
+    EXPECT_EQ(CsvParser::parseLine("15.03.2021 12:00;1,5;2;3;4;\"5,25\"", ';', m), nullptr);
+    EXPECT_DOUBLE_EQ(m.autoconsumption, 1.5);
+    EXPECT_DOUBLE_EQ(m.production, 5.25);
+}
+
+// 18. Test odrzucania blednych linii
+TEST(CsvParserTest, RejectsMalformedLines) {
+    Measurement m;
+    EXPECT_STREQ(CsvParser::parseLine("07.10.2021 17:30,\"1\",\"2\",\"3\",\"4\"", ',', m), CsvParser::ERR_COLUMNS);
+    EXPECT_STREQ(CsvParser::parseLine("Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobor (W),Produkcja (W)", ',', m), CsvParser::ERR_DATE);
+    EXPECT_STREQ(CsvParser::parseLine("32.10.2021 17:30,1,2,3,4,5", ',', m), CsvParser::ERR_DATE);
+    EXPECT_STREQ(CsvParser::parseLine("07.10.2021 17:30,\"xxxx\",2,3,4,5", ',', m), CsvParser::ERR_NUMBER);
+
+    // Podzial na linie z koncami CRLF
+    std::string_view data = "a\r\nb\n\nc";
+    std::size_t pos = 0;
+    EXPECT_EQ(CsvParser::nextLine(data, pos), "a");
+    EXPECT_EQ(CsvParser::nextLine(data, pos), "b");
+    EXPECT_EQ(CsvParser::nextLine(data, pos), "");
+    EXPECT_EQ(CsvParser::nextLine(data, pos), "c");
+    EXPECT_EQ(pos, data.size());
+}
+
+
+// --- TESTY THREAD POOL ---
+
+// 19. Test puli watkow - wyniki odbierane w kolejnosci zlecenia
+TEST(ThreadPoolTest, FuturesKeepSubmissionOrder) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.size(), 3u);
+    std::vector<std::future<long long>> results;
+    for (int i = 0; i < 50; i++) {
+        results.push_back(pool.submit([i]() {
+            long long sum = 0;
+            for (int k = 0; k <= i * 1000; k++) sum += k;
+            return sum;
+        }));
+    }
+    for (int i = 0; i < 50; i++) {
+        long long n = i * 1000LL;
+        EXPECT_EQ(results[i].get(), n * (n + 1) / 2);
+    }
+}
+
+
+// 20. Test wczytywania posortowanej paczki pomiarow (bulkLoad)
+TEST(EnergyTreeTest, SortedBulkLoad) {
+    // Co 10 minut przez 40 dni (przejscie miesiaca, pomiary w slotach i poza siatka)
+    std::tm start = {};
+    start.tm_year = 123; start.tm_mon = 0; start.tm_mday = 20;
+    time_t t0 = Measurement::toEpoch(start);
+    std::vector<Measurement> batch;
+    for (int i = 0; i < 40 * 144; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 600));
+        m.production = i % 17; m.consumption = i % 5 + 0.5;
+        batch.push_back(m);
+    }
+
+    EnergyTree reference;
+    for (const Measurement& m : batch) EXPECT_TRUE(reference.addMeasurement(m));
+
+    EnergyTree tree;
+    tree.addMeasurement(batch[100]);               // juz obecny w drzewie
+    std::vector<Measurement> input = batch;
+    input.insert(input.begin() + 501, batch[500]); // duplikat sasiada
+    input.push_back(batch[7]);                     // naruszenie porzadku (duplikat)
+    Measurement late = batch[8];
+    late.setTimestamp(Measurement::fromEpoch(t0 + 8 * 600 + 30)); // naruszenie porzadku (nowy)
+    input.push_back(late);
+
+    std::vector<std::size_t> duplicates;
+    EXPECT_EQ(tree.bulkLoad(input, &duplicates), batch.size());
+    EXPECT_EQ(duplicates, (std::vector<std::size_t>{ 100, 501, input.size() - 2 }));
+
+    NodeStats a = reference.aggregate(t0, t0 + 40 * 86400);
+    NodeStats b = tree.aggregate(t0, t0 + 40 * 86400);
+    EXPECT_EQ(b.count, a.count + 1);
+    EXPECT_DOUBLE_EQ(b.field(DataType::PROD).sum, a.field(DataType::PROD).sum + late.production);
+    EXPECT_DOUBLE_EQ(b.field(DataType::CONS).max, a.field(DataType::CONS).max);
+    EXPECT_EQ(b.first, a.first);
+    EXPECT_EQ(b.last, a.last);
+
+    // Agregaty miesiaca po przejsciu granicy zgodne z drzewem budowanym pojedynczo
+    std::tm feb = {};
+    feb.tm_year = 123; feb.tm_mon = 1; feb.tm_mday = 1;
+    time_t f = Measurement::toEpoch(feb);
+    EXPECT_EQ(tree.aggregate(f, f + 28 * 86400 - 1).count, reference.aggregate(f, f + 28 * 86400 - 1).count);
+
+    std::size_t n = 0;
+    time_t prev = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it, n++) {
+        if (n > 0) { EXPECT_GT(it.time(), prev); }
+        prev = it.time();
+    }
+    EXPECT_EQ(n, batch.size() + 1);
+}
+
+
+// --- TESTY FORMATU BINARNEGO ---
+
+// 21. Test zapisu w formacie v2 i zapytan bezposrednio z pliku
+TEST(BinaryArchiveTest, RoundTripAndDirectQueries) {
+    EnergyTree tree;
+    std::tm start = {};
+    start.tm_year = 121; start.tm_mon = 11; start.tm_mday = 30;
+    time_t t0 = Measurement::toEpoch(start);
+    for (int i = 0; i < 10000; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900 + (i % 50 == 0 ? 7 : 0))); // czesc spoza siatki
+        m.autoconsumption = i % 11; m.exportEnergy = i * 0.5; m.importEnergy = 100 - i % 100;
+        m.consumption = i % 3; m.production = (i % 96) * 1.25;
+        tree.addMeasurement(m);
+    }
+
+    const std::string file = "test_archive_v2.bin";
+    FileManager::saveBinary(tree, file);
+    EXPECT_TRUE(BinaryArchive::isArchive(file));
+
+    {
+        BinaryArchive archive(file);
+        ASSERT_TRUE(archive.isValid());
+        EXPECT_EQ(archive.size(), 10000u);
+        EXPECT_EQ(archive.blockCount(), (10000u + BinaryArchive::BLOCK_RECORDS - 1) / BinaryArchive::BLOCK_RECORDS);
+
+        // Przedzialy obejmujace cale bloki i fragmenty blokow
+        time_t ranges[][2] = { { t0, t0 + 10000 * 900 }, { t0 + 4000 * 900, t0 + 8500 * 900 + 3 }, { t0 + 123, t0 + 124 } };
+        for (auto& r : ranges) {
+            NodeStats a = tree.aggregate(r[0], r[1]);
+            NodeStats b = archive.aggregate(r[0], r[1]);
+            EXPECT_EQ(b.count, a.count);
+            EXPECT_EQ(b.first, a.first);
+            EXPECT_EQ(b.last, a.last);
+            for (int f = 0; f < FIELD_COUNT; f++) {
+                EXPECT_DOUBLE_EQ(b.fields[f].sum, a.fields[f].sum);
+                EXPECT_EQ(b.fields[f].min, a.fields[f].min);
+                EXPECT_EQ(b.fields[f].max, a.fields[f].max);
+            }
+        }
+    }
+
+    EnergyTree loaded;
+    FileManager::loadBinary(loaded, file);
+    auto it = tree.begin();
+    std::size_t n = 0;
+    for (auto jt = loaded.begin(); jt != loaded.end(); ++jt, ++it, n++) {
+        ASSERT_TRUE(it != tree.end());
+        EXPECT_EQ(jt.time(), it.time());
+        EXPECT_EQ(jt->timestamp.tm_mday, it->timestamp.tm_mday);
+        EXPECT_DOUBLE_EQ(jt.value(DataType::PROD), it.value(DataType::PROD));
+    }
+    EXPECT_EQ(n, 10000u);
+    std::remove(file.c_str());
+}
+
+// 22. Test odczytu pliku w starym formacie (surowe rekordy bez naglowka)
+TEST(BinaryArchiveTest, LegacyFormatStillLoads) {
+    const std::string file = "test_archive_v1.bin";
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        for (int h = 0; h < 24; h++) {
+            Measurement m;
+            m.timestamp.tm_year = 122; m.timestamp.tm_mon = 2; m.timestamp.tm_mday = 5; m.timestamp.tm_hour = h;
+            m.production = h;
+            m.serialize(ofs);
+        }
+    }
+    EXPECT_FALSE(BinaryArchive::isArchive(file));
+    EXPECT_FALSE(BinaryArchive(file).isValid());
+
+    EnergyTree tree;
+    FileManager::loadBinary(tree, file);
+    std::tm day = {};
+    day.tm_year = 122; day.tm_mon = 2; day.tm_mday = 5;
+    NodeStats s = tree.aggregate(Measurement::toEpoch(day), Measurement::toEpoch(day) + 86399);
+    EXPECT_EQ(s.count, 24u);
+    EXPECT_DOUBLE_EQ(s.field(DataType::PROD).sum, 276.0);
+    std::remove(file.c_str());
+}
+
+
+// 23. Test kodeka szeregow czasowych (delta-of-delta i XOR)
+TEST(BinaryArchiveTest, TimeSeriesCodecRoundTrip) {
+    const std::size_t n = 1000;
+    std::vector<std::int64_t> times(n);
+    std::vector<double> cols[FIELD_COUNT];
+    for (auto& c : cols) c.resize(n);
+    std::int64_t t = -86400LL * 400; // takze czasy przed 1970
+    for (std::size_t i = 0; i < n; i++) {
+        t += (i % 97 == 0) ? 900 + 37 : (i % 301 == 0 ? 86400 * 40 : 900); // nieregularne odstepy
+        times[i] = t;
+        cols[0][i] = 0.0;                              // stala
+        cols[1][i] = (i / 10) * 12.5;                  // schodki
+        cols[2][i] = 406.8323 + i * 0.001;             // plynna zmiana
+        cols[3][i] = (i % 2) ? -1e300 : 3.5e-310;      // skrajne wartosci
+        cols[4][i] = (i % 7) * 1.25 - 3;
+    }
+    const double* in[FIELD_COUNT];
+    for (int f = 0; f < FIELD_COUNT; f++) in[f] = cols[f].data();
+
+    std::vector<std::uint8_t> buf;
+    TimeSeriesCodec::encode(times.data(), in, n, buf);
+
+    std::vector<std::int64_t> outTimes(n);
+    std::vector<double> outCols[FIELD_COUNT];
+    double* out[FIELD_COUNT];
+    for (int f = 0; f < FIELD_COUNT; f++) { outCols[f].resize(n); out[f] = outCols[f].data(); }
+    ASSERT_TRUE(TimeSeriesCodec::decode(buf.data(), buf.size(), n, outTimes.data(), out));
+    EXPECT_EQ(outTimes, times);
+    for (int f = 0; f < FIELD_COUNT; f++) EXPECT_EQ(outCols[f], cols[f]);
+
+    // Obciete dane sa wykrywane
+    EXPECT_FALSE(TimeSeriesCodec::decode(buf.data(), buf.size() / 2, n, outTimes.data(), out));
+}
+
+// 24. Test zapisu skompresowanego - mniejszy plik, te same dane i zapytania
+TEST(BinaryArchiveTest, CompressedArchive) {
+    EnergyTree tree;
+    std::tm start = {};
+    start.tm_year = 122; start.tm_mon = 5; start.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(start);
+    for (int i = 0; i < 9000; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900));
+        int q = i % 96;
+        m.production = (q > 24 && q < 80) ? (q - 24) * (80 - q) * 0.75 : 0.0;
+        m.consumption = 300 + (i % 13);
+        m.autoconsumption = m.production < m.consumption ? m.production : m.consumption;
+        m.exportEnergy = m.production - m.autoconsumption;
+        m.importEnergy = m.consumption - m.autoconsumption;
+        tree.addMeasurement(m);
+    }
+
+    const std::string raw = "test_archive_raw.bin", packed = "test_archive_gorilla.bin";
+    FileManager::saveBinary(tree, raw);
+    FileManager::saveBinary(tree, packed, true);
+    std::ifstream a(raw, std::ios::binary | std::ios::ate), b(packed, std::ios::binary | std::ios::ate);
+    EXPECT_LT(static_cast<long long>(b.tellg()) * 3, static_cast<long long>(a.tellg()));
+
+    {
+        BinaryArchive archive(packed);
+        ASSERT_TRUE(archive.isValid());
+        EXPECT_EQ(archive.codec(), BinaryArchive::Codec::GORILLA);
+        NodeStats x = archive.aggregate(t0 + 1000 * 900 + 1, t0 + 5000 * 900);
+        NodeStats y = tree.aggregate(t0 + 1000 * 900 + 1, t0 + 5000 * 900);
+        EXPECT_EQ(x.count, y.count);
+        EXPECT_DOUBLE_EQ(x.field(DataType::PROD).sum, y.field(DataType::PROD).sum);
+        EXPECT_EQ(x.field(DataType::IMPORT).max, y.field(DataType::IMPORT).max);
+    }
+
+    EnergyTree loaded;
+    FileManager::loadBinary(loaded, packed);
+    auto it = tree.begin();
+    std::size_t n = 0;
+    for (auto jt = loaded.begin(); jt != loaded.end(); ++jt, ++it, n++) {
+        ASSERT_TRUE(it != tree.end());
+        EXPECT_EQ(jt.time(), it.time());
+        for (int f = 0; f < FIELD_COUNT; f++) EXPECT_EQ(jt.value(static_cast<DataType>(f)), it.value(static_cast<DataType>(f)));
+    }
+    EXPECT_EQ(n, 9000u);
+    a.close(); b.close();
+    std::remove(raw.c_str());
+    std::remove(packed.c_str());
+}
+
+
+// --- TESTY IMPORTU ---
+
+// 25. Test dziennika importu - limit probek na kategorie i podsumowanie
+TEST(IngestLogTest, SamplesPerCategoryAndSummary) {
+    {
+        IngestLog::Options options;
+        options.level = IngestLog::Level::ERRORS;
+        options.samples = 3;
+        IngestLog log("test_ingest", options);
+        for (int i = 0; i < 100000; i++) log.ok("01.01.2024 0:00,1,2,3,4,5");
+        for (int i = 0; i < 10; i++) log.error(CsvParser::ERR_DATE, "zla data " + std::to_string(i));
+        log.record("brak kolumn", CsvParser::ERR_COLUMNS);
+        log.finish();
+        EXPECT_EQ(log.validCount(), 100000u);
+        EXPECT_EQ(log.invalidCount(), 11u);
+        EXPECT_EQ(log.categoryCount(CsvParser::ERR_DATE), 10u);
+        EXPECT_EQ(log.categoryCount(CsvParser::ERR_COLUMNS), 1u);
+        EXPECT_EQ(log.categoryCount("Duplikat"), 0u);
+    }
+
+    std::ifstream all("log_test_ingest.txt"), err("log_error_test_ingest.txt");
+    std::string line;
+    int okLines = 0, errLines = 0, summaryLines = 0;
+    while (std::getline(all, line)) {
+        if (line.rfind("OK:", 0) == 0) okLines++;
+        if (line.rfind("ERR:", 0) == 0) errLines++;
+        if (line.rfind("--- Podsumowanie", 0) == 0) summaryLines++;
+    }
+    EXPECT_EQ(okLines, 0);          // wpisy "OK:" wylaczone
+    EXPECT_EQ(errLines, 3 + 1);     // 3 probki "Bledna data" + 1 "Niepelna linia"
+    EXPECT_EQ(summaryLines, 1);
+
+    std::string errText((std::istreambuf_iterator<char>(err)), std::istreambuf_iterator<char>());
+    EXPECT_NE(errText.find("ERR: Bledna data | zla data 2"), std::string::npos);
+    EXPECT_EQ(errText.find("zla data 3"), std::string::npos);
+    EXPECT_NE(errText.find("Bledna data: 10 (zapisano 3 pierwszych)"), std::string::npos);
+    all.close(); err.close();
+    std::remove("log_test_ingest.txt");
+    std::remove("log_error_test_ingest.txt");
+}
+
+// 26. Test zgodnosci wczytywania wielowatkowego z jednowatkowym (bez plikow logow)
+TEST(IngestLogTest, ParallelLoadMatchesSequential) {
+    const std::string file = "test_parallel.csv";
+    {
+        std::ofstream ofs(file);
+        ofs << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobor (W),Produkcja (W)\n";
+        for (int i = 0; i < 60000; i++) {
+            int k = i % 7 == 3 ? i - 1 : i; // co 7. linia jest duplikatem poprzedniej daty
+            std::tm t = Measurement::fromEpoch(1600000000 + k * 900LL);
+            ofs << t.tm_mday << "." << t.tm_mon + 1 << "." << t.tm_year + 1900 << " " << t.tm_hour << ":" << (t.tm_min < 10 ? "0" : "") << t.tm_min;
+            ofs << ",\"" << i % 13 << "\",\"1.5\",\"" << i % 5 << "\",\"" << i * 0.25 << "\",\"" << (i % 101) * 1.75 << "\"\n";
+            if (i % 997 == 0) ofs << "31.02.2021 25:00,1,2,3,4,5\n\n";
+        }
+    }
+
+    IngestLog::Options off;
+    off.level = IngestLog::Level::OFF;
+    EnergyTree seq, par;
+    FileManager::loadCSV(seq, file, off);
+    FileManager::loadCSVParallel(par, file, 3, off);
+
+    NodeStats a = seq.aggregate(0, 4000000000LL), b = par.aggregate(0, 4000000000LL);
+    EXPECT_EQ(a.count, 60000u - 60000u / 7);
+    EXPECT_EQ(b.count, a.count);
+    for (int f = 0; f < FIELD_COUNT; f++) EXPECT_DOUBLE_EQ(b.fields[f].sum, a.fields[f].sum);
+
+    auto it = seq.begin();
+    for (auto jt = par.begin(); jt != par.end(); ++jt, ++it) {
+        ASSERT_TRUE(it != seq.end());
+        ASSERT_EQ(jt.time(), it.time());
+        ASSERT_EQ(jt.value(DataType::PROD), it.value(DataType::PROD));
+    }
+    EXPECT_FALSE(it != seq.end());
+    std::remove(file.c_str());
+}
+
+
+// 27. Test zestawienia wszystkich metryk w jednym przejsciu
+TEST(AnalyzerTest, FusedSummary) {
+    EnergyTree tree;
+    Analyzer an(tree);
+    for (int h = 0; h < 48; h++) {
+        Measurement m;
+        m.timestamp.tm_year = 123; m.timestamp.tm_mon = 6; m.timestamp.tm_mday = 1 + h / 24; m.timestamp.tm_hour = h % 24;
+        m.production = (h % 24 >= 6 && h % 24 < 18) ? 100.0 : 0.0;
+        m.consumption = 40.0 + h % 3;
+        m.autoconsumption = m.production < m.consumption ? m.production : m.consumption;
+        m.exportEnergy = m.production - m.autoconsumption;
+        m.importEnergy = m.consumption - m.autoconsumption;
+        EXPECT_EQ(m.get<DataType::CONS>(), m.consumption);
+        EXPECT_EQ(m.get(DataType::EXPORT), m.exportEnergy);
+        tree.addMeasurement(m);
+    }
+
+    std::tm s = {}, e = {};
+    s.tm_year = 123; s.tm_mon = 6; s.tm_mday = 1;
+    e = s; e.tm_mday = 2; e.tm_hour = 23;
+    Analyzer::Summary sum = an.getSummary(s, e);
+    EXPECT_EQ(sum.count, 48u);
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        DataType type = static_cast<DataType>(f);
+        EXPECT_DOUBLE_EQ(sum.field(type).sum, an.getSum(s, e, type));
+        EXPECT_DOUBLE_EQ(sum.field(type).avg, an.getAvg(s, e, type));
+    }
+    EXPECT_DOUBLE_EQ(sum.field(DataType::PROD).max, 100.0);
+    EXPECT_DOUBLE_EQ(sum.field(DataType::PROD).min, 0.0);
+    EXPECT_DOUBLE_EQ(sum.field(DataType::CONS).max, 42.0);
+
+    double autoSum = sum.field(DataType::AUTO).sum;
+    EXPECT_DOUBLE_EQ(sum.selfConsumption, autoSum / 2400.0);
+    EXPECT_DOUBLE_EQ(sum.selfSufficiency, autoSum / sum.field(DataType::CONS).sum);
+
+    // Pusty przedzial - same zera
+    s.tm_year = 100; e.tm_year = 100;
+    Analyzer::Summary empty = an.getSummary(s, e);
+    EXPECT_EQ(empty.count, 0u);
+    EXPECT_EQ(empty.field(DataType::PROD).max, 0.0);
+    EXPECT_EQ(empty.selfConsumption, 0.0);
+}
+
+// 28. Test petli SIMD - zgodnosc wszystkich wersji oraz wyszukiwania z iteracja
+TEST(SimdKernelsTest, LevelsAgreeAndFindMatchesScan) {
+    std::vector<double> col;
+    for (int i = 0; i < 1003; i++) col.push_back((i * 37 % 101) * 0.1 - 2.0);
+
+    SimdKernels::Level detected = SimdKernels::detect();
+    FieldStats ref, refMasked;
+    std::vector<std::size_t> refHits;
+    SimdKernels::setLevel(SimdKernels::Level::SCALAR);
+    SimdKernels::stats(col.data(), col.size(), ref);
+    SimdKernels::maskedStats(col.data(), 24, 0x00A5F0F1u, refMasked);
+    std::uint32_t refBits = SimdKernels::maskedMatch(col.data(), 24, 0x00FFFFFEu, 1.0, 3.0);
+    SimdKernels::match(col.data(), col.size(), 1.0, 3.0, refHits);
+
+    for (int l = 1; l <= static_cast<int>(detected); l++) {
+        EXPECT_EQ(static_cast<int>(SimdKernels::setLevel(static_cast<SimdKernels::Level>(l))), l);
+        FieldStats a, b;
+        std::vector<std::size_t> hits;
+        SimdKernels::stats(col.data(), col.size(), a);
+        SimdKernels::maskedStats(col.data(), 24, 0x00A5F0F1u, b);
+        SimdKernels::match(col.data(), col.size(), 1.0, 3.0, hits);
+        EXPECT_EQ(a.sum, ref.sum); // Ten sam porzadek sumowania - wynik identyczny co do bitu
+        EXPECT_EQ(a.min, ref.min);
+        EXPECT_EQ(a.max, ref.max);
+        EXPECT_EQ(b.sum, refMasked.sum);
+        EXPECT_EQ(b.max, refMasked.max);
+        EXPECT_EQ(SimdKernels::maskedMatch(col.data(), 24, 0x00FFFFFEu, 1.0, 3.0), refBits);
+        EXPECT_EQ(hits, refHits);
+    }
+    SimdKernels::setLevel(detected);
+
+    double naive = 0;
+    for (double v : col) naive += v;
+    EXPECT_NEAR(ref.sum, naive, 1e-9);
+    EXPECT_DOUBLE_EQ(ref.min, -2.0);
+    EXPECT_DOUBLE_EQ(ref.max, 8.0);
+
+    // Wyszukiwanie w drzewie (sloty siatki i lista nadmiarowa) zgodne z przegladem iteratorem
+    EnergyTree tree;
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 2; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 3000; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 450 + (i % 7 == 0 ? 17 : 0)));
+        m.importEnergy = i % 50;
+        tree.addMeasurement(m);
+    }
+    time_t s = t0 + 3600 + 1, e = t0 + 9 * 86400;
+    std::vector<Measurement> found = tree.find(DataType::IMPORT, 10.0, 12.0, s, e);
+    std::vector<time_t> expected;
+    for (const Measurement& m : tree) {
+        time_t t = m.epochTime();
+        if (t >= s && t <= e && m.importEnergy >= 10.0 && m.importEnergy <= 12.0) expected.push_back(t);
+    }
+    ASSERT_EQ(found.size(), expected.size());
+    for (std::size_t i = 0; i < found.size(); i++) EXPECT_EQ(found[i].epochTime(), expected[i]);
+}
+
+// 29. Test zapytan rownoleglych - wyniki identyczne niezaleznie od liczby watkow
+TEST(AnalyzerTest, ParallelQueriesAreDeterministic) {
+    EnergyTree tree;
+    std::tm day = {};
+    day.tm_year = 121; day.tm_mon = 0; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 3 * 35040; i += 3) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        m.importEnergy = (i * 37 % 1001) * 0.137;
+        m.production = (i % 96) * 0.3;
+        tree.addMeasurement(m);
+    }
+
+    std::tm s = day, e = day;
+    s.tm_mon = 1; s.tm_mday = 14; s.tm_hour = 7;
+    e.tm_year = 123; e.tm_mon = 8; e.tm_mday = 3; e.tm_hour = 16;
+    time_t ts = Measurement::toEpoch(s), te = Measurement::toEpoch(e);
+
+    Analyzer seq(tree);
+    NodeStats ref = tree.aggregate(ts, te);
+    std::vector<Measurement> refFound = tree.find(DataType::IMPORT, 40.0, 45.0, ts, te);
+    ASSERT_FALSE(refFound.empty());
+
+    for (unsigned threads : { 1u, 3u, 8u }) {
+        ThreadPool pool(threads);
+        Analyzer par(tree, &pool);
+        NodeStats st = tree.aggregate(ts, te, &pool);
+        EXPECT_EQ(st.count, ref.count);
+        EXPECT_EQ(st.first, ref.first);
+        EXPECT_EQ(st.last, ref.last);
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            EXPECT_EQ(st.fields[f].sum, ref.fields[f].sum); // Stala kolejnosc laczenia - wynik co do bitu
+            EXPECT_EQ(st.fields[f].min, ref.fields[f].min);
+            EXPECT_EQ(st.fields[f].max, ref.fields[f].max);
+        }
+        EXPECT_EQ(par.getSum(s, e, DataType::PROD), seq.getSum(s, e, DataType::PROD));
+        EXPECT_EQ(par.getAvg(s, e, DataType::IMPORT), seq.getAvg(s, e, DataType::IMPORT));
+
+        std::vector<Measurement> found = tree.find(DataType::IMPORT, 40.0, 45.0, ts, te, &pool);
+        ASSERT_EQ(found.size(), refFound.size());
+        for (std::size_t i = 0; i < found.size(); i++) EXPECT_EQ(found[i].epochTime(), refFound[i].epochTime());
+    }
+}
+
+// 30. Test wyszukiwania z tolerancja - wynik zwracany jako wektor, pomijanie wezli spoza zakresu wartosci
+TEST(AnalyzerTest, SearchReturnsMatches) {
+    EnergyTree tree;
+    Analyzer an(tree);
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 3; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 60 * 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        m.importEnergy = i / 96 * 10.0 + (i % 96) * 0.01; // Kazdy dzien w innym zakresie wartosci
+        tree.addMeasurement(m);
+    }
+
+    std::tm s = day, e = day;
+    e.tm_mon = 5; e.tm_mday = 30; e.tm_hour = 23;
+    std::vector<Measurement> found = an.search(DataType::IMPORT, 250.5, 0.2, s, e);
+    ASSERT_EQ(found.size(), 41u); // Dzien 25: wartosci 250.30 - 250.70
+    EXPECT_EQ(found.front().timestamp.tm_mday, 26);
+    EXPECT_NEAR(found.front().importEnergy, 250.3, 1e-9);
+    for (std::size_t i = 1; i < found.size(); i++) EXPECT_GT(found[i].epochTime(), found[i - 1].epochTime());
+
+    EXPECT_TRUE(an.search(DataType::IMPORT, 5000.0, 1.0, s, e).empty());
+    EXPECT_TRUE(an.search(DataType::PROD, 1.0, 0.5, s, e).empty());
+    EXPECT_EQ(an.search(DataType::PROD, 0.0, 0.0, s, e).size(), 60u * 96u);
+}
+
+// 31. Test doczytywania rosnacego pliku CSV - tylko nowe kompletne linie
+TEST(CsvFollowerTest, PicksUpAppendedLines) {
+    const std::string file = "test_follow.csv";
+    auto row = [](int i) {
+        std::tm t = Measurement::fromEpoch(1700000000 / 900 * 900 + i * 900LL);
+        std::ostringstream os;
+        os << t.tm_mday << "." << t.tm_mon + 1 << "." << t.tm_year + 1900 << " " << t.tm_hour << ":" << (t.tm_min < 10 ? "0" : "") << t.tm_min
+            << ";\"" << i << "\";\"0\";\"1,5\";\"2\";\"3\"";
+        return os.str();
+    };
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        ofs << "\xEF\xBB\xBFTime;Autokonsumpcja;Eksport;Import;Pobor;Produkcja\n";
+        for (int i = 0; i < 100; i++) ofs << row(i) << "\n";
+    }
+
+    EnergyTree tree;
+    CsvFollower follower(file);
+    EXPECT_EQ(follower.poll(tree), 100u);
+    EXPECT_EQ(follower.poll(tree), 0u); // Brak zmian
+    std::uint64_t pos = follower.position();
+
+    std::string partial = row(101);
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::app);
+        ofs << row(100) << "\r\n" << "bledna linia\n" << row(5) << "\n" << partial.substr(0, 10);
+    }
+    EXPECT_EQ(follower.poll(tree), 1u); // Niepelna linia czeka na dokonczenie
+    EXPECT_GT(follower.position(), pos);
+    EXPECT_EQ(follower.invalidCount(), 1u);
+    EXPECT_EQ(follower.duplicateCount(), 1u);
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::app);
+        ofs << partial.substr(10) << "\n";
+    }
+    EXPECT_EQ(follower.poll(tree), 1u);
+    EXPECT_EQ(follower.validCount(), 102u);
+
+    // Agregaty aktualizowane przyrostowo - zgodne z pelnym wczytaniem
+    EnergyTree full;
+    IngestLog::Totals loaded = FileManager::loadCSV(full, file, IngestLog::Options{ IngestLog::Level::OFF, 0 });
+    NodeStats a = tree.aggregate(0, 4000000000LL), b = full.aggregate(0, 4000000000LL);
+    EXPECT_EQ(a.count, b.count);
+    EXPECT_EQ(a.field(DataType::AUTO).sum, b.field(DataType::AUTO).sum);
+    EXPECT_DOUBLE_EQ(a.field(DataType::IMPORT).sum, 102 * 1.5);
+
+    // Doczytywanie po pelnym wczytaniu - tylko linie dopisane za wczytanymi danymi
+    EXPECT_EQ(loaded.consumed, follower.position());
+    EXPECT_EQ(loaded.separator, ';');
+    CsvFollower afterLoad(file);
+    afterLoad.seek(loaded.consumed, loaded.separator);
+    EXPECT_EQ(afterLoad.poll(full), 0u);
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::app);
+        ofs << row(102) << "\n";
+    }
+    EXPECT_EQ(afterLoad.poll(full), 1u);
+    EXPECT_EQ(afterLoad.duplicateCount(), 0u);
+    EXPECT_EQ(afterLoad.invalidCount(), 0u);
+
+    // Plik zastapiony krotszym - czytany od poczatku
+    {
+        std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+        ofs << "Time,A,E,I,P,Pr\n" << "1.1.2030 0:00,1,2,3,4,5\n";
+    }
+    EXPECT_EQ(follower.poll(tree), 1u);
+    std::remove(file.c_str());
+}
+
+// 32. Test pamieci podrecznej wynikow - trafienia i uniewaznianie przez zapis w przedziale
+TEST(AnalyzerTest, ResultCacheInvalidation) {
+    EnergyTree tree;
+    Analyzer an(tree);
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 0; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 90 * 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        m.production = 2.0;
+        tree.addMeasurement(m);
+    }
+
+    std::tm janS = day, janE = day, marS = day, marE = day;
+    janE.tm_mday = 31; janE.tm_hour = 23; janE.tm_min = 45;
+    marS.tm_mon = 2; marE.tm_mon = 2; marE.tm_mday = 31; marE.tm_hour = 23; marE.tm_min = 45;
+
+    EXPECT_DOUBLE_EQ(an.getSum(janS, janE, DataType::PROD), 31 * 96 * 2.0);
+    EXPECT_DOUBLE_EQ(an.getAvg(janS, janE, DataType::PROD), 2.0); // To samo zapytanie, inne pole metryki
+    an.getSummary(marS, marE);
+    EXPECT_EQ(an.cacheMisses(), 2u);
+    EXPECT_EQ(an.cacheHits(), 1u);
+
+    // Zapis w marcu nie uniewaznia wyniku dla stycznia
+    Measurement extra;
+    std::tm t = marS; t.tm_mday = 5; t.tm_min = 7;
+    extra.setTimestamp(t);
+    extra.production = 100.0;
+    EXPECT_TRUE(tree.addMeasurement(extra));
+    an.getSum(janS, janE, DataType::PROD);
+    EXPECT_EQ(an.cacheHits(), 2u);
+    EXPECT_DOUBLE_EQ(an.getSum(marS, marE, DataType::PROD), 31 * 96 * 2.0 + 100.0);
+    EXPECT_EQ(an.cacheMisses(), 3u);
+
+    // Dane w nowym roku w zakresie wielu lat
+    std::tm allE = marE; allE.tm_year = 125;
+    double before = an.getSum(janS, allE, DataType::PROD);
+    Measurement future;
+    std::tm f = day; f.tm_year = 124; f.tm_mon = 6;
+    future.setTimestamp(f);
+    future.production = 1.0;
+    tree.addMeasurement(future);
+    EXPECT_DOUBLE_EQ(an.getSum(janS, allE, DataType::PROD), before + 1.0);
+
+    // Duplikat niczego nie zmienia, wyczyszczenie drzewa uniewaznia wszystko
+    std::size_t hits = an.cacheHits();
+    EXPECT_FALSE(tree.addMeasurement(extra));
+    an.getSum(marS, marE, DataType::PROD);
+    EXPECT_EQ(an.cacheHits(), hits + 1);
+    tree.clear();
+    EXPECT_EQ(an.getSum(janS, janE, DataType::PROD), 0.0);
+
+    // Ograniczona pojemnosc - najdawniej uzyty wpis jest usuwany
+    an.setCacheCapacity(1);
+    an.getSum(janS, janE, DataType::PROD);
+    an.getSum(marS, marE, DataType::PROD);
+    std::size_t misses = an.cacheMisses();
+    an.getSum(janS, janE, DataType::PROD);
+    EXPECT_EQ(an.cacheMisses(), misses + 1);
+}
+
+// 33. Test szeregow zagregowanych - zgodnosc z agregatami i wybor rozdzielczosci
+TEST(AnalyzerTest, RollupSeriesAndPointBudget) {
+    EnergyTree tree;
+    Analyzer an(tree);
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 0; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 365 * 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        m.production = (i / 4) % 24;
+        m.consumption = 1.0;
+        tree.addMeasurement(m);
+    }
+    Measurement off; // Pomiar spoza siatki 15-minutowej
+    off.setTimestamp(Measurement::fromEpoch(t0 + 10 * 3600 + 7 * 60));
+    off.production = 100.0;
+    tree.addMeasurement(off);
+
+    std::tm yearE = day;
+    yearE.tm_mon = 11; yearE.tm_mday = 31; yearE.tm_hour = 23; yearE.tm_min = 45;
+    auto months = an.getSeries(day, yearE, Resolution::MONTH);
+    ASSERT_EQ(months.size(), 12u);
+    std::tm febS = day, febE = day;
+    febS.tm_mon = 1; febE.tm_mon = 1; febE.tm_mday = 28; febE.tm_hour = 23; febE.tm_min = 45;
+    EXPECT_EQ(months[1].start, Measurement::toEpoch(febS));
+    EXPECT_EQ(months[1].stats.count, 28u * 96);
+    EXPECT_DOUBLE_EQ(months[1].stats.field(DataType::PROD).sum, an.getSum(febS, febE, DataType::PROD));
+    EXPECT_EQ(an.getSeries(day, yearE, Resolution::DAY).size(), 365u);
+
+    // Kubelki godzinowe pierwszej doby, z brzegiem przedzialu w polowie godziny
+    std::tm s = day, e = day;
+    s.tm_hour = 9; s.tm_min = 30; e.tm_hour = 12;
+    auto hours = an.getSeries(s, e, Resolution::HOUR);
+    ASSERT_EQ(hours.size(), 4u);
+    EXPECT_EQ(hours[0].start, t0 + 9 * 3600);
+    EXPECT_EQ(hours[0].stats.count, 2u);
+    EXPECT_EQ(hours[1].stats.count, 5u);
+    EXPECT_DOUBLE_EQ(hours[1].stats.field(DataType::PROD).max, 100.0);
+    EXPECT_DOUBLE_EQ(hours[2].stats.field(DataType::PROD).sum, 4 * 11.0);
+    EXPECT_EQ(hours[3].stats.count, 1u);
+    EXPECT_EQ(an.getSeries(s, e, Resolution::RAW).size(), 2u + 5 + 4 + 1);
+
+    // Najdrobniejsza rozdzielczosc mieszczaca sie w budzecie punktow
+    std::tm threeDays = day;
+    threeDays.tm_mday = 3; threeDays.tm_hour = 23;
+    EXPECT_EQ(an.pickResolution(day, threeDays, 1000), Resolution::RAW);
+    EXPECT_EQ(an.pickResolution(day, threeDays, 100), Resolution::HOUR);
+    EXPECT_EQ(an.pickResolution(day, yearE, 500), Resolution::DAY);
+    EXPECT_EQ(an.pickResolution(day, yearE, 100), Resolution::MONTH);
+    EXPECT_LE(an.getSeries(day, yearE, 500).size(), 500u);
+}
+
+// 34. Test instrumentacji - liczniki, histogramy, ksztalt drzewa i eksport
+TEST(MetricsTest, CountersAndDump) {
+    if (!Metrics::ENABLED) GTEST_SKIP() << "Zbudowano z P06_NO_METRICS";
+    Metrics::reset();
+    EnergyTree tree;
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 4; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    for (int i = 0; i < 2 * 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        tree.addMeasurement(m);
+    }
+    Measurement dup;
+    dup.setTimestamp(day);
+    EXPECT_FALSE(tree.addMeasurement(dup));
+    Measurement off;
+    off.setTimestamp(Measurement::fromEpoch(t0 + 7 * 60));
+    tree.addMeasurement(off);
+
+    std::tm s = day, e = day;
+    s.tm_hour = 3; e.tm_mday = 2; e.tm_hour = 20;
+    tree.aggregate(Measurement::toEpoch(s), Measurement::toEpoch(e));
+    std::size_t seen = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) seen++;
+    EXPECT_EQ(seen, 2u * 96 + 1);
+
+    Metrics::Snapshot st = Metrics::stats(&tree);
+    EXPECT_EQ(st.counter(Metrics::Counter::MEASUREMENTS_ADDED), 2u * 96 + 1);
+    EXPECT_EQ(st.counter(Metrics::Counter::DUPLICATES), 1u);
+    EXPECT_EQ(st.counter(Metrics::Counter::QUERIES), 1u);
+    EXPECT_EQ(st.counter(Metrics::Counter::BLOCKS_SCANNED), 2u); // Tylko dwa bloki brzegowe
+    EXPECT_EQ(st.counter(Metrics::Counter::ITERATOR_BLOCKS), 8u);
+    EXPECT_EQ(st.histogram(Metrics::Histogram::QUERY_NS).count, 1u);
+    // Co SAMPLE_EVERY-te z 194 wywolan (licznik probkowania jest wspolny dla watku)
+    EXPECT_GE(st.histogram(Metrics::Histogram::ADD_NS).count, 194u / Metrics::SAMPLE_EVERY);
+    EXPECT_LE(st.histogram(Metrics::Histogram::ADD_NS).count, 194u / Metrics::SAMPLE_EVERY + 1);
+    EXPECT_EQ(st.shape.years, 1u);
+    EXPECT_EQ(st.shape.days, 2u);
+    EXPECT_EQ(st.shape.leaves, 8u);
+    EXPECT_EQ(st.shape.overflow, 1u);
+    ASSERT_EQ(st.shape.leafSizes.size(), 26u);
+    EXPECT_EQ(st.shape.leafSizes[24], 7u);
+    EXPECT_EQ(st.shape.leafSizes[25], 1u);
+
+    // Linie odrzucone wg powodu pochodza z dziennika importu
+    const std::string file = "test_metrics.csv";
+    {
+        std::ofstream out(file);
+        out << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobor (W),Produkcja (W)\n"
+            << "01.06.2023 0:00,\"1\",\"0\",\"2\",\"3\",\"1\"\n"
+            << "01.06.2023 0:15,\"x\",\"0\",\"2\",\"3\",\"1\"\n"
+            << "01.06.2023 0:00,\"1\",\"0\",\"2\",\"3\",\"1\"\n";
+    }
+    FileManager::loadCSV(tree, file, IngestLog::Options{ IngestLog::Level::OFF });
+    std::remove(file.c_str());
+    st = Metrics::stats();
+    EXPECT_EQ(st.counter(Metrics::Counter::CSV_LINES_OK), 1u);
+    EXPECT_EQ(st.counter(Metrics::Counter::CSV_LINES_REJECTED), 2u);
+    EXPECT_EQ(st.rejected.at(CsvParser::ERR_NUMBER), 1u);
+    EXPECT_GT(st.counter(Metrics::Counter::BYTES_READ), 100u);
+    EXPECT_FALSE(st.hasTree);
+
+    std::string json = Metrics::format(Metrics::stats(&tree), Metrics::Format::JSON);
+    EXPECT_NE(json.find("\"measurements_added\": 194"), std::string::npos);
+    EXPECT_NE(json.find("\"leaves\": 9"), std::string::npos);
+    std::string prom = Metrics::format(Metrics::stats(&tree), Metrics::Format::PROMETHEUS);
+    EXPECT_NE(prom.find("p06_duplicates_total 2\n"), std::string::npos);
+    EXPECT_NE(prom.find("p06_query_ns_count 1\n"), std::string::npos);
+    EXPECT_NE(prom.find("p06_tree_nodes{level=\"block\"} 9\n"), std::string::npos);
+    Metrics::reset();
+    EXPECT_EQ(Metrics::stats().counter(Metrics::Counter::MEASUREMENTS_ADDED), 0u);
+}
+
+// 35. Test areny drzewa - wszystkie poziomy alokowane z areny, czyszczenie i przenoszenie drzewa
+TEST(EnergyTreeTest, ArenaAllocation) {
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 0; day.tm_mday = 31;
+    time_t t0 = Measurement::toEpoch(day);
+    std::vector<Measurement> batch;
+    for (int i = 0; i < 3 * 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL + (i % 10 == 0 ? 60 : 0))); // Czesc pomiarow spoza siatki
+        m.production = i;
+        batch.push_back(m);
+    }
+
+    EnergyTree tree;
+    {
+        // Alokacja z domyslnego zasobu pmr (np. mapa lub kolumna poza arena) zglosilaby std::bad_alloc
+        std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        EXPECT_NO_THROW(tree.bulkLoad(batch));
+        EXPECT_NO_THROW(for (const Measurement& m : batch) tree.addMeasurement(m));
+        std::pmr::set_default_resource(previous);
+    }
+    NodeStats before = tree.totals();
+    EXPECT_EQ(before.count, batch.size());
+    EXPECT_EQ(tree.shape().overflow, batch.size() / 10 + 1);
+
+    // Po wyczyszczeniu drzewo jest puste, a ponowne wczytanie daje te same agregaty
+    std::uint64_t epoch = tree.epoch();
+    tree.clear();
+    EXPECT_EQ(tree.totals().count, 0u);
+    EXPECT_FALSE(tree.begin() != tree.end());
+    EXPECT_FALSE(tree.unchangedSince(t0, t0 + 86400, epoch));
+    tree.bulkLoad(batch);
+    EXPECT_EQ(tree.totals().count, before.count);
+    EXPECT_DOUBLE_EQ(tree.totals().field(DataType::PROD).sum, before.field(DataType::PROD).sum);
+
+    // Przeniesienie przejmuje arene (bez kopiowania wezlow)
+    std::vector<EnergyTree> trees;
+    trees.push_back(std::move(tree));
+    trees.emplace_back();
+    trees[1] = std::move(trees[0]);
+    EXPECT_EQ(trees[1].totals().count, before.count);
+    EXPECT_EQ(trees[1].aggregate(t0, t0 + 86400 - 1).count, 96u);
+    std::size_t seen = 0;
+    for (auto it = trees[1].begin(); it != trees[1].end(); ++it) seen++;
+    EXPECT_EQ(seen, batch.size());
+
+    // Przypisanie drzewa z mniejsza liczba zapisow uniewaznia wyniki zapamietane przez Analyzer
+    EnergyTree target, smaller;
+    for (int i = 0; i < 96; i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL));
+        m.production = 1;
+        target.addMeasurement(m);
+        if (i < 10) {
+            m.production = 100;
+            smaller.addMeasurement(m);
+        }
+    }
+    Analyzer an(target);
+    std::tm s = Measurement::fromEpoch(t0), e = Measurement::fromEpoch(t0 + 86400 - 1);
+    EXPECT_DOUBLE_EQ(an.getSum(s, e, DataType::PROD), 96.0);
+    target = std::move(smaller);
+    EXPECT_DOUBLE_EQ(an.getSum(s, e, DataType::PROD), 1000.0);
+}
+
+// 36. Test migawek - zapytania rownolegle z wczytywaniem widza spojne, niezmienne dane
+TEST(SnapshotTreeTest, ConcurrentReadsDuringIngestion) {
+    std::tm day = {};
+    day.tm_year = 123; day.tm_mon = 2; day.tm_mday = 1;
+    time_t t0 = Measurement::toEpoch(day);
+    const int DAYS = 60;
+
+    SnapshotTree store;
+    EXPECT_EQ(store.snapshot()->totals().count, 0u);
+
+    // Migawka trzymana przez czytelnika nie zmienia sie po publikacji
+    Measurement first;
+    first.setTimestamp(day);
+    store.add(first);
+    EXPECT_TRUE(store.publish());
+    std::shared_ptr<const EnergyTree> held = store.snapshot();
+    store.add(Measurement(first)); // Duplikat - odrzucany w obu replikach
+    Measurement second;
+    second.setTimestamp(Measurement::fromEpoch(t0 + 900));
+    store.add(second);
+    EXPECT_TRUE(store.publish());  // Druga replika jest wolna
+    EXPECT_EQ(held->totals().count, 1u);
+    EXPECT_EQ(store.snapshot()->totals().count, 2u);
+    Measurement third;
+    third.setTimestamp(Measurement::fromEpoch(t0 + 1800));
+    store.add(third);
+    EXPECT_FALSE(store.publish()); // Replika z held jest czytana - pomiar czeka w kolejce
+    EXPECT_EQ(store.pending(), 1u);
+    held.reset();
+    EXPECT_TRUE(store.publish());
+    EXPECT_EQ(store.pending(), 0u);
+    EXPECT_EQ(store.snapshot()->totals().count, 3u);
+
+    // Pisarz dopisuje dzien po dniu, czytelnicy sprawdzaja spojnosc kazdej migawki
+    std::atomic<bool> done{ false };
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&]() {
+            std::size_t last = 0;
+            while (!done.load()) {
+                std::shared_ptr<const EnergyTree> snap = store.snapshot();
+                Analyzer analyzer(*snap);
+                std::size_t n = snap->totals().count;
+                std::size_t seen = 0;
+                for (auto it = snap->begin(); it != snap->end(); ++it) seen++;
+                std::size_t daily = 0;
+                for (const SeriesPoint& p : analyzer.getSeries(day, Measurement::fromEpoch(t0 + DAYS * 86400LL), Resolution::DAY)) daily += p.stats.count;
+                if (seen != n || daily != n || n < last || snap->totals().count != n) failures++;
+                last = n;
+            }
+        });
+    }
+    for (int d = 1; d < DAYS; d++) {
+        std::vector<Measurement> batch;
+        for (int i = 0; i < 96; i++) {
+            Measurement m;
+            m.setTimestamp(Measurement::fromEpoch(t0 + d * 86400LL + i * 900LL));
+            m.production = i;
+            batch.push_back(m);
+        }
+        store.add(batch);
+        store.publish();
+    }
+    while (!store.publish()) std::this_thread::yield();
+    done = true;
+    for (std::thread& t : readers) t.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(store.snapshot()->totals().count, 3u + (DAYS - 1) * 96u);
+}
+
+
+// 37. Test porownan zbiorczych - jedno przejscie zgodne z osobnymi zapytaniami, rok do roku
+TEST(AnalyzerTest, BatchPeriodComparison) {
+    EnergyTree tree;
+    Analyzer an(tree);
+    std::tm s = {};
+    s.tm_year = 122; s.tm_mon = 2; s.tm_mday = 1; // Dane od marca 2022 do konca 2023
+    time_t t0 = Measurement::toEpoch(s);
+    std::tm e = s;
+    e.tm_year = 124; e.tm_mon = 0;
+    time_t t1 = Measurement::toEpoch(e);
+    int i = 0;
+    for (time_t t = t0; t < t1; t += 3600, i++) {
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(i % 5 == 0 ? t + 420 : t)); // Czesc pomiarow poza siatka
+        m.production = i % 17;
+        m.consumption = 3 + i % 7;
+        m.importEnergy = i % 4;
+        tree.addMeasurement(m);
+    }
+
+    // Przedzialy nakladajace sie, powtorzone, odwrocone, tnace bloki i poza danymi
+    std::vector<std::pair<time_t, time_t>> ranges = {
+        { t0, t1 }, { t0 + 1000, t0 + 86400 * 40 + 77 }, { t0 + 1000, t0 + 86400 * 40 + 77 },
+        { t0 + 86400 * 30, t0 + 86400 * 400 }, { t0 + 5000, t0 + 4000 }, { t0 - 86400 * 50, t0 - 1 },
+        { t0 + 86400 * 399 + 123, t0 + 86400 * 399 + 5000 }, { t1 - 86400 * 3, t1 + 86400 * 10 } };
+    std::vector<NodeStats> batch = tree.aggregateMany(ranges);
+    ASSERT_EQ(batch.size(), ranges.size());
+    for (std::size_t k = 0; k < ranges.size(); k++) {
+        NodeStats single = tree.aggregate(ranges[k].first, ranges[k].second);
+        EXPECT_EQ(batch[k].count, single.count) << k;
+        if (single.count == 0) continue;
+        EXPECT_EQ(batch[k].first, single.first) << k;
+        EXPECT_EQ(batch[k].last, single.last) << k;
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            EXPECT_DOUBLE_EQ(batch[k].fields[f].sum, single.fields[f].sum) << k;
+            EXPECT_EQ(batch[k].fields[f].min, single.fields[f].min) << k;
+            EXPECT_EQ(batch[k].fields[f].max, single.fields[f].max) << k;
+        }
+    }
+    EXPECT_TRUE(tree.aggregateMany({}).empty());
+
+    // Rok do roku: kazde porownanie zgodne z getSum obu okresow
+    std::vector<Analyzer::Comparison> items = Analyzer::yearOverYear(2023);
+    ASSERT_EQ(items.size(), 12u * FIELD_COUNT);
+    std::vector<Analyzer::ComparisonResult> results = an.compareMany(items);
+    ASSERT_EQ(results.size(), items.size());
+    for (std::size_t k = 0; k < items.size(); k++) {
+        const Analyzer::Comparison& c = items[k];
+        const Analyzer::ComparisonResult& r = results[k];
+        EXPECT_EQ(c.start.tm_mon, c.baseStart.tm_mon);
+        EXPECT_EQ(c.start.tm_year, c.baseStart.tm_year + 1);
+        EXPECT_EQ(r.type, c.type);
+        EXPECT_DOUBLE_EQ(r.value, an.getSum(c.start, c.end, c.type));
+        EXPECT_DOUBLE_EQ(r.baseline, an.getSum(c.baseStart, c.baseEnd, c.type));
+        EXPECT_DOUBLE_EQ(r.difference, r.value - r.baseline);
+        if (r.baseline != 0) { EXPECT_DOUBLE_EQ(r.relative, r.difference / r.baseline); }
+    }
+
+    // Styczen 2023: pelny miesiac; styczen 2022 bez danych - roznica wzgledna 0
+    const Analyzer::ComparisonResult& jan = results[static_cast<int>(DataType::PROD)];
+    EXPECT_EQ(jan.count, 31u * 24u);
+    EXPECT_EQ(jan.baselineCount, 0u);
+    EXPECT_EQ(jan.relative, 0.0);
+    const Analyzer::ComparisonResult& dec = results[11 * FIELD_COUNT + static_cast<int>(DataType::CONS)];
+    EXPECT_EQ(dec.count, 31u * 24u);
+    EXPECT_EQ(dec.baselineCount, 31u * 24u);
+    EXPECT_EQ(items[11 * FIELD_COUNT].end.tm_mday, 31);
+    EXPECT_EQ(items[1 * FIELD_COUNT].end.tm_mday, 28);
+}
+
+// 38. Test szkicow kwantyli - blad wzgledny wzgledem sortowania, laczenie i zgodnosc addMeasurement z bulkLoad
+TEST(AnalyzerTest, PercentilesFromNodeSketches) {
+    // Laczenie szkicow daje ten sam szkic, co wstawienie wszystkich wartosci
+    QuantileSketch whole, left, right, empty;
+    for (int i = 0; i < 2000; i++) {
+        double v = (i * 7919 % 1000) * 1.37 - 100.0;
+        whole.add(v);
+        (i % 3 ? left : right).add(v);
+    }
+    left.merge(right);
+    left.merge(empty);
+    EXPECT_EQ(left.count(), whole.count());
+    EXPECT_EQ(left.size(), whole.size());
+    for (double q = 0; q <= 1.0; q += 0.05) EXPECT_EQ(left.quantile(q), whole.quantile(q));
+    EXPECT_EQ(whole.quantile(0), -100.0);
+    EXPECT_EQ(empty.quantile(0.5), 0.0);
+
+    EnergyTree tree, bulk;
+    Analyzer an(tree);
+    std::tm s = {};
+    s.tm_year = 122; s.tm_mon = 10; s.tm_mday = 3;
+    time_t t0 = Measurement::toEpoch(s);
+    std::vector<Measurement> batch;
+    std::uint32_t seed = 12345;
+    for (int i = 0; i < 96 * 100; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        Measurement m;
+        m.setTimestamp(Measurement::fromEpoch(t0 + i * 900LL + (i % 11 == 0 ? 61 : 0))); // Czesc poza siatka
+        m.importEnergy = (seed >> 8) % 7 == 0 ? 0.0 : ((seed >> 8) % 50000) / 10.0;
+        m.consumption = 200.0 + (i % 96) * 12.5;
+        tree.addMeasurement(m);
+        batch.push_back(m);
+    }
+    bulk.bulkLoad(batch);
+
+    const double qs[] = { 0.0, 0.01, 0.5, 0.9, 0.95, 0.99, 1.0 };
+    const std::pair<time_t, time_t> ranges[] = {
+        { t0, t0 + 100 * 86400LL }, { t0 + 3 * 86400LL + 5000, t0 + 64 * 86400LL + 777 }, { t0 + 4000, t0 + 20000 } };
+    for (const auto& [start, end] : ranges) {
+        for (DataType type : { DataType::IMPORT, DataType::CONS }) {
+            std::vector<double> exact;
+            for (const Measurement& m : tree.range(Measurement::fromEpoch(start), Measurement::fromEpoch(end))) exact.push_back(m.get(type));
+            ASSERT_FALSE(exact.empty());
+            std::sort(exact.begin(), exact.end());
+            QuantileSketch sk = tree.sketch(type, start, end);
+            EXPECT_EQ(sk.count(), exact.size());
+            QuantileSketch other = bulk.sketch(type, start, end);
+            for (double q : qs) {
+                double want = exact[static_cast<std::size_t>(q * (exact.size() - 1))];
+                double got = an.getPercentile(Measurement::fromEpoch(start), Measurement::fromEpoch(end), type, q);
+                EXPECT_NEAR(got, want, QuantileSketch::RELATIVE_ERROR * std::fabs(want) + QuantileSketch::MIN_MAGNITUDE) << q;
+                EXPECT_EQ(got, sk.quantile(q));
+                EXPECT_EQ(got, other.quantile(q));
+            }
+        }
+    }
+
+    std::vector<double> p = an.getPercentiles(s, Measurement::fromEpoch(t0 + 100 * 86400LL), DataType::IMPORT, { 0.5, 0.95, 0.99 });
+    ASSERT_EQ(p.size(), 3u);
+    EXPECT_LE(p[0], p[1]);
+    EXPECT_LE(p[1], p[2]);
+    s.tm_year = 100;
+    EXPECT_EQ(an.getPercentile(s, s, DataType::IMPORT, 0.5), 0.0);
+}
+
+// 39. Test magazynu wielu licznikow - wczytywanie tylko wybranych licznikow, sumy floty i ranking
+TEST(MeterStoreTest, FleetTotalsAndRankingOverSelectedMeters) {
+    const std::string ids[] = { "pv_a", "pv_b", "pv_c" };
+    const time_t t0 = 1700000000 / 900 * 900;
+    for (int k = 0; k < 3; k++) {
+        std::ofstream ofs("test_meter_" + ids[k] + ".csv", std::ios::binary);
+        ofs << "Time;Autokonsumpcja;Eksport;Import;Pobor;Produkcja\n";
+        for (int i = 0; i < 96 * 3; i++) {
+            std::tm t = Measurement::fromEpoch(t0 + i * 900LL);
+            ofs << t.tm_mday << "." << t.tm_mon + 1 << "." << t.tm_year + 1900 << " " << t.tm_hour << ":" << (t.tm_min < 10 ? "0" : "") << t.tm_min
+                << ";\"1\";\"0\";\"" << k + 1 << "\";\"2\";\"" << (k == 1 ? 30 : 10 * k + 5) << "\"\n";
+        }
+    }
+
+    MeterStore store;
+    store.setLogOptions(IngestLog::Options{ IngestLog::Level::OFF });
+    for (const std::string& id : ids) store.addMeter(id, "test_meter_" + id + ".csv");
+    EXPECT_EQ(store.size(), 3u);
+    EXPECT_EQ(store.loadedCount(), 0u);
+
+    // Zapytanie wczytuje tylko wybrane liczniki; nieznane i powtorzone sa pomijane
+    std::tm s = Measurement::fromEpoch(t0), e = Measurement::fromEpoch(t0 + 2 * 86400LL - 1);
+    NodeStats fleet = store.aggregate({ "pv_b", "pv_c", "pv_b", "brak" }, t0, t0 + 2 * 86400LL - 1);
+    EXPECT_EQ(store.loadedCount(), 2u);
+    EXPECT_FALSE(store.isLoaded("pv_a"));
+    EXPECT_EQ(fleet.count, 2u * 192u);
+    EXPECT_DOUBLE_EQ(fleet.field(DataType::IMPORT).sum, 192.0 * (2 + 3));
+    EXPECT_EQ(fleet.field(DataType::PROD).max, 30.0);
+
+    // Zgodnosc z osobnymi drzewami
+    EnergyTree single;
+    IngestLog::Totals loaded = FileManager::loadCSV(single, "test_meter_pv_c.csv", IngestLog::Options{ IngestLog::Level::OFF });
+    EXPECT_TRUE(loaded.opened);
+    EXPECT_EQ(loaded.valid, 96u * 3);
+    EXPECT_EQ(loaded.invalid, 0u);
+    EXPECT_FALSE(FileManager::loadCSV(single, "test_meter_brak.csv", IngestLog::Options{ IngestLog::Level::OFF }).opened);
+    NodeStats c = single.aggregate(t0, t0 + 2 * 86400LL - 1);
+    EXPECT_EQ(store.aggregate({ "pv_c" }, t0, t0 + 2 * 86400LL - 1).field(DataType::PROD).sum, c.field(DataType::PROD).sum);
+
+    Analyzer::Summary summary = store.getSummary({ "pv_a", "pv_b", "pv_c" }, s, e);
+    EXPECT_EQ(store.loadedCount(), 3u);
+    EXPECT_EQ(summary.count, 3u * 192u);
+    EXPECT_DOUBLE_EQ(summary.field(DataType::CONS).avg, 2.0);
+
+    // Ranking malejaco, rowne sumy wg identyfikatora; wynik z pula watkow taki sam
+    std::vector<MeterStore::SiteValue> ranking = store.rank({ "pv_a", "pv_b", "pv_c" }, s, e, DataType::PROD);
+    ASSERT_EQ(ranking.size(), 3u);
+    EXPECT_EQ(ranking[0].meter, "pv_b");
+    EXPECT_EQ(ranking[1].meter, "pv_c");
+    EXPECT_EQ(ranking[2].meter, "pv_a");
+    EXPECT_DOUBLE_EQ(ranking[2].value, 192.0 * 5);
+    EXPECT_EQ(ranking[0].count, 192u);
+
+    ThreadPool pool(3);
+    store.setThreadPool(&pool);
+    std::vector<MeterStore::SiteValue> top = store.rank({ "pv_a", "pv_b", "pv_c" }, s, e, DataType::PROD, 2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].meter, "pv_b");
+    EXPECT_EQ(top[1].meter, "pv_c");
+    NodeStats parallel = store.aggregate({ "pv_b", "pv_c" }, t0, t0 + 2 * 86400LL - 1);
+    EXPECT_EQ(parallel.count, fleet.count);
+    EXPECT_EQ(parallel.field(DataType::IMPORT).sum, fleet.field(DataType::IMPORT).sum);
+
+    // Zwolnienie i ponowne wczytanie (rownolegle) przy zapytaniu
+    store.unload("pv_a");
+    store.unload("pv_c");
+    EXPECT_EQ(store.loadedCount(), 1u);
+    EXPECT_EQ(store.aggregate({ "pv_a", "pv_c" }, t0, t0 + 3 * 86400LL).count, 2u * 288u);
+    EXPECT_EQ(store.loadedCount(), 3u);
+
+    // Licznik bez pliku - dane dodawane bezposrednio
+    Measurement m;
+    m.setTimestamp(Measurement::fromEpoch(t0));
+    m.production = 10000;
+    EXPECT_TRUE(store.tree("pv_d").addMeasurement(m));
+    EXPECT_EQ(store.rank({ "pv_a", "pv_b", "pv_c", "pv_d" }, s, e, DataType::PROD, 1).front().meter, "pv_d");
+
+    // Licznik z brakujacym plikiem nie jest wczytywany ani uwzgledniany w rankingu
+    store.addMeter("pv_e", "test_meter_pv_e.csv");
+    EXPECT_EQ(store.load({ "pv_e" }), 0u);
+    EXPECT_EQ(store.load({ "pv_a", "pv_e" }), 0u);
+    EXPECT_FALSE(store.isLoaded("pv_e"));
+    std::vector<MeterStore::SiteValue> withMissing = store.rank({ "pv_a", "pv_e" }, s, e, DataType::PROD);
+    ASSERT_EQ(withMissing.size(), 1u);
+    EXPECT_EQ(withMissing[0].meter, "pv_a");
+    store.unload("pv_a");
+    EXPECT_EQ(store.load({ "pv_a", "pv_e" }), 1u);
+    EXPECT_TRUE(store.isLoaded("pv_a"));
+    EXPECT_FALSE(store.isLoaded("pv_e"));
+
+    for (const std::string& id : ids) std::remove(("test_meter_" + id + ".csv").c_str());
+}
+
+// 40. Test typu danych spoza DataType - puste statystyki zamiast odczytu poza tablica
+TEST(AnalyzerTest, OutOfRangeTypeGivesZero) {
+    EnergyTree tree;
+    Measurement m;
+    m.setTimestamp(Measurement::fromEpoch(1700000000 / 900 * 900));
+    m.production = 5;
+    m.consumption = 7;
+    tree.addMeasurement(m);
+
+    NodeStats stats = tree.totals();
+    EXPECT_EQ(stats.field(static_cast<DataType>(FIELD_COUNT)).sum, 0.0);
+    EXPECT_EQ(stats.field(static_cast<DataType>(-1)).sum, 0.0);
+    EXPECT_EQ(stats.field(DataType::PROD).sum, 5.0);
+    EXPECT_EQ(m.get(static_cast<DataType>(FIELD_COUNT)), 0.0);
+    EXPECT_EQ(m.get(DataType::PROD), 5.0);
+
+    Analyzer an(tree);
+    EXPECT_EQ(an.getSum(m.timestamp, m.timestamp, static_cast<DataType>(7)), 0.0);
+    EXPECT_EQ(an.getAvg(m.timestamp, m.timestamp, static_cast<DataType>(7)), 0.0);
+    EXPECT_EQ(an.getPercentile(m.timestamp, m.timestamp, static_cast<DataType>(7), 0.5), 0.0);
+    EXPECT_EQ(an.getPercentile(m.timestamp, m.timestamp, static_cast<DataType>(-1), 0.5), 0.0);
+    EXPECT_EQ(an.getPercentiles(m.timestamp, m.timestamp, static_cast<DataType>(7), { 0.1, 0.9 }), std::vector<double>(2, 0.0));
+    EXPECT_EQ(tree.sketch(static_cast<DataType>(FIELD_COUNT), 0, 2000000000).count(), 0u);
+    EXPECT_EQ(an.getPercentile(m.timestamp, m.timestamp, DataType::PROD, 0.5), tree.sketch(DataType::PROD, 0, 2000000000).quantile(0.5));
+    EXPECT_TRUE(an.search(static_cast<DataType>(40), 0, 1e9, m.timestamp, m.timestamp).empty());
+    EXPECT_TRUE(an.search(static_cast<DataType>(-1), 0, 1e9, m.timestamp, m.timestamp).empty());
+    EXPECT_EQ(an.search(DataType::PROD, 5, 0, m.timestamp, m.timestamp).size(), 1u);
+}